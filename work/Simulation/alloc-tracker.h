@@ -0,0 +1,367 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+/**
+ * @file
+ * Process-wide allocation counters.
+ *
+ * This header replaces the global operator new/delete of the program, so it must be included
+ * by exactly one translation unit: the one holding main(). The counters are relaxed atomics,
+ * cheap enough to stay enabled in every run.
+ *
+ * The call stacks of one allocation in every N can also be sampled (AllocationSampler), to
+ * find the sites responsible for the allocations. This is opt-in.
+ *
+ * While a SlotArena tier is set on the calling thread (see slot-arena-scheduler.h), small
+ * allocations are served by the arena instead of malloc(); they are counted all the same.
+ */
+
+#include "slot-arena.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __GLIBC__
+#include <execinfo.h>
+#include <malloc.h>
+#endif
+
+namespace ns3
+{
+
+/**
+ * @brief Allocation counters updated by the replaced global operator new.
+ */
+struct AllocationCounters
+{
+    std::atomic<uint64_t> allocations{0}; //!< Calls to operator new
+    std::atomic<uint64_t> bytes{0};       //!< Bytes requested from operator new
+    std::atomic<int64_t> liveBytes{0};    //!< Bytes currently allocated, 0 if unknown
+};
+
+/// Counters of the whole process
+inline AllocationCounters g_allocationCounters;
+
+/**
+ * @return the number of operator new calls so far
+ */
+inline uint64_t
+GetAllocationCount()
+{
+    return g_allocationCounters.allocations.load(std::memory_order_relaxed);
+}
+
+/**
+ * @return the number of bytes requested from operator new so far
+ */
+inline uint64_t
+GetAllocatedBytes()
+{
+    return g_allocationCounters.bytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @return the bytes currently allocated through operator new, including allocator rounding;
+ *         always 0 if the C library cannot tell the size of a block
+ */
+inline int64_t
+GetLiveBytes()
+{
+    return g_allocationCounters.liveBytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Call stack sampled at an allocation, and the allocations seen from it.
+ */
+struct AllocationSite
+{
+    static constexpr int MAX_FRAMES = 16; //!< Frames kept per stack
+
+    uint64_t hash{0};           //!< Hash of the frames, 0 for a free slot
+    int depth{0};               //!< Number of valid frames
+    void* frames[MAX_FRAMES]{}; //!< Return addresses, innermost first
+    uint64_t samples{0};        //!< Sampled allocations from this stack
+    uint64_t bytes{0};          //!< Bytes of the sampled allocations
+};
+
+/**
+ * @brief Samples the call stack of one allocation in every N.
+ *
+ * The stacks go to a fixed-size hash table allocated with calloc(), so sampling never calls
+ * operator new itself. Sampled counts are scaled by the period when reported.
+ */
+class AllocationSampler
+{
+  public:
+    /// Capacity of the stack table; stacks beyond it are counted as dropped
+    static constexpr uint32_t TABLE_SIZE = 1 << 14;
+
+    /**
+     * @brief Start sampling.
+     * @param period sample one allocation in every period
+     * @return false if stacks cannot be sampled on this platform
+     */
+    bool Enable(uint32_t period)
+    {
+#ifdef __GLIBC__
+        if (m_sites == nullptr)
+        {
+            m_sites = static_cast<AllocationSite*>(std::calloc(TABLE_SIZE, sizeof(AllocationSite)));
+            // The first backtrace() loads the unwinder, which allocates
+            void* frames[2];
+            backtrace(frames, 2);
+        }
+        m_period = period > 0 ? period : 1;
+        m_enabled.store(m_sites != nullptr, std::memory_order_relaxed);
+        return m_sites != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Stop sampling; the sampled stacks remain available.
+     */
+    void Disable()
+    {
+        m_enabled.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return whether sampling is enabled
+     */
+    bool IsEnabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return the sampling period
+     */
+    uint32_t GetPeriod() const
+    {
+        return m_period;
+    }
+
+    /**
+     * @return the stack table, TABLE_SIZE entries of which those with a non-zero hash are used;
+     *         nullptr if sampling was never enabled
+     */
+    const AllocationSite* GetSites() const
+    {
+        return m_sites;
+    }
+
+    /**
+     * @return samples whose stack did not fit in the table
+     */
+    uint64_t GetDropped() const
+    {
+        return m_dropped;
+    }
+
+    /**
+     * @brief Count an allocation, sampling its stack if it is the period-th one.
+     * @param size requested size
+     */
+    [[gnu::noinline]] void OnAllocation(std::size_t size) noexcept
+    {
+#ifdef __GLIBC__
+        thread_local uint32_t countdown = 0;
+        thread_local bool inSampler = false;
+        if (inSampler || countdown-- > 0)
+        {
+            return;
+        }
+        countdown = m_period - 1;
+        inSampler = true;
+
+        // Skip this function and TrackedAllocate(); operator new may be inlined into its
+        // caller, so its frames are left to the report
+        constexpr int skip = 2;
+        void* frames[AllocationSite::MAX_FRAMES + skip];
+        int depth = backtrace(frames, AllocationSite::MAX_FRAMES + skip) - skip;
+        if (depth > 0)
+        {
+            Insert(frames + skip, depth, size);
+        }
+        inSampler = false;
+#else
+        (void)size;
+#endif
+    }
+
+  private:
+    /**
+     * @brief Add a sample to the entry of its stack.
+     * @param frames the stack
+     * @param depth number of frames
+     * @param size requested size
+     */
+    void Insert(void* const* frames, int depth, std::size_t size) noexcept
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (int i = 0; i < depth; ++i)
+        {
+            hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ULL;
+        }
+        hash |= 1;
+
+        while (m_lock.test_and_set(std::memory_order_acquire))
+        {
+        }
+        for (uint32_t probe = 0; probe < TABLE_SIZE; ++probe)
+        {
+            AllocationSite& site = m_sites[(hash + probe) & (TABLE_SIZE - 1)];
+            if (site.hash == 0)
+            {
+                site.hash = hash;
+                site.depth = depth;
+                std::memcpy(site.frames, frames, depth * sizeof(void*));
+            }
+            if (site.hash == hash)
+            {
+                site.samples++;
+                site.bytes += size;
+                m_lock.clear(std::memory_order_release);
+                return;
+            }
+        }
+        m_dropped++;
+        m_lock.clear(std::memory_order_release);
+    }
+
+    std::atomic<bool> m_enabled{false};         //!< Whether sampling is enabled
+    uint32_t m_period{1};                       //!< Sampling period in allocations
+    AllocationSite* m_sites{nullptr};           //!< Stack table
+    uint64_t m_dropped{0};                      //!< Samples that did not fit in the table
+    std::atomic_flag m_lock = ATOMIC_FLAG_INIT; //!< Protects the table
+};
+
+/// Stack sampler of the whole process
+inline AllocationSampler g_allocationSampler;
+
+/**
+ * @brief Count and perform one allocation.
+ * @param size requested size
+ * @return the allocated block, or nullptr if malloc failed
+ */
+[[gnu::noinline]] inline void*
+TrackedAllocate(std::size_t size) noexcept
+{
+    g_allocationCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocationCounters.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (g_allocationSampler.IsEnabled())
+    {
+        g_allocationSampler.OnAllocation(size);
+    }
+    if (SlotArena::Tier tier = SlotArena::GetTier(); tier != SlotArena::NONE)
+    {
+        if (void* block = SlotArena::Get().Allocate(size, tier))
+        {
+            return block;
+        }
+    }
+    void* p = std::malloc(size == 0 ? 1 : size);
+#ifdef __GLIBC__
+    if (p != nullptr)
+    {
+        g_allocationCounters.liveBytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+    }
+#endif
+    return p;
+}
+
+/**
+ * @brief Release a block of TrackedAllocate().
+ * @param p the block, may be nullptr
+ */
+inline void
+TrackedFree(void* p) noexcept
+{
+    if (SlotArena::Owns(p))
+    {
+        SlotArena::Get().Free(p);
+        return;
+    }
+#ifdef __GLIBC__
+    if (p != nullptr)
+    {
+        g_allocationCounters.liveBytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+    }
+#endif
+    std::free(p);
+}
+
+} // namespace ns3
+
+void*
+operator new(std::size_t size)
+{
+    void* p = ns3::TrackedAllocate(size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ns3::TrackedAllocate(size);
+}
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ns3::TrackedAllocate(size);
+}
+
+// GCC flags free() on blocks from operator new once both are inlined; here they match by
+// construction, since the replaced operator new allocates with malloc()
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void
+operator delete(void* p) noexcept
+{
+    ns3::TrackedFree(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+    ns3::TrackedFree(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    ns3::TrackedFree(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+    ns3::TrackedFree(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // ALLOC_TRACKER_H
@@ -0,0 +1,454 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef ALLOCATION_PROFILER_H
+#define ALLOCATION_PROFILER_H
+
+#include "alloc-tracker.h"
+#include "nr-layer-classifier.h"
+
+#include "ns3/nstime.h"
+#include "ns3/object-factory.h"
+#include "ns3/scheduler.h"
+#include "ns3/simulator.h"
+#include "ns3/type-id.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Allocations attributed to one function, from the sampled call stacks.
+ */
+struct AllocationSiteSummary
+{
+    std::string function;    //!< First named frame outside the allocation machinery
+    std::string allocates;   //!< The allocation helper it called, e.g. "ns3::Packet::Packet"
+    std::string layer;       //!< NR layer of the first classified frame
+    uint64_t allocations{0}; //!< Estimated allocations (samples times the period)
+    uint64_t bytes{0};       //!< Estimated bytes
+};
+
+/**
+ * @brief Allocation profile of Simulator::Run().
+ *
+ * Start() samples the allocation counters and the live bytes periodically in simulated time
+ * and, if asked, enables stack sampling; Stop() freezes the profile. The timeline points are
+ * recorded by AllocationTimelineScheduler as the events cross the intervals, without any
+ * event of their own, so the event counts and the fingerprint of the run are unchanged. The
+ * report gives the allocations per simulated second and per slot, the live bytes over time and
+ * the sites that allocate the most, with their NR layer.
+ */
+class AllocationProfiler
+{
+  public:
+    /// Live bytes and cumulative counters at one instant
+    struct TimelinePoint
+    {
+        double timeSec;       //!< Simulated time in s
+        int64_t liveBytes;    //!< Bytes allocated and not freed
+        uint64_t allocations; //!< Allocations since Start()
+        uint64_t bytes;       //!< Bytes allocated since Start()
+    };
+
+    /**
+     * @brief Start profiling; call right before Simulator::Run().
+     * @param interval simulated time between two timeline points
+     * @param samplePeriod sample the call stack of one allocation in every samplePeriod,
+     *        0 to sample none
+     */
+    void Start(Time interval, uint32_t samplePeriod)
+    {
+        m_intervalSteps = interval.GetTimeStep();
+        m_startAllocations = GetAllocationCount();
+        m_startBytes = GetAllocatedBytes();
+        m_startTime = Simulator::Now();
+        m_timeline.reserve(1024);
+        if (samplePeriod > 0 && !g_allocationSampler.Enable(samplePeriod))
+        {
+            printf("Allocation stacks cannot be sampled on this platform\n");
+        }
+        RecordPoint(m_startTime.GetSeconds());
+        m_nextPointSteps = m_startTime.GetTimeStep() + m_intervalSteps;
+        s_active = this;
+    }
+
+    /**
+     * @brief Stop profiling; call right after Simulator::Run().
+     */
+    void Stop()
+    {
+        g_allocationSampler.Disable();
+        s_active = nullptr;
+        m_runAllocations = GetAllocationCount() - m_startAllocations;
+        m_runBytes = GetAllocatedBytes() - m_startBytes;
+        m_runSeconds = (Simulator::Now() - m_startTime).GetSeconds();
+        RecordPoint(Simulator::Now().GetSeconds());
+    }
+
+    /**
+     * @return the profiler between Start() and Stop(), nullptr otherwise
+     */
+    static AllocationProfiler* GetActive()
+    {
+        return s_active;
+    }
+
+    /**
+     * @brief Record the timeline points simulated time passes before an event runs.
+     * @param ts time step of the event
+     */
+    void OnEvent(uint64_t ts)
+    {
+        while (ts >= m_nextPointSteps)
+        {
+            RecordPoint(Time(m_nextPointSteps).GetSeconds());
+            m_nextPointSteps += m_intervalSteps;
+        }
+    }
+
+    /**
+     * @return allocations per simulated second of the run
+     */
+    double GetAllocationsPerSecond() const
+    {
+        return m_runSeconds > 0 ? m_runAllocations / m_runSeconds : 0.0;
+    }
+
+    /**
+     * @return the highest live bytes seen on the timeline
+     */
+    int64_t GetPeakLiveBytes() const
+    {
+        int64_t peak = 0;
+        for (const auto& point : m_timeline)
+        {
+            peak = std::max(peak, point.liveBytes);
+        }
+        return peak;
+    }
+
+    /**
+     * @return the timeline of live bytes and counters
+     */
+    const std::vector<TimelinePoint>& GetTimeline() const
+    {
+        return m_timeline;
+    }
+
+    /**
+     * @brief Write the timeline as CSV.
+     * @param path the file name
+     * @return true on success
+     */
+    bool WriteTimeline(const std::string& path) const
+    {
+        std::ofstream out(path);
+        out << "timeSec,liveBytes,allocations,bytes\n";
+        for (const auto& point : m_timeline)
+        {
+            out << point.timeSec << "," << point.liveBytes << "," << point.allocations << ","
+                << point.bytes << "\n";
+        }
+        return out.good();
+    }
+
+    /**
+     * @brief Aggregate the sampled stacks per allocating function.
+     * @return the sites, most allocations first; empty if no stack was sampled
+     */
+    std::vector<AllocationSiteSummary> GetSites() const
+    {
+        const AllocationSite* sites = g_allocationSampler.GetSites();
+        if (sites == nullptr)
+        {
+            return {};
+        }
+        const uint64_t period = g_allocationSampler.GetPeriod();
+        std::map<std::string, AllocationSiteSummary> byFunction;
+        std::map<const void*, std::string> names; // Symbol cache
+        auto name = [&names](const void* frame) -> const std::string& {
+            auto it = names.find(frame);
+            if (it == names.end())
+            {
+                it = names.emplace(frame, ResolveCodeAddress(frame)).first;
+            }
+            return it->second;
+        };
+
+        for (uint32_t i = 0; i < AllocationSampler::TABLE_SIZE; ++i)
+        {
+            const AllocationSite& site = sites[i];
+            if (site.hash == 0)
+            {
+                continue;
+            }
+            std::string function;
+            std::string allocates;
+            std::string layer = "Other";
+            for (int f = 0; f < site.depth; ++f)
+            {
+                const std::string& frame = name(site.frames[f]);
+                if (frame.empty())
+                {
+                    continue;
+                }
+                std::string shortName = ShortFunctionName(frame);
+                if (function.empty())
+                {
+                    if (IsAllocationMachinery(shortName))
+                    {
+                        if (shortName.rfind("operator new", 0) != 0)
+                        {
+                            allocates = shortName;
+                        }
+                        continue;
+                    }
+                    function = shortName;
+                }
+                layer = ClassifyNrLayer(shortName);
+                if (layer != "Other")
+                {
+                    break;
+                }
+            }
+            if (function.empty())
+            {
+                function = "(unnamed)";
+            }
+
+            AllocationSiteSummary& summary = byFunction[function + "|" + allocates];
+            summary.function = function;
+            summary.allocates = allocates;
+            summary.layer = layer;
+            summary.allocations += site.samples * period;
+            summary.bytes += site.bytes * period;
+        }
+
+        std::vector<AllocationSiteSummary> result;
+        for (auto& [key, summary] : byFunction)
+        {
+            result.push_back(summary);
+        }
+        std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+            return a.allocations > b.allocations;
+        });
+        return result;
+    }
+
+    /**
+     * @brief Print the rates, the live bytes and the top sites.
+     * @param slots simulated slots of the run
+     * @param topSites number of sites to print
+     */
+    void Print(double slots, std::size_t topSites = 15) const
+    {
+        printf("Allocation profile (Simulator::Run):\n");
+        printf("  %lu allocations, %.1f MB: %.0f allocs/simulated s, %.1f allocs/slot, "
+               "%.0f bytes/slot\n",
+               static_cast<unsigned long>(m_runAllocations),
+               m_runBytes / 1e6,
+               GetAllocationsPerSecond(),
+               slots > 0 ? m_runAllocations / slots : 0.0,
+               slots > 0 ? m_runBytes / slots : 0.0);
+        if (!m_timeline.empty())
+        {
+            printf("  live bytes: %.1f MB at start, %.1f MB at end, %.1f MB peak\n",
+                   m_timeline.front().liveBytes / 1e6,
+                   m_timeline.back().liveBytes / 1e6,
+                   GetPeakLiveBytes() / 1e6);
+        }
+
+        std::vector<AllocationSiteSummary> sites = GetSites();
+        if (sites.empty())
+        {
+            return;
+        }
+
+        std::map<std::string, uint64_t> layers;
+        for (const auto& site : sites)
+        {
+            layers[site.layer.substr(0, site.layer.find(';'))] += site.allocations;
+        }
+        printf("  per layer (sampled 1 in %u):\n", g_allocationSampler.GetPeriod());
+        for (const auto& [layer, allocations] : layers)
+        {
+            printf("    %-14s %12lu allocs %8.1f/slot\n",
+                   layer.c_str(),
+                   static_cast<unsigned long>(allocations),
+                   slots > 0 ? allocations / slots : 0.0);
+        }
+        printf("  top allocating sites:\n");
+        for (std::size_t i = 0; i < std::min(topSites, sites.size()); ++i)
+        {
+            const auto& site = sites[i];
+            printf("    %8.1f/slot %10.1f MB  %-20s %s%s%s\n",
+                   slots > 0 ? site.allocations / slots : 0.0,
+                   site.bytes / 1e6,
+                   site.layer.c_str(),
+                   site.function.c_str(),
+                   site.allocates.empty() ? "" : " -> ",
+                   site.allocates.c_str());
+        }
+        if (g_allocationSampler.GetDropped() > 0)
+        {
+            printf("  %lu samples dropped (stack table full)\n",
+                   static_cast<unsigned long>(g_allocationSampler.GetDropped()));
+        }
+    }
+
+  private:
+    /**
+     * @param function a function name without parameters
+     * @return whether the function only carries out an allocation requested by its caller
+     */
+    static bool IsAllocationMachinery(const std::string& function)
+    {
+        static const char* prefixes[] = {
+            "operator new",
+            "ns3::TrackedAllocate",
+            "std::",
+            "__gnu_cxx::",
+            "ns3::Create",
+            "ns3::CreateObject",
+            "ns3::Ptr::",
+            "ns3::Object::",
+            "ns3::ObjectBase::",
+            "ns3::ObjectFactory::",
+            "ns3::SimpleRefCount::",
+            "ns3::Buffer::",
+            "ns3::Packet::",
+            "ns3::PacketMetadata::",
+            "ns3::ByteTagList::",
+            "ns3::PacketTagList::",
+            "ns3::SpectrumValue::",
+            "ns3::MakeEvent",
+            "ns3::Simulator::Schedule",
+            "ns3::MakeCallback",
+            "ns3::Callback::",
+            "ns3::CallbackImpl::",
+        };
+        for (const char* prefix : prefixes)
+        {
+            if (function.rfind(prefix, 0) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Add the current counters to the timeline.
+     * @param timeSec simulated time of the point
+     */
+    void RecordPoint(double timeSec)
+    {
+        m_timeline.push_back({timeSec,
+                              GetLiveBytes(),
+                              GetAllocationCount() - m_startAllocations,
+                              GetAllocatedBytes() - m_startBytes});
+    }
+
+    static inline AllocationProfiler* s_active = nullptr; //!< Profiler fed by the scheduler
+
+    uint64_t m_intervalSteps{1};           //!< Time steps between timeline points
+    uint64_t m_nextPointSteps{0};          //!< Time step of the next timeline point
+    Time m_startTime;                      //!< Simulated time at Start()
+    uint64_t m_startAllocations{0};        //!< Allocation count at Start()
+    uint64_t m_startBytes{0};              //!< Allocated bytes at Start()
+    uint64_t m_runAllocations{0};          //!< Allocations between Start() and Stop()
+    uint64_t m_runBytes{0};                //!< Bytes allocated between Start() and Stop()
+    double m_runSeconds{0};                //!< Simulated seconds between Start() and Stop()
+    std::vector<TimelinePoint> m_timeline; //!< Live bytes over time
+};
+
+/**
+ * @brief Scheduler wrapper recording the timeline points of the active AllocationProfiler.
+ *
+ * Before an event is handed to the simulator, the points of the intervals its time crosses
+ * are recorded, with the counters as the previous events left them: the profile gets its
+ * periodic points without scheduling any event.
+ */
+class AllocationTimelineScheduler : public Scheduler
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::AllocationTimelineScheduler")
+                .SetParent<Scheduler>()
+                .SetGroupName("Core")
+                .AddConstructor<AllocationTimelineScheduler>()
+                .AddAttribute("Inner",
+                              "Factory of the scheduler holding the events.",
+                              ObjectFactoryValue(ObjectFactory("ns3::MapScheduler")),
+                              MakeObjectFactoryAccessor(
+                                  &AllocationTimelineScheduler::m_innerFactory),
+                              MakeObjectFactoryChecker());
+        return tid;
+    }
+
+    void Insert(const Event& ev) override
+    {
+        m_inner->Insert(ev);
+    }
+
+    bool IsEmpty() const override
+    {
+        return m_inner->IsEmpty();
+    }
+
+    Event PeekNext() const override
+    {
+        return m_inner->PeekNext();
+    }
+
+    Event RemoveNext() override
+    {
+        // Before the inner schedulers route the allocations of the event (SlotArenaScheduler)
+        if (AllocationProfiler* profiler = AllocationProfiler::GetActive())
+        {
+            profiler->OnEvent(m_inner->PeekNext().key.m_ts);
+        }
+        return m_inner->RemoveNext();
+    }
+
+    void Remove(const Event& ev) override
+    {
+        m_inner->Remove(ev);
+    }
+
+  protected:
+    void NotifyConstructionCompleted() override
+    {
+        m_inner = m_innerFactory.Create<Scheduler>();
+        Scheduler::NotifyConstructionCompleted();
+    }
+
+    void DoDispose() override
+    {
+        m_inner = nullptr;
+        Scheduler::DoDispose();
+    }
+
+  private:
+    ObjectFactory m_innerFactory; //!< Factory of the inner scheduler
+    Ptr<Scheduler> m_inner;       //!< Scheduler holding the events
+};
+
+NS_OBJECT_ENSURE_REGISTERED(AllocationTimelineScheduler);
+
+} // namespace ns3
+
+#endif // ALLOCATION_PROFILER_H
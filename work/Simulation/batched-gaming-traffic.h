@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef BATCHED_GAMING_TRAFFIC_H
+#define BATCHED_GAMING_TRAFFIC_H
+
+#include "binary-log.h"
+#include "radio-traffic-injector.h"
+
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/traced-callback.h"
+#include "ns3/udp-socket-factory.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Gaming traffic of many UEs, with the arrivals of a slot delivered by one event.
+ *
+ * Every flow draws its own arrivals from a RadioTrafficSource, in the same order as
+ * RadioTrafficInjector does, so the arrival times and sizes of a flow are unchanged. The
+ * arrivals of all the flows that fall in the same slot are delivered together, at the time of
+ * the last one: the gNB scheduler only looks at the RLC buffers at the next slot, so it sees
+ * the same data, with one event per slot instead of one per packet. Each packet is built
+ * as the per-UE applications build theirs: the batching saves events, not packets.
+ *
+ * Socket flows send to a UE address over UDP from the node of the application (the remote
+ * host, through the EPC); radio flows hand the packets straight to the gNB of the UE, as
+ * RadioTrafficInjector does.
+ */
+class BatchedGamingTraffic : public Application
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::BatchedGamingTraffic")
+                .SetParent<Application>()
+                .SetGroupName("Applications")
+                .AddConstructor<BatchedGamingTraffic>()
+                .AddAttribute("SlotDuration",
+                              "Arrivals within one slot are delivered by a single event.",
+                              TimeValue(MilliSeconds(0.5)),
+                              MakeTimeAccessor(&BatchedGamingTraffic::m_slot),
+                              MakeTimeChecker(NanoSeconds(1)))
+                .AddTraceSource("Tx",
+                                "A packet of a flow has been sent or handed to the gNB.",
+                                MakeTraceSourceAccessor(&BatchedGamingTraffic::m_txTrace),
+                                "ns3::BatchedGamingTraffic::TxTracedCallback");
+        return tid;
+    }
+
+    /**
+     * @brief TracedCallback signature of the packets sent.
+     * @param [in] packet the packet
+     * @param [in] flow index of the flow, in the order the flows were added
+     */
+    typedef void (*TxTracedCallback)(Ptr<const Packet> packet, uint32_t flow);
+
+    /**
+     * @brief Add a flow sent over UDP from the node of the application.
+     * @param source arrival process
+     * @param destination UE address and port
+     */
+    void AddSocketFlow(Ptr<RadioTrafficSource> source, const InetSocketAddress& destination)
+    {
+        Flow flow;
+        flow.source = source;
+        flow.destination = destination;
+        m_flows.push_back(flow);
+    }
+
+    /**
+     * @brief Add a flow handed straight to the gNB of a UE, without EPC.
+     * @param source arrival process
+     * @param ueDevice the UE, attached to its gNB before the application starts
+     * @param bearerId EPS bearer of the UE carrying the packets
+     */
+    void AddRadioFlow(Ptr<RadioTrafficSource> source,
+                      Ptr<NrUeNetDevice> ueDevice,
+                      uint8_t bearerId = 1)
+    {
+        Flow flow;
+        flow.source = source;
+        flow.ueDevice = ueDevice;
+        flow.bearerId = bearerId;
+        m_flows.push_back(flow);
+    }
+
+    /**
+     * @param flow index of the flow, in the order the flows were added
+     * @return the arrival process of the flow
+     */
+    Ptr<RadioTrafficSource> GetSource(uint32_t flow) const
+    {
+        return m_flows.at(flow).source;
+    }
+
+    /**
+     * @return packet arrivals so far, over all the flows
+     */
+    uint64_t GetArrivals() const
+    {
+        return m_arrivals;
+    }
+
+    /**
+     * @return delivery events so far
+     */
+    uint64_t GetDeliveryEvents() const
+    {
+        return m_deliveryEvents;
+    }
+
+    /**
+     * @return arrivals dropped because their UE was not connected (radio flows)
+     */
+    uint64_t GetDropped() const
+    {
+        return m_dropped;
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_event.Cancel();
+        m_flows.clear();
+        Application::DoDispose();
+    }
+
+  private:
+    /// Traffic towards one UE
+    struct Flow
+    {
+        Ptr<RadioTrafficSource> source;  //!< Arrival process
+        InetSocketAddress destination{Ipv4Address::GetAny(), 0}; //!< UE address (socket flows)
+        Ptr<Socket> socket;              //!< UDP socket (socket flows)
+        Ptr<NrUeNetDevice> ueDevice;     //!< UE (radio flows)
+        uint8_t bearerId{1};             //!< EPS bearer (radio flows)
+    };
+
+    /// One arrival of the batch being delivered
+    struct Arrival
+    {
+        uint32_t flow;    //!< Index of the flow
+        uint32_t payload; //!< Application bytes
+    };
+
+    /// Next arrival time of every flow, earliest first (ties by flow index)
+    using ArrivalQueue = std::priority_queue<std::pair<Time, uint32_t>,
+                                             std::vector<std::pair<Time, uint32_t>>,
+                                             std::greater<>>;
+
+    void StartApplication() override
+    {
+        for (uint32_t i = 0; i < m_flows.size(); ++i)
+        {
+            Flow& flow = m_flows[i];
+            if (!flow.ueDevice)
+            {
+                flow.socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+                flow.socket->Bind();
+                flow.socket->Connect(flow.destination);
+            }
+            Time delay = flow.source->GetInitialDelay();
+            if (flow.source->HasNextPacket())
+            {
+                m_next.emplace(Simulator::Now() + delay, i);
+            }
+        }
+        ScheduleNextBatch();
+    }
+
+    void StopApplication() override
+    {
+        m_event.Cancel();
+        for (Flow& flow : m_flows)
+        {
+            if (flow.socket)
+            {
+                flow.socket->Close();
+                flow.socket = nullptr;
+            }
+        }
+    }
+
+    /**
+     * @brief Collect the arrivals of the slot of the earliest pending one, and schedule their
+     *        delivery at the last of them.
+     */
+    void ScheduleNextBatch()
+    {
+        if (m_next.empty())
+        {
+            return;
+        }
+        Time first = m_next.top().first;
+        Time slotEnd = m_slot * (first.GetTimeStep() / m_slot.GetTimeStep() + 1);
+        Time last = first;
+        m_batch.clear();
+        while (!m_next.empty() && m_next.top().first < slotEnd)
+        {
+            auto [time, index] = m_next.top();
+            m_next.pop();
+            // Same draw order as RadioTrafficInjector: the size, then the next arrival
+            Flow& flow = m_flows[index];
+            m_batch.push_back({index, flow.source->GetNextPacketSize()});
+            Time interArrival = flow.source->GetNextInterArrival();
+            if (flow.source->HasNextPacket())
+            {
+                m_next.emplace(time + interArrival, index);
+            }
+            last = std::max(last, time);
+        }
+        m_event = Simulator::Schedule(last - Simulator::Now(),
+                                      &BatchedGamingTraffic::DeliverBatch,
+                                      this);
+    }
+
+    /// Deliver the arrivals of a slot, then prepare the next slot with arrivals
+    void DeliverBatch()
+    {
+        m_deliveryEvents++;
+        BINLOG_DEBUG("Delivering %zu arrivals at %ld ns",
+                     m_batch.size(),
+                     Simulator::Now().GetTimeStep());
+        for (const Arrival& arrival : m_batch)
+        {
+            m_arrivals++;
+            Flow& flow = m_flows[arrival.flow];
+            if (flow.socket)
+            {
+                Ptr<Packet> packet = Create<Packet>(arrival.payload);
+                m_txTrace(packet, arrival.flow);
+                flow.socket->Send(packet);
+            }
+            else if (IsUeConnected(flow.ueDevice))
+            {
+                Ptr<Packet> packet = MakeGamingIpPacket(arrival.payload);
+                m_txTrace(packet, arrival.flow);
+                InjectDownlinkPacket(flow.ueDevice, flow.bearerId, packet);
+            }
+            else
+            {
+                m_dropped++;
+            }
+        }
+        ScheduleNextBatch();
+    }
+
+    Time m_slot{MilliSeconds(0.5)}; //!< Slot duration
+    std::vector<Flow> m_flows;      //!< Flows, one per UE
+    ArrivalQueue m_next;            //!< Next arrival of every flow
+    std::vector<Arrival> m_batch;   //!< Arrivals of the next delivery
+    EventId m_event;                //!< Next delivery
+    uint64_t m_arrivals{0};         //!< Arrivals delivered or dropped
+    uint64_t m_deliveryEvents{0};   //!< Delivery events
+    uint64_t m_dropped{0};          //!< Arrivals dropped before connection
+
+    TracedCallback<Ptr<const Packet>, uint32_t> m_txTrace; //!< Tx trace source
+};
+
+NS_OBJECT_ENSURE_REGISTERED(BatchedGamingTraffic);
+
+} // namespace ns3
+
+#endif // BATCHED_GAMING_TRAFFIC_H
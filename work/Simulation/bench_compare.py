@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Compare a benchmark sweep against a stored baseline and flag regressions.
+
+Records are matched by their parameter key (see bench_sweep.py). A metric regresses when it
+is worse than the baseline by more than the threshold, in the metric's own direction: more
+wall time, memory or trace bytes, or fewer events per second.
+
+With --fingerprints, the run fingerprints are compared instead: a run of another build or
+optimization mode is bit-exact if its fingerprint equals the baseline's, and the differing
+parts (events, traces, KPIs) are listed otherwise.
+
+Example:
+    ./bench_compare.py bench-results.json bench-baseline.json --threshold 0.10
+    ./bench_compare.py bench-results.json bench-baseline.json --store   # accept as baseline
+    ./bench_compare.py bench-o3.json bench-debug.json --fingerprints
+"""
+
+import argparse
+import json
+import shutil
+import sys
+
+# Parts of the run fingerprint, see run-fingerprint.h
+FINGERPRINT_PARTS = ("events", "traces", "kpis")
+
+# Metric name -> +1 if higher is worse, -1 if lower is worse
+METRICS = {
+    "wallMs": +1,
+    "simWallRatio": -1,
+    "eventsPerSec": -1,
+    "wallUsPerSlot": +1,
+    "peakRssBytes": +1,
+    "traceBytes": +1,
+    "allocationsPerSlot": +1,
+    "mallocCallsPerSlot": +1,
+    "traceSinkMs": +1,
+    # Only in runs with --hwCounters=true
+    "ipc": -1,
+    "instructionsPerSlot": +1,
+    "llcMissesPerSlot": +1,
+    "branchMissesPerSlot": +1,
+}
+
+
+def load(path):
+    with open(path) as f:
+        return {r["key"]: r for r in json.load(f)["records"] if "error" not in r}
+
+
+def compare(current, baseline, threshold, metrics):
+    """Return (regressions, improvements, missing) lists of printable findings."""
+    regressions, improvements, missing = [], [], []
+    for key, base in sorted(baseline.items()):
+        if key not in current:
+            missing.append(key)
+            continue
+        for metric in metrics:
+            old = base["metrics"].get(metric)
+            new = current[key]["metrics"].get(metric)
+            if old is None or new is None or old == 0:
+                continue
+            change = (new - old) / old
+            line = f"{key}: {metric} {old:.4g} -> {new:.4g} ({change:+.1%})"
+            if METRICS[metric] * change > threshold:
+                regressions.append(line)
+            elif METRICS[metric] * change < -threshold:
+                improvements.append(line)
+    return regressions, improvements, missing
+
+
+def fingerprint_diff(record, reference):
+    """Parts of the fingerprint differing between two records; None if either has none."""
+    new = record.get("fingerprint")
+    old = reference.get("fingerprint")
+    if not new or not old:
+        return None
+    if new["run"] == old["run"]:
+        return []
+    return [part for part in FINGERPRINT_PARTS if new.get(part) != old.get(part)]
+
+
+def compare_fingerprints(current, baseline):
+    """Return (exact, differing, unchecked) lists of printable findings."""
+    exact, differing, unchecked = [], [], []
+    for key, base in sorted(baseline.items()):
+        if key not in current:
+            continue
+        diff = fingerprint_diff(current[key], base)
+        if diff is None:
+            unchecked.append(key)
+        elif diff:
+            differing.append(f"{key}: {', '.join(diff)} differ")
+        else:
+            exact.append(f"{key}: {base['fingerprint']['run']}")
+    return exact, differing, unchecked
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("current")
+    parser.add_argument("baseline")
+    parser.add_argument("--threshold", type=float, default=0.10, help="relative, default 0.10")
+    parser.add_argument(
+        "--metrics", default=",".join(METRICS), help="comma-separated metrics to compare"
+    )
+    parser.add_argument("--store", action="store_true", help="copy current over the baseline")
+    parser.add_argument(
+        "--fingerprints", action="store_true", help="check the results are bit-exact instead"
+    )
+    args = parser.parse_args()
+
+    if args.store:
+        shutil.copyfile(args.current, args.baseline)
+        print(f"Stored {args.current} as baseline {args.baseline}")
+        return 0
+
+    if args.fingerprints:
+        exact, differing, unchecked = compare_fingerprints(
+            load(args.current), load(args.baseline)
+        )
+        for line in exact:
+            print(f"bit-exact  {line}")
+        for key in unchecked:
+            print(f"unchecked  {key} (no fingerprint, run with --fingerprint=true)")
+        for line in differing:
+            print(f"DIFFERENT  {line}")
+        print(f"{len(exact)} runs bit-exact, {len(differing)} different, {len(unchecked)} unchecked")
+        return 1 if differing else 0
+
+    metrics = [m for m in args.metrics.split(",") if m]
+    unknown = [m for m in metrics if m not in METRICS]
+    if unknown:
+        parser.error(f"unknown metrics: {', '.join(unknown)}")
+
+    regressions, improvements, missing = compare(
+        load(args.current), load(args.baseline), args.threshold, metrics
+    )
+    for line in improvements:
+        print(f"improved   {line}")
+    for key in missing:
+        print(f"missing    {key}")
+    for line in regressions:
+        print(f"REGRESSION {line}")
+    print(
+        f"{len(regressions)} regressions, {len(improvements)} improvements beyond "
+        f"{args.threshold:.0%}, {len(missing)} baseline runs missing"
+    )
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
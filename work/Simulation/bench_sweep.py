@@ -0,0 +1,304 @@
+#!/usr/bin/env python3
+"""Run the NR scenario over a grid of scaling parameters and collect benchmark records.
+
+Run from the ns-3 root folder, like run-multi-sim.sh. Every run executes in its own directory
+under --work-dir, so trace files of parallel or consecutive runs never mix; the scenario writes
+its record with --benchJson and the sweep adds the size of the trace files it produced.
+
+With --variant, every parameter combination also runs once per variant (extra scenario
+arguments, e.g. an optimization mode) and the run fingerprints of each variant are checked
+against the first one: a variant is bit-exact or, if its results differ, approximate. Only
+variants listed in --approximate may differ without failing the sweep.
+
+The runs execute on --jobs parallel slots, packed by sweep_packing.py: a cost model learned
+from the records of the runs done so far and of earlier sweeps (--history) predicts the wall
+time and memory of every run, the longest expected runs start first, and smaller ones backfill
+the slots while a large one waits for memory under --mem-cap-mb.
+
+Example:
+    ./bench_sweep.py --ue-num 4,16 --gnb-num 1 --channel-model ThreeGpp,Friis -o bench.json
+    ./bench_compare.py bench.json bench-baseline.json
+    ./bench_sweep.py --ue-num 16 --variant ref= --variant prof=--profileEvents=true -o fp.json
+    ./bench_sweep.py --ue-num 4,64,1024 --jobs 8 --history bench-baseline.json
+"""
+
+import argparse
+import itertools
+import json
+import os
+import subprocess
+import sys
+import time
+
+from bench_compare import fingerprint_diff
+from sweep_packing import CostModel, memory_cap, pack, prediction_error, settings
+
+PROGRAM = "scratch/nr-gaming/opt-gsoc-nr-channel-models-error"
+
+# Scaling dimensions of the default grid
+DEFAULT_GRID = {
+    "ueNum": [4, 16, 64, 256, 1024],
+    "gNbNum": [1, 7, 19],
+    "channelModel": ["ThreeGpp", "NYU", "TwoRay", "Friis"],
+    "bandwidth": [100e6],
+    "gnbAntenna": ["4x8"],
+    "enableTraces": [True, False],
+}
+
+# Outputs of the run that are not traces: the per-flow KPIs (--flowKpis, on by default)
+NON_TRACE_OUTPUTS = {"channels-example-flows.txt"}
+
+
+def parse_list(text, cast):
+    return [cast(item) for item in text.split(",") if item]
+
+
+def parse_bool(text):
+    return text.lower() in ("1", "true", "on", "yes")
+
+
+def run_key(params):
+    """Stable, filesystem-friendly name of a parameter combination."""
+    return "_".join(f"{k}-{params[k]}" for k in sorted(params))
+
+
+def scenario_args(params):
+    """Command-line arguments of the scenario for one parameter combination."""
+    args = {k: v for k, v in params.items() if k not in ("gnbAntenna", "ueAntenna")}
+    for prefix, key in (("gnb", "gnbAntenna"), ("ue", "ueAntenna")):
+        if key in params:
+            rows, cols = params[key].split("x")
+            args[prefix + "NumRows"] = rows
+            args[prefix + "NumCols"] = cols
+    return [
+        f"--{k}={str(v).lower() if isinstance(v, bool) else v}" for k, v in sorted(args.items())
+    ]
+
+
+def trace_bytes(run_dir):
+    """Bytes written to trace files (not the benchmark record nor the KPIs) in a run directory."""
+    total = 0
+    for name in os.listdir(run_dir):
+        path = os.path.join(run_dir, name)
+        if os.path.isfile(path) and name.endswith(".txt") and name not in NON_TRACE_OUTPUTS:
+            total += os.path.getsize(path)
+    return total
+
+
+def build(ns3):
+    subprocess.run([ns3, "build", PROGRAM], check=True)
+
+
+def parse_variant(text):
+    """LABEL=ARGS -> (label, list of scenario arguments)."""
+    label, _, args = text.partition("=")
+    if not label or "@" in label:
+        raise argparse.ArgumentTypeError(f"expected LABEL=ARGS, got {text!r}")
+    return label, args.split()
+
+
+def run_one(ns3, params, work_dir, extra_args, timeout, variant=None):
+    """Run the scenario once; return its benchmark record, or a record with an error."""
+    key = run_key(params) + (f"@{variant}" if variant else "")
+    run_dir = os.path.abspath(os.path.join(work_dir, key))
+    os.makedirs(run_dir, exist_ok=True)
+    record_path = os.path.join(run_dir, "bench.json")
+    if os.path.exists(record_path):
+        os.remove(record_path)
+
+    command = " ".join(
+        [PROGRAM]
+        + scenario_args(params)
+        + extra_args
+        + [f"--benchJson={record_path}"]
+    )
+    start = time.monotonic()
+    try:
+        proc = subprocess.run(
+            [ns3, "run", "--no-build", f"--cwd={run_dir}", command],
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+            text=True,
+            timeout=timeout,
+        )
+        returncode = proc.returncode
+        output = proc.stdout
+    except subprocess.TimeoutExpired:
+        returncode = None
+        output = "timeout"
+    elapsed = time.monotonic() - start
+
+    with open(os.path.join(run_dir, "run.log"), "w") as log:
+        log.write(output)
+
+    if returncode == 0 and os.path.exists(record_path):
+        with open(record_path) as f:
+            record = json.load(f)
+    else:
+        record = {"params": params, "metrics": {}, "error": f"exit status {returncode}"}
+    record["params"].update({k: v for k, v in params.items() if k not in record["params"]})
+    record["metrics"]["traceBytes"] = trace_bytes(run_dir)
+    record["metrics"]["processWallSec"] = elapsed
+    record["key"] = key
+    if variant:
+        record["variant"] = variant
+    return record
+
+
+def check_variants(records, reference, approximate):
+    """Print the fingerprint verdict of every variant run; return the unexpected differences."""
+    unexpected = 0
+    runs = {}
+    for record in records:
+        if "error" not in record:
+            runs.setdefault(record["key"].split("@")[0], {})[record.get("variant")] = record
+    for key, variants in sorted(runs.items()):
+        if reference not in variants:
+            continue
+        for label, record in variants.items():
+            if label == reference:
+                continue
+            diff = fingerprint_diff(record, variants[reference])
+            if diff is None:
+                verdict = "unchecked (no fingerprint)"
+            elif not diff:
+                verdict = "bit-exact"
+            elif label in approximate:
+                verdict = f"approximate ({', '.join(diff)} differ)"
+            else:
+                verdict = f"NOT BIT-EXACT ({', '.join(diff)} differ)"
+                unexpected += 1
+            print(f"{key}: {label} vs {reference}: {verdict}")
+    return unexpected
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--ns3", default="./ns3", help="ns3 driver script (default ./ns3)")
+    parser.add_argument("-o", "--output", default="bench-results.json")
+    parser.add_argument("--work-dir", default="bench_runs")
+    parser.add_argument("--ue-num", type=lambda t: parse_list(t, int))
+    parser.add_argument("--gnb-num", type=lambda t: parse_list(t, int))
+    parser.add_argument("--channel-model", type=lambda t: parse_list(t, str))
+    parser.add_argument("--bandwidth", type=lambda t: parse_list(t, float))
+    parser.add_argument("--gnb-antenna", type=lambda t: parse_list(t, str), help="e.g. 4x8,8x8")
+    parser.add_argument("--traces", type=lambda t: parse_list(t, parse_bool), help="e.g. on,off")
+    parser.add_argument(
+        "--radio-only", type=lambda t: parse_list(t, parse_bool), help="e.g. off,on, no EPC/IP"
+    )
+    parser.add_argument(
+        "--full-buffer",
+        type=lambda t: parse_list(t, parse_bool),
+        help="e.g. off,on, saturated DL/UL buffers instead of gaming traffic",
+    )
+    parser.add_argument("--sim-time", default="1s", help="simulated time of every run")
+    parser.add_argument("--timeout", type=float, default=None, help="per-run timeout in s")
+    parser.add_argument("--no-build", action="store_true")
+    parser.add_argument("-j", "--jobs", type=int, default=1, help="runs in parallel")
+    parser.add_argument(
+        "--mem-cap-mb",
+        type=float,
+        default=None,
+        help="memory the parallel runs may use together (default 80%% of the available)",
+    )
+    parser.add_argument(
+        "--history",
+        action="append",
+        default=[],
+        help="records of an earlier sweep to learn the cost model from; repeatable",
+    )
+    parser.add_argument(
+        "--variant",
+        type=parse_variant,
+        action="append",
+        default=[],
+        help="LABEL=ARGS, run every combination with these extra arguments too; repeatable",
+    )
+    parser.add_argument(
+        "--approximate",
+        type=lambda t: parse_list(t, str),
+        default=[],
+        help="variants allowed to change the results",
+    )
+    # Unknown options are passed to the scenario, e.g. --channelConditionModel=NLOS
+    args, passthrough = parser.parse_known_args()
+
+    grid = dict(DEFAULT_GRID)
+    overrides = {
+        "ueNum": args.ue_num,
+        "gNbNum": args.gnb_num,
+        "channelModel": args.channel_model,
+        "bandwidth": args.bandwidth,
+        "gnbAntenna": args.gnb_antenna,
+        "enableTraces": args.traces,
+        "radioOnly": args.radio_only,
+        "fullBuffer": args.full_buffer,
+    }
+    grid.update({k: v for k, v in overrides.items() if v})
+
+    if not args.no_build:
+        build(args.ns3)
+
+    keys = list(grid)
+    combos = [dict(zip(keys, values)) for values in itertools.product(*grid.values())]
+    extra = [f"--simTime={args.sim_time}"] + passthrough
+    variants = args.variant or [(None, [])]
+    jobs = [
+        {
+            "params": params,
+            "label": label,
+            "args": extra + vargs,
+            "settings": settings(params, extra + vargs),
+        }
+        for params in combos
+        for label, vargs in variants
+    ]
+    history = []
+    for path in args.history:
+        with open(path) as f:
+            history.extend(json.load(f)["records"])
+    mem_cap = args.mem_cap_mb * 1e6 if args.mem_cap_mb else memory_cap()
+    model = CostModel()
+
+    def run(job):
+        return run_one(
+            args.ns3, job["params"], args.work_dir, job["args"], args.timeout, job["label"]
+        )
+
+    records = []
+    for job, record in pack(jobs, run, args.jobs, mem_cap, model, history):
+        records.append(record)
+        metrics = record["metrics"]
+        wall, memory = job["predicted"]
+        print(
+            f"[{len(records)}/{len(jobs)}] {record['key']} "
+            f"(expected {wall:.1f} s, {memory / 1e6:.0f} MB)",
+            flush=True,
+        )
+        if "error" in record:
+            print(f"    failed: {record['error']}")
+        else:
+            print(
+                f"    {metrics['wallMs']} ms, {metrics['eventsPerSec']:.0f} events/s, "
+                f"{metrics['peakRssBytes'] / 1e6:.0f} MB, {metrics['traceBytes'] / 1e6:.1f} MB traces"
+            )
+        # Keep partial results if the sweep is interrupted
+        with open(args.output, "w") as f:
+            json.dump({"records": records}, f, indent=1)
+
+    failed = sum(1 for r in records if "error" in r)
+    print(f"{len(records) - failed} runs recorded in {args.output}, {failed} failed")
+    error = prediction_error(records)
+    if error:
+        print(
+            f"Cost model: median error {error[0]:.0%} on wall time, {error[1]:.0%} on memory "
+            f"({model.samples} records)"
+        )
+    unexpected = 0
+    if len(variants) > 1:
+        unexpected = check_variants(records, variants[0][0], args.approximate)
+    return 1 if failed or unexpected else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,458 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Highest level compiled in; the log statements above it generate no code.
+ *
+ * 0 keeps the errors only, 3 every level. Build with e.g. -DBINLOG_MAX_LEVEL=2 to remove the
+ * debug statements from the hot paths altogether.
+ */
+#ifndef BINLOG_MAX_LEVEL
+#define BINLOG_MAX_LEVEL 3
+#endif
+
+/**
+ * @brief Log a printf-style message to the binary log.
+ *
+ * The format must be a string literal: it is stored once in the log, with the file, line and
+ * argument types of the statement, and every message only records the id of the statement and
+ * the raw argument values. Integers, floating-point numbers, C strings and std::strings are
+ * accepted. Below the runtime level a statement costs one compare; above BINLOG_MAX_LEVEL it
+ * is compiled out.
+ */
+#define BINLOG(level, format, ...)                                                               \
+    do                                                                                           \
+    {                                                                                            \
+        if constexpr (static_cast<int>(level) <= BINLOG_MAX_LEVEL)                               \
+        {                                                                                        \
+            if (ns3::BinaryLog::IsEnabled(level))                                                \
+            {                                                                                    \
+                static const uint32_t binlogSite =                                               \
+                    ns3::BinaryLog::Get().RegisterSite(                                          \
+                        level,                                                                   \
+                        __FILE__,                                                                \
+                        __LINE__,                                                                \
+                        format,                                                                  \
+                        ns3::BinaryLog::SignatureOf(__VA_ARGS__));                               \
+                ns3::BinaryLog::Write(binlogSite __VA_OPT__(, ) __VA_ARGS__);                    \
+            }                                                                                    \
+        }                                                                                        \
+    } while (false)
+
+#define BINLOG_ERROR(...) BINLOG(ns3::BinaryLog::ERROR, __VA_ARGS__)
+#define BINLOG_WARN(...) BINLOG(ns3::BinaryLog::WARN, __VA_ARGS__)
+#define BINLOG_INFO(...) BINLOG(ns3::BinaryLog::INFO, __VA_ARGS__)
+#define BINLOG_DEBUG(...) BINLOG(ns3::BinaryLog::DEBUG, __VA_ARGS__)
+
+namespace ns3
+{
+
+/**
+ * @brief Structured binary event log, decoded offline by binlog_decode.py.
+ *
+ * Messages are appended to a buffer of the calling thread, as (statement id, payload size,
+ * wall-clock ns, raw arguments), and the buffer goes to the file in one write when full, at
+ * Close() and at the exit of the thread. Statements are described once in the file, when
+ * first reached, so a message costs a few stores instead of a formatting pass and a write().
+ *
+ * File layout, little endian: "NRBINLOG", then chunks of (type, 3 padding bytes, u32 size,
+ * payload). 'S' chunks describe a statement: u32 id, u32 level, u32 line, then the file, the
+ * format and the argument types ('i' int64, 'u' uint64, 'f' double, 's' u32 size and bytes),
+ * each NUL-terminated. 'R' chunks hold u32 thread, then the messages of that thread.
+ */
+class BinaryLog
+{
+  public:
+    /// Severity of a statement, the lower the more severe
+    enum Level
+    {
+        ERROR = 0,
+        WARN = 1,
+        INFO = 2,
+        DEBUG = 3,
+    };
+
+    /**
+     * @return the log of the process
+     */
+    static BinaryLog& Get()
+    {
+        static BinaryLog log;
+        return log;
+    }
+
+    /**
+     * @param level severity
+     * @return whether statements of that severity are recorded
+     */
+    static bool IsEnabled(Level level)
+    {
+        return static_cast<int>(level) <= g_level;
+    }
+
+    /**
+     * @brief Parse a level name.
+     * @param name error, warn, info or debug
+     * @param level the level, if the name is known
+     * @return whether the name is known
+     */
+    static bool ParseLevel(const std::string& name, Level& level)
+    {
+        static const char* const names[] = {"error", "warn", "info", "debug"};
+        for (int i = ERROR; i <= DEBUG; ++i)
+        {
+            if (name == names[i])
+            {
+                level = static_cast<Level>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Start recording the statements up to a severity into a file.
+     * @param path the file, truncated
+     * @param level most verbose level recorded
+     * @return whether the file could be opened
+     */
+    bool Open(const std::string& path, Level level)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CloseFile();
+        m_file = std::fopen(path.c_str(), "wb");
+        if (!m_file)
+        {
+            return false;
+        }
+        std::fwrite(MAGIC, 1, sizeof(MAGIC), m_file);
+        // Statements reached before (or by an earlier file) are described again
+        for (const std::string& site : m_sites)
+        {
+            WriteChunk('S', site.data(), site.size());
+        }
+        g_level = level;
+        return true;
+    }
+
+    /**
+     * @brief Flush the buffers of every thread and close the file.
+     *
+     * The other threads must not log meanwhile.
+     */
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        g_level = -1;
+        CloseFile();
+    }
+
+    /**
+     * @return messages recorded so far
+     */
+    uint64_t GetMessages() const
+    {
+        return m_messages;
+    }
+
+    /**
+     * @brief Describe a statement; called once per statement, when first reached.
+     * @param level severity
+     * @param file source file
+     * @param line source line
+     * @param format printf-style format
+     * @param signature argument types
+     * @return the id of the statement
+     */
+    uint32_t RegisterSite(Level level,
+                          const char* file,
+                          uint32_t line,
+                          const char* format,
+                          const char* signature)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint32_t id = m_sites.size();
+        std::string site;
+        Append(site, id);
+        Append(site, static_cast<uint32_t>(level));
+        Append(site, line);
+        for (const char* text : {file, format, signature})
+        {
+            site.append(text, std::strlen(text) + 1);
+        }
+        m_sites.push_back(site);
+        if (m_file)
+        {
+            WriteChunk('S', site.data(), site.size());
+        }
+        return id;
+    }
+
+    /**
+     * @param args arguments of a statement
+     * @return the type codes of the arguments, one character each
+     */
+    template <typename... Args>
+    static const char* SignatureOf(const Args&... /* args */)
+    {
+        static constexpr char signature[] = {TypeCode<std::decay_t<Args>>()..., '\0'};
+        return signature;
+    }
+
+    /**
+     * @brief Record a message of a statement in the buffer of the calling thread.
+     * @param site id of the statement
+     * @param args raw values of its arguments
+     */
+    template <typename... Args>
+    static void Write(uint32_t site, const Args&... args)
+    {
+        ThreadBuffer& buffer = GetThreadBuffer();
+        uint32_t payload = (0 + ... + ArgSize(args));
+        std::size_t offset = buffer.data.size();
+        buffer.data.resize(offset + MESSAGE_HEADER + payload);
+        char* out = buffer.data.data() + offset;
+        uint64_t wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+        Put(out, site);
+        Put(out, payload);
+        Put(out, wallNs);
+        (PutArg(out, args), ...);
+        buffer.messages++;
+        if (buffer.data.size() >= FLUSH_BYTES)
+        {
+            Get().Flush(buffer);
+        }
+    }
+
+  private:
+    static constexpr char MAGIC[8] = {'N', 'R', 'B', 'I', 'N', 'L', 'O', 'G'};
+    static constexpr std::size_t MESSAGE_HEADER = 16;     //!< Site, payload size, wall ns
+    static constexpr std::size_t FLUSH_BYTES = 1 << 20; //!< Buffer size written at once
+
+    /// Messages of one thread not written yet
+    struct ThreadBuffer
+    {
+        uint32_t thread{0};     //!< Index of the thread in the log
+        std::vector<char> data; //!< Chunk payload: thread index, then the messages
+        uint64_t messages{0};   //!< Messages in data
+
+        ThreadBuffer()
+        {
+            BinaryLog& log = BinaryLog::Get();
+            std::lock_guard<std::mutex> lock(log.m_mutex);
+            thread = log.m_threads++;
+            log.m_buffers.insert(this);
+            Reset();
+        }
+
+        ~ThreadBuffer()
+        {
+            BinaryLog& log = BinaryLog::Get();
+            log.Flush(*this);
+            std::lock_guard<std::mutex> lock(log.m_mutex);
+            log.m_buffers.erase(this);
+        }
+
+        /// Start a new chunk payload
+        void Reset()
+        {
+            data.clear();
+            data.reserve(FLUSH_BYTES + 4096);
+            data.resize(sizeof(thread));
+            std::memcpy(data.data(), &thread, sizeof(thread));
+            messages = 0;
+        }
+    };
+
+    BinaryLog() = default;
+
+    ~BinaryLog()
+    {
+        Close();
+    }
+
+    /**
+     * @return the buffer of the calling thread
+     */
+    static ThreadBuffer& GetThreadBuffer()
+    {
+        static thread_local ThreadBuffer buffer;
+        return buffer;
+    }
+
+    /**
+     * @return the type code of an argument type, see the file layout
+     */
+    template <typename T>
+    static constexpr char TypeCode()
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return 'f';
+        }
+        else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+        {
+            return std::is_signed_v<T> || std::is_enum_v<T> ? 'i' : 'u';
+        }
+        else
+        {
+            static_assert(std::is_convertible_v<T, std::string_view>,
+                          "BINLOG arguments are numbers or strings");
+            return 's';
+        }
+    }
+
+    /**
+     * @param arg an argument
+     * @return its size in a message
+     */
+    template <typename T>
+    static uint32_t ArgSize(const T& arg)
+    {
+        if constexpr (TypeCode<std::decay_t<T>>() == 's')
+        {
+            return sizeof(uint32_t) + std::string_view(arg).size();
+        }
+        else
+        {
+            return sizeof(uint64_t);
+        }
+    }
+
+    /**
+     * @brief Copy an argument into a message, numbers widened to 64 bits.
+     * @param out write position, advanced
+     * @param arg the argument
+     */
+    template <typename T>
+    static void PutArg(char*& out, const T& arg)
+    {
+        constexpr char code = TypeCode<std::decay_t<T>>();
+        if constexpr (code == 'f')
+        {
+            Put(out, static_cast<double>(arg));
+        }
+        else if constexpr (code == 'i')
+        {
+            Put(out, static_cast<int64_t>(arg));
+        }
+        else if constexpr (code == 'u')
+        {
+            Put(out, static_cast<uint64_t>(arg));
+        }
+        else
+        {
+            std::string_view text(arg);
+            Put(out, static_cast<uint32_t>(text.size()));
+            std::memcpy(out, text.data(), text.size());
+            out += text.size();
+        }
+    }
+
+    /**
+     * @brief Copy a value.
+     * @param out write position, advanced
+     * @param value the value
+     */
+    template <typename T>
+    static void Put(char*& out, T value)
+    {
+        std::memcpy(out, &value, sizeof(value));
+        out += sizeof(value);
+    }
+
+    /**
+     * @brief Append a value to a statement description.
+     * @param out the description
+     * @param value the value
+     */
+    static void Append(std::string& out, uint32_t value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    /**
+     * @brief Write the messages of a thread and empty its buffer.
+     * @param buffer the buffer
+     */
+    void Flush(ThreadBuffer& buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FlushLocked(buffer);
+    }
+
+    /**
+     * @brief Flush() with the mutex held.
+     * @param buffer the buffer
+     */
+    void FlushLocked(ThreadBuffer& buffer)
+    {
+        if (buffer.messages == 0)
+        {
+            return;
+        }
+        if (m_file)
+        {
+            WriteChunk('R', buffer.data.data(), buffer.data.size());
+            m_messages += buffer.messages;
+        }
+        buffer.Reset();
+    }
+
+    /**
+     * @brief Write a chunk, with the mutex held.
+     * @param type chunk type
+     * @param data payload
+     * @param size payload bytes
+     */
+    void WriteChunk(char type, const char* data, std::size_t size)
+    {
+        char header[8] = {type, 0, 0, 0};
+        uint32_t size32 = size;
+        std::memcpy(header + 4, &size32, sizeof(size32));
+        std::fwrite(header, 1, sizeof(header), m_file);
+        std::fwrite(data, 1, size, m_file);
+    }
+
+    /// Flush every thread and close the file, with the mutex held
+    void CloseFile()
+    {
+        for (ThreadBuffer* buffer : m_buffers)
+        {
+            FlushLocked(*buffer);
+        }
+        if (m_file)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    static inline int g_level = -1; //!< Most verbose level recorded, -1 when closed
+
+    std::mutex m_mutex;                //!< Guards the file, the sites and the buffers
+    std::FILE* m_file{nullptr};        //!< Log file
+    std::vector<std::string> m_sites;  //!< Description of every statement reached
+    std::set<ThreadBuffer*> m_buffers; //!< Buffers of the live threads
+    uint32_t m_threads{0};             //!< Threads that logged so far
+    uint64_t m_messages{0};            //!< Messages written
+};
+
+} // namespace ns3
+
+#endif // BINARY_LOG_H
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Decode the binary event log of the scenario (--logFile, see binary-log.h) into text.
+
+Every message is printed as "<seconds since the first message> <LEVEL> <file>:<line> <text>",
+in time order over all the threads, with its printf-style format applied to its arguments.
+
+Example:
+    ./binlog_decode.py channels-example.blog
+    ./binlog_decode.py channels-example.blog --level warn --grep RLC
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = b"NRBINLOG"
+LEVELS = ["ERROR", "WARN", "INFO", "DEBUG"]
+
+# printf length modifiers, meaningless once the arguments are Python numbers
+LENGTH_MODIFIER = re.compile(r"(%[-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t|L)([diouxXeEfgGcs])")
+
+
+class Site:
+    def __init__(self, payload):
+        self.id, self.level, self.line = struct.unpack_from("<III", payload)
+        self.file, self.format, self.signature = (
+            text.decode(errors="replace") for text in payload[12:].split(b"\0")[:3]
+        )
+        self.format = LENGTH_MODIFIER.sub(r"\1\2", self.format)
+
+
+def read_chunks(path):
+    """Yield (type, payload) for every chunk of a log file."""
+    with open(path, "rb") as f:
+        if f.read(len(MAGIC)) != MAGIC:
+            raise ValueError(f"{path} is not a binary event log")
+        while True:
+            header = f.read(8)
+            if len(header) < 8:
+                return
+            kind, size = chr(header[0]), struct.unpack_from("<I", header, 4)[0]
+            payload = f.read(size)
+            if len(payload) < size:
+                return  # truncated by a crash: keep what was complete
+            yield kind, payload
+
+
+def decode_args(signature, payload, offset):
+    """Return the arguments of a message, decoded from the raw payload."""
+    args = []
+    for code in signature:
+        if code == "s":
+            (size,) = struct.unpack_from("<I", payload, offset)
+            offset += 4
+            args.append(payload[offset : offset + size].decode(errors="replace"))
+            offset += size
+        else:
+            fmt = {"i": "<q", "u": "<Q", "f": "<d"}[code]
+            args.append(struct.unpack_from(fmt, payload, offset)[0])
+            offset += 8
+    return tuple(args)
+
+
+def decode(path):
+    """Return the (wall ns, thread, site, arguments) of every message, in time order."""
+    sites = {}
+    messages = []
+    for kind, payload in read_chunks(path):
+        if kind == "S":
+            site = Site(payload)
+            sites[site.id] = site
+        elif kind == "R":
+            (thread,) = struct.unpack_from("<I", payload)
+            offset = 4
+            while offset + 16 <= len(payload):
+                site_id, size, wall_ns = struct.unpack_from("<IIQ", payload, offset)
+                site = sites[site_id]
+                args = decode_args(site.signature, payload, offset + 16)
+                messages.append((wall_ns, thread, site, args))
+                offset += 16 + size
+    messages.sort(key=lambda m: (m[0], m[1]))
+    return messages
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", help="binary event log")
+    parser.add_argument("--level", choices=[l.lower() for l in LEVELS], default="debug")
+    parser.add_argument("--grep", help="only the messages matching this regular expression")
+    args = parser.parse_args()
+
+    max_level = LEVELS.index(args.level.upper())
+    pattern = re.compile(args.grep) if args.grep else None
+    messages = decode(args.log)
+    start = messages[0][0] if messages else 0
+    for wall_ns, thread, site, values in messages:
+        if site.level > max_level:
+            continue
+        try:
+            text = site.format % values
+        except (TypeError, ValueError):
+            text = f"{site.format} {values}"
+        text = text.rstrip("\n")
+        if pattern and not pattern.search(text):
+            continue
+        where = f"{os.path.basename(site.file)}:{site.line}"
+        thread_tag = f" [{thread}]" if thread else ""
+        print(f"{(wall_ns - start) / 1e9:.6f} {LEVELS[site.level]}{thread_tag} {where} {text}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef CRN_STREAMS_H
+#define CRN_STREAMS_H
+
+#include "ns3/abort.h"
+#include "ns3/channel-condition-model.h"
+#include "ns3/phased-array-spectrum-propagation-loss-model.h"
+#include "ns3/pointer.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/spectrum-channel.h"
+
+#include <cstdint>
+
+namespace ns3
+{
+
+/**
+ * @brief Random stream numbers pinned by semantic role, for common random numbers.
+ *
+ * AssignStreams hands out consecutive stream numbers in installation order, so the streams of
+ * the UE traffic or the shadowing shift whenever a variant creates one more object or one
+ * object draws one more stream. Here every role owns a block of 2^40 streams and every entity
+ * of the role (UE, gNB, channel) a fixed slice of ENTITY_SPAN streams in it: two runs with the
+ * same seed and run number then draw, for instance, the arrivals of UE 3 from the same
+ * substream whatever their channel or error models, and paired comparisons of the variants
+ * share that randomness.
+ *
+ * The draws of one stream are still consumed in event order: a role shares its samples
+ * across the variants as long as they make its draws in the same order (the shadowing of the
+ * links is drawn as the links are first used, for instance).
+ */
+class CrnStreams
+{
+  public:
+    /// Consumers of random numbers, each with its own block of streams
+    enum Role : uint32_t
+    {
+        MOBILITY,          //!< UE drop of the hexagonal grid
+        TRAFFIC,           //!< Arrival process of the gaming flow of a UE
+        SHADOWING,         //!< Pathloss model of a channel (shadowing, O2I losses)
+        LOS_CONDITION,     //!< Channel condition model of a channel
+        FAST_FADING,       //!< Small-scale fading of a channel
+        UE_DEVICE,         //!< NR stack of a UE: TB errors (HARQ), random access
+        GNB_DEVICE,        //!< NR stack of a gNB: TB errors (HARQ), scheduler
+    };
+
+    /// Streams reserved for one entity of a role
+    static constexpr int64_t ENTITY_SPAN = 1 << 12;
+
+    /**
+     * @brief First stream of an entity of a role.
+     * @param role the consumer
+     * @param entity index of the UE, gNB or channel
+     * @return the stream number
+     */
+    static int64_t Get(Role role, uint32_t entity)
+    {
+        // Block 0 is left to the order-dependent numbering of the default mode
+        return (static_cast<int64_t>(role) + 1) * ROLE_SPAN +
+               static_cast<int64_t>(entity) * ENTITY_SPAN;
+    }
+
+    /**
+     * @brief Check that an entity did not use more streams than its slice.
+     * @param role the consumer
+     * @param used streams assigned from Get(role, entity)
+     */
+    static void CheckSpan(Role role, int64_t used)
+    {
+        NS_ABORT_MSG_IF(used > ENTITY_SPAN,
+                        "Role " << role << " used " << used << " streams, more than "
+                                << ENTITY_SPAN);
+    }
+
+    /**
+     * @brief Pin the streams of the propagation models of a channel.
+     * @param channel the spectrum channel
+     * @param index position of the channel, stable across the variants
+     */
+    static void AssignChannel(Ptr<SpectrumChannel> channel, uint32_t index)
+    {
+        PointerValue pathloss;
+        channel->GetAttribute("PropagationLossModel", pathloss);
+        if (Ptr<PropagationLossModel> model = pathloss.Get<PropagationLossModel>())
+        {
+            CheckSpan(SHADOWING, model->AssignStreams(Get(SHADOWING, index)));
+            // ThreeGpp, NYU and TwoRay pathlosses share the LOS condition with the fading
+            PointerValue condition;
+            if (model->GetAttributeFailSafe("ChannelConditionModel", condition) &&
+                condition.Get<ChannelConditionModel>())
+            {
+                CheckSpan(LOS_CONDITION,
+                          condition.Get<ChannelConditionModel>()->AssignStreams(
+                              Get(LOS_CONDITION, index)));
+            }
+        }
+        PointerValue fading;
+        channel->GetAttribute("PhasedArraySpectrumPropagationLossModel", fading);
+        if (Ptr<PhasedArraySpectrumPropagationLossModel> model =
+                fading.Get<PhasedArraySpectrumPropagationLossModel>())
+        {
+            CheckSpan(FAST_FADING, model->AssignStreams(Get(FAST_FADING, index)));
+        }
+    }
+
+  private:
+    /// Streams of one role, far below the 2^63 of the automatic numbering
+    static constexpr int64_t ROLE_SPAN = int64_t{1} << 40;
+};
+
+} // namespace ns3
+
+#endif // CRN_STREAMS_H
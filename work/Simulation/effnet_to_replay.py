@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""Extract per-RNTI byte arrivals from Effnet DU L2 logs into a binary traffic trace.
+
+The scenario replays the trace with --replayTrace (see traffic-trace-replay.h). Every decoded
+shared-channel transport block of the logs becomes one record (time, RNTI, bytes):
+ULSCH_DECODE_REPORT descriptors, and the DLSCH reports of the same form. Blocks that failed
+their CRC are skipped, since the HARQ retransmission carries the same bytes again. The
+direction to extract has to be given: the scenario replays every record as a downlink arrival
+towards its UE, so uplink blocks (--direction ul or all) are only taken with --ul-as-dl, which
+accepts that they are replayed as downlink traffic. Times are the nanosecond timestamps of the
+log lines. The records of every RNTI are stored together, by time, behind an index in the
+header, so that each UE of the replay reads its own RNTI without buffering the records of the
+others.
+
+The records are never all in memory: they are sorted in runs of --run-records, spilled to
+temporary files next to the output, and merged, so captures larger than RAM convert as well.
+
+Any other capture can be replayed by converting it to "time_ns,rnti,bytes" lines first.
+
+Example:
+    ./effnet_to_replay.py du-l2.log --direction dl -o du-l2.replay
+    ./effnet_to_replay.py du-l2.log --direction all --ul-as-dl -o du-l2-all.replay
+    ./effnet_to_replay.py arrivals.csv --csv -o arrivals.replay
+"""
+
+import argparse
+import heapq
+import itertools
+import os
+import re
+import shutil
+import struct
+import sys
+import tempfile
+
+MAGIC = b"NRREPLAY"
+VERSION = 2
+RECORD = struct.Struct("<QII")  # time_ns, rnti, bytes, as in the trace
+RUN_RECORD = struct.Struct("<IQQI")  # rnti, time_ns, input position, bytes: the sort order
+RUN_RECORDS = 1 << 20  # records sorted in memory at a time
+MERGE_FANIN = 64  # runs merged at a time
+
+REPORT = re.compile(r"^(\d+)\s+\S+\s+(UL|DL)SCH_\w*REPORT\{(.*)\}\s*$")
+DESCRIPTOR = re.compile(r"\{([^{}]*)\}")
+FIELD = re.compile(r"(\w+):\s*([-\w.]+)")
+
+
+def parse_effnet(lines, directions):
+    """Yield (time_ns, rnti, bytes) for every decoded transport block of the directions."""
+    for line in lines:
+        match = REPORT.match(line.strip())
+        if not match or match.group(2) not in directions:
+            continue
+        time_ns = int(match.group(1))
+        for descriptor in DESCRIPTOR.findall(match.group(3)):
+            fields = dict(FIELD.findall(descriptor))
+            if "RNTI" not in fields or "transportBlockSize" not in fields:
+                continue
+            if fields.get("crcPass", "1") != "1":
+                continue
+            yield time_ns, int(fields["RNTI"]), int(fields["transportBlockSize"])
+
+
+def parse_csv(lines):
+    """Yield (time_ns, rnti, bytes) from "time_ns,rnti,bytes" lines; # starts a comment."""
+    for line in lines:
+        line = line.split("#", 1)[0].strip()
+        if line:
+            time_ns, rnti, size = (int(v) for v in line.split(","))
+            yield time_ns, rnti, size
+
+
+def write_run(path, records):
+    """Write (rnti, time_ns, position, bytes) records to a run file."""
+    with open(path, "wb") as f:
+        for record in records:
+            f.write(RUN_RECORD.pack(*record))
+
+
+def read_run(path):
+    """Yield the (rnti, time_ns, position, bytes) records of a run file."""
+    with open(path, "rb") as f:
+        while True:
+            data = f.read(RUN_RECORD.size * 4096)
+            if not data:
+                return
+            yield from RUN_RECORD.iter_unpack(data)
+
+
+def sorted_runs(records, directory, run_records):
+    """Spill the records to run files sorted by (rnti, time_ns), merged down to MERGE_FANIN.
+
+    Records of an RNTI with the same time keep their input order, by their input position.
+    """
+    names = (os.path.join(directory, f"run{i}") for i in itertools.count())
+    positions = itertools.count()
+    runs = []
+    while True:
+        chunk = [
+            (rnti, time_ns, next(positions), size)
+            for time_ns, rnti, size in itertools.islice(records, run_records)
+        ]
+        if not chunk:
+            break
+        chunk.sort()
+        runs.append(next(names))
+        write_run(runs[-1], chunk)
+    while len(runs) > MERGE_FANIN:
+        merged = []
+        for i in range(0, len(runs), MERGE_FANIN):
+            merged.append(next(names))
+            write_run(merged[-1], heapq.merge(*(read_run(r) for r in runs[i:i + MERGE_FANIN])))
+            for run in runs[i:i + MERGE_FANIN]:
+                os.remove(run)
+        runs = merged
+    return runs
+
+
+def write_trace(path, records, run_records=RUN_RECORDS):
+    """Write records grouped by RNTI and sorted by time, in the format of MappedTrafficTrace.
+
+    The records are sorted through run files next to the output, so that at most run_records
+    of them are in memory. Return the RNTIs, the number of records, their bytes and the time
+    span they cover, or None, writing nothing, when there are no records.
+    """
+    directory = os.path.dirname(os.path.abspath(path))
+    with tempfile.TemporaryDirectory(prefix=".replay-", dir=directory) as tmp:
+        runs = sorted_runs(iter(records), tmp, run_records)
+        counts = {}
+        total = 0
+        first_time = last_time = None
+        # The index in front needs the counts: the records go to a body file first
+        body = os.path.join(tmp, "body")
+        with open(body, "wb") as f:
+            for rnti, time_ns, _, size in heapq.merge(*(read_run(r) for r in runs)):
+                f.write(RECORD.pack(time_ns, rnti, size))
+                counts[rnti] = counts.get(rnti, 0) + 1
+                total += size
+                first_time = time_ns if first_time is None else min(first_time, time_ns)
+                last_time = time_ns if last_time is None else max(last_time, time_ns)
+        if not counts:
+            return None
+        rntis = sorted(counts)
+        num_records = sum(counts.values())
+        with open(path, "wb") as f:
+            f.write(MAGIC)
+            f.write(struct.pack("<IIQ", VERSION, len(rntis), num_records))
+            first = 0
+            for rnti in rntis:
+                f.write(struct.pack("<IIQQ", rnti, 0, first, counts[rnti]))
+                first += counts[rnti]
+            with open(body, "rb") as records_file:
+                shutil.copyfileobj(records_file, f)
+    return rntis, num_records, total, (last_time - first_time) / 1e9
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="+", help="Effnet DU logs, or CSV files with --csv")
+    parser.add_argument("-o", "--output", required=True, help="binary traffic trace to write")
+    parser.add_argument(
+        "--direction",
+        choices=("ul", "dl", "all"),
+        help="transport blocks to extract from Effnet logs; required without --csv",
+    )
+    parser.add_argument(
+        "--ul-as-dl",
+        action="store_true",
+        help="accept uplink blocks, which the scenario replays as downlink arrivals",
+    )
+    parser.add_argument("--csv", action="store_true", help="inputs are time_ns,rnti,bytes lines")
+    parser.add_argument(
+        "--run-records",
+        type=int,
+        default=RUN_RECORDS,
+        help="records sorted in memory at a time (default %(default)s)",
+    )
+    args = parser.parse_args()
+    if args.csv and args.direction:
+        parser.error("--direction applies to Effnet logs, not to --csv inputs")
+    if not args.csv and not args.direction:
+        parser.error("--direction is required: dl, or ul/all with --ul-as-dl")
+    if args.direction in ("ul", "all") and not args.ul_as_dl:
+        parser.error(
+            f"--direction {args.direction} takes uplink blocks, which the scenario replays as "
+            "downlink arrivals: add --ul-as-dl to accept that"
+        )
+    if args.run_records < 1:
+        parser.error("--run-records must be positive")
+
+    directions = {"ul": {"UL"}, "dl": {"DL"}, "all": {"UL", "DL"}}.get(args.direction)
+
+    def records():
+        for path in args.input:
+            with open(path, errors="replace") as f:
+                yield from parse_csv(f) if args.csv else parse_effnet(f, directions)
+
+    summary = write_trace(args.output, records(), args.run_records)
+    if summary is None:
+        print("no transport blocks found", file=sys.stderr)
+        return 1
+    rntis, num_records, total, span = summary
+    print(
+        f"{num_records} records of {len(rntis)} RNTIs over {span:.3f} s, "
+        f"{total / 1e6:.3f} MB, written to {args.output}"
+    )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,362 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXTERNAL_MCS_CONTROL_H
+#define EXTERNAL_MCS_CONTROL_H
+
+#include "binary-log.h"
+#include "mcs-agent-channel.h"
+#include "run-record.h"
+
+#include "ns3/config.h"
+#include "ns3/event-id.h"
+#include "ns3/net-device-container.h"
+#include "ns3/nr-amc.h"
+#include "ns3/nr-mac-scheduler-tdma-rr.h"
+#include "ns3/nr-phy-mac-common.h"
+#include "ns3/nr-ue-net-device.h"
+#include "ns3/nr-ue-rrc.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Closed loop between the DL link adaptation of the gNBs and an external agent.
+ *
+ * The observations of every UE are kept up to date as the run goes: SINR, MCS, redundancy
+ * version and HARQ outcome of every TB the UE receives (RxPacketTraceUe of its spectrum
+ * PHYs), wideband CQI and backlog whenever its gNB schedules it
+ * (NrMacSchedulerTdmaRrExternal). At every slot boundary they are published to the agent over
+ * an McsAgentChannel, and the MCS it answers with applies to the DL data the gNBs schedule
+ * until the next boundary. Without an answer before the timeout, or without any agent
+ * attached, the UEs go back to the MCS of the built-in NrAmc for that slot. A zero timeout
+ * runs the loop in lockstep: every slot waits for the agent while it is attached and alive
+ * (see McsAgentChannel).
+ *
+ * Only one instance is active at a time: the scheduler finds it through GetActive().
+ */
+class ExternalMcsControl
+{
+  public:
+    /// Largest MCS of the NR tables
+    static constexpr uint8_t MAX_MCS = 28;
+
+    ExternalMcsControl() = default;
+    ExternalMcsControl(const ExternalMcsControl&) = delete;
+    ExternalMcsControl& operator=(const ExternalMcsControl&) = delete;
+
+    ~ExternalMcsControl()
+    {
+        if (s_active == this)
+        {
+            s_active = nullptr;
+        }
+    }
+
+    /**
+     * @return the instance the schedulers report to, null if none is open
+     */
+    static ExternalMcsControl* GetActive()
+    {
+        return s_active;
+    }
+
+    /**
+     * @brief Create the shared region and connect the UE traces.
+     * @param name shared memory name, e.g. "/nr-mcs"
+     * @param ueDevices UE NR devices, in the order of the UE indexes
+     * @param timeout longest wait for the actions of a slot, zero for lockstep
+     * @return whether the region could be created
+     */
+    bool Open(const std::string& name, const NetDeviceContainer& ueDevices, Time timeout)
+    {
+        uint32_t numUes = ueDevices.GetN();
+        if (!m_channel.Create(name, numUes))
+        {
+            return false;
+        }
+        m_ueDevices = ueDevices;
+        m_timeout = std::chrono::nanoseconds(timeout.GetNanoSeconds());
+        m_observations.assign(numUes, McsAgentObservation{});
+        m_overrides.assign(numUes, McsAgentChannel::NO_OVERRIDE);
+        m_overridden.assign(numUes, false);
+        for (uint32_t i = 0; i < numUes; ++i)
+        {
+            m_observations[i].ue = i;
+        }
+        // Same defaults (error model, AMC model) as the AMC of the gNBs
+        m_amc = CreateObject<NrAmc>();
+        Config::ConnectWithoutContext(
+            "/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/NrUePhy/NrSpectrumPhyList/*/"
+            "RxPacketTraceUe",
+            MakeCallback(&ExternalMcsControl::RxPacket, this));
+        s_active = this;
+        BINLOG_INFO("MCS agent channel %s open for %u UEs", name, numUes);
+        return true;
+    }
+
+    /**
+     * @brief Schedule the requests, one per slot from the current simulated time.
+     * @param slot slot duration
+     */
+    void Start(Time slot)
+    {
+        m_slot = slot;
+        m_event = Simulator::Schedule(m_slot, &ExternalMcsControl::OnSlot, this);
+    }
+
+    /**
+     * @brief Record the state of a UE the scheduler considers and apply the agent's MCS.
+     *
+     * Called from the scheduler for every UE with DL data, before it gets resources; the MCS
+     * stays in the scheduler UE info until the next CQI, so once the agent stops overriding
+     * a UE the AMC MCS is put back.
+     *
+     * @param cellId cell of the scheduler
+     * @param ue scheduler state of the UE
+     * @param bufferBytes DL bytes waiting
+     */
+    void ApplyDl(uint16_t cellId, NrMacSchedulerUeInfo& ue, uint32_t bufferBytes)
+    {
+        uint32_t index = Lookup(cellId, ue.m_rnti);
+        if (index == NOT_FOUND)
+        {
+            return;
+        }
+        McsAgentObservation& obs = m_observations[index];
+        if (obs.cqi != ue.m_dlCqi.m_wbCqi || obs.cellId != cellId)
+        {
+            obs.cqi = ue.m_dlCqi.m_wbCqi;
+            obs.amcMcs = std::min<uint8_t>(m_amc->GetMcsFromCqi(obs.cqi), MAX_MCS);
+        }
+        obs.cellId = cellId;
+        obs.rnti = ue.m_rnti;
+        obs.bufferBytes = bufferBytes;
+        uint8_t mcs = m_overrides[index];
+        if (mcs != McsAgentChannel::NO_OVERRIDE)
+        {
+            ue.m_dlMcs = std::min(mcs, MAX_MCS);
+            m_overridden[index] = true;
+        }
+        else if (m_overridden[index])
+        {
+            ue.m_dlMcs = obs.amcMcs;
+            m_overridden[index] = false;
+        }
+    }
+
+    /**
+     * @brief Print the requests, the timeouts and the round-trip time to the agent.
+     */
+    void Print() const
+    {
+        printf("MCS agent: %lu requests, %lu answered, %lu timed out, %lu without agent, "
+               "round trip p50 %.1f us p99 %.1f us max %.1f us\n",
+               static_cast<unsigned long>(m_requests),
+               static_cast<unsigned long>(m_answered),
+               static_cast<unsigned long>(m_timeouts),
+               static_cast<unsigned long>(m_requests - m_answered - m_timeouts),
+               Percentile(0.5) / 1e3,
+               Percentile(0.99) / 1e3,
+               Percentile(1.0) / 1e3);
+    }
+
+    /**
+     * @return the request counters and round-trip times, for the benchmark JSON
+     */
+    RunRecord ToRecord() const
+    {
+        RunRecord record;
+        record.Set("requests", m_requests);
+        record.Set("answered", m_answered);
+        record.Set("timeouts", m_timeouts);
+        record.Set("roundTripP50Us", Percentile(0.5) / 1e3);
+        record.Set("roundTripP99Us", Percentile(0.99) / 1e3);
+        record.Set("roundTripMaxUs", Percentile(1.0) / 1e3);
+        return record;
+    }
+
+  private:
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX; //!< No UE with this cell and RNTI
+
+    /// Slot boundary: publish the observations, wait for the actions
+    void OnSlot()
+    {
+        McsAgentChannel::Header* header = m_channel.GetHeader();
+        std::memcpy(m_channel.GetObservations(),
+                    m_observations.data(),
+                    m_observations.size() * sizeof(McsAgentObservation));
+        for (McsAgentObservation& obs : m_observations)
+        {
+            obs.acks = 0;
+            obs.nacks = 0;
+            obs.rxBytes = 0;
+            obs.bufferBytes = 0;
+        }
+        m_requests++;
+        bool answered = false;
+        if (m_timeout.count() == 0)
+        {
+            m_channel.AwaitAgent();
+        }
+        if (header->agents.load(std::memory_order_relaxed) > 0)
+        {
+            // Checked for a dead agent by AwaitResponse() when no answer comes
+            auto start = std::chrono::steady_clock::now();
+            uint32_t seq = m_channel.Post(m_requests, Simulator::Now().GetNanoSeconds());
+            answered = m_channel.AwaitResponse(seq, m_timeout);
+            m_roundTripNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - start)
+                                        .count());
+            m_timeouts += answered ? 0 : 1;
+        }
+        if (answered)
+        {
+            m_answered++;
+            std::memcpy(m_overrides.data(), m_channel.GetActions(), m_overrides.size());
+        }
+        else
+        {
+            std::fill(m_overrides.begin(), m_overrides.end(), McsAgentChannel::NO_OVERRIDE);
+        }
+        m_event = Simulator::Schedule(m_slot, &ExternalMcsControl::OnSlot, this);
+    }
+
+    /**
+     * @brief Sink of RxPacketTraceUe: a DL TB received by a UE.
+     * @param params the TB
+     */
+    void RxPacket(RxPacketTraceParams params)
+    {
+        uint32_t index = Lookup(params.m_cellId, params.m_rnti);
+        if (index == NOT_FOUND)
+        {
+            return;
+        }
+        McsAgentObservation& obs = m_observations[index];
+        std::memmove(obs.sinrDb + 1,
+                     obs.sinrDb,
+                     (McsAgentObservation::SINR_HISTORY - 1) * sizeof(float));
+        obs.sinrDb[0] = static_cast<float>(10 * std::log10(params.m_sinr));
+        obs.lastMcs = params.m_mcs;
+        obs.lastRv = params.m_rv;
+        if (params.m_corrupt)
+        {
+            obs.nacks++;
+        }
+        else
+        {
+            obs.acks++;
+            obs.rxBytes += params.m_tbSize;
+        }
+    }
+
+    /**
+     * @param cellId cell of the UE
+     * @param rnti RNTI of the UE in that cell
+     * @return the UE index, NOT_FOUND if no UE is attached with this RNTI
+     */
+    uint32_t Lookup(uint16_t cellId, uint16_t rnti)
+    {
+        uint32_t key = (static_cast<uint32_t>(cellId) << 16) | rnti;
+        auto it = m_ues.find(key);
+        if (it != m_ues.end())
+        {
+            return it->second;
+        }
+        // RNTIs are given as the UEs attach: map them all again on the first miss
+        m_ues.clear();
+        for (uint32_t i = 0; i < m_ueDevices.GetN(); ++i)
+        {
+            Ptr<NrUeNetDevice> device = DynamicCast<NrUeNetDevice>(m_ueDevices.Get(i));
+            m_ues[(static_cast<uint32_t>(device->GetCellId()) << 16) |
+                  device->GetRrc()->GetRnti()] = i;
+        }
+        it = m_ues.find(key);
+        return it != m_ues.end() ? it->second : NOT_FOUND;
+    }
+
+    /**
+     * @param q quantile, 1 for the maximum
+     * @return the quantile of the round-trip times in ns, 0 without any
+     */
+    double Percentile(double q) const
+    {
+        if (m_roundTripNs.empty())
+        {
+            return 0.0;
+        }
+        std::vector<int64_t> values = m_roundTripNs;
+        std::size_t k = std::min(values.size() - 1, static_cast<std::size_t>(q * values.size()));
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return static_cast<double>(values[k]);
+    }
+
+    static inline ExternalMcsControl* s_active = nullptr; //!< Instance of the schedulers
+
+    McsAgentChannel m_channel;                       //!< Shared region
+    NetDeviceContainer m_ueDevices;                  //!< UE devices, by UE index
+    std::chrono::nanoseconds m_timeout{0};           //!< Longest wait for the actions
+    Time m_slot;                                     //!< Slot duration
+    Ptr<NrAmc> m_amc;                                //!< AMC MCS of the CQIs reported
+    std::vector<McsAgentObservation> m_observations; //!< Observations, by UE index
+    std::vector<uint8_t> m_overrides;                //!< MCS of the current slot, by UE index
+    std::vector<bool> m_overridden;                  //!< Whether the agent set the UE's MCS
+    std::unordered_map<uint32_t, uint32_t> m_ues;    //!< UE index by cell ID and RNTI
+    std::vector<int64_t> m_roundTripNs;              //!< Time of every request to an agent
+    uint64_t m_requests{0};                          //!< Slots published
+    uint64_t m_answered{0};                          //!< Slots answered in time
+    uint64_t m_timeouts{0};                          //!< Slots not answered in time
+    EventId m_event;                                 //!< Next slot boundary
+};
+
+/**
+ * @brief TDMA round-robin scheduler whose DL MCS the ExternalMcsControl decides.
+ *
+ * The resource allocation is that of NrMacSchedulerTdmaRR; only the MCS of each UE is
+ * replaced, before the UE gets its symbols, by the one the agent chose for the slot.
+ */
+class NrMacSchedulerTdmaRrExternal : public NrMacSchedulerTdmaRR
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::NrMacSchedulerTdmaRrExternal")
+                                .SetParent<NrMacSchedulerTdmaRR>()
+                                .SetGroupName("nr")
+                                .AddConstructor<NrMacSchedulerTdmaRrExternal>();
+        return tid;
+    }
+
+  protected:
+    void BeforeDlSched(const UePtrAndBufferReq& ue,
+                       const FTResources& assignableInEveryTbs) const override
+    {
+        NrMacSchedulerTdmaRR::BeforeDlSched(ue, assignableInEveryTbs);
+        if (ExternalMcsControl* control = ExternalMcsControl::GetActive())
+        {
+            control->ApplyDl(GetCellId(), *ue.first, ue.second);
+        }
+    }
+};
+
+NS_OBJECT_ENSURE_REGISTERED(NrMacSchedulerTdmaRrExternal);
+
+} // namespace ns3
+
+#endif // EXTERNAL_MCS_CONTROL_H
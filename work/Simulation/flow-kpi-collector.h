@@ -0,0 +1,418 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef FLOW_KPI_COLLECTOR_H
+#define FLOW_KPI_COLLECTOR_H
+
+#include "run-record.h"
+
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/tag.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Byte tag of a packet of a gaming flow: its sequence number in the flow and its send
+ *        time, as the tag of FlowMonitor.
+ *
+ * A byte tag follows the bytes of the packet through the RLC segments and concatenations,
+ * where the packet UID does not: the receiver of a PDU cuts all its SDUs out of one packet.
+ */
+class FlowKpiTag : public Tag
+{
+  public:
+    FlowKpiTag() = default;
+
+    /**
+     * @param sequence sequence number of the packet in its flow
+     * @param sent time step of the send
+     */
+    FlowKpiTag(uint64_t sequence, int64_t sent)
+        : m_sequence(sequence),
+          m_sent(sent)
+    {
+    }
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::FlowKpiTag")
+                                .SetParent<Tag>()
+                                .SetGroupName("Nr")
+                                .AddConstructor<FlowKpiTag>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize() const override
+    {
+        return 16;
+    }
+
+    void Serialize(TagBuffer i) const override
+    {
+        i.WriteU64(m_sequence);
+        i.WriteU64(static_cast<uint64_t>(m_sent));
+    }
+
+    void Deserialize(TagBuffer i) override
+    {
+        m_sequence = i.ReadU64();
+        m_sent = static_cast<int64_t>(i.ReadU64());
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "sequence=" << m_sequence << " sent=" << m_sent;
+    }
+
+    /// @return the sequence number of the packet in its flow
+    uint64_t GetSequence() const
+    {
+        return m_sequence;
+    }
+
+    /// @return the time step of the send
+    int64_t GetSent() const
+    {
+        return m_sent;
+    }
+
+  private:
+    uint64_t m_sequence{0}; //!< Sequence number in the flow
+    int64_t m_sent{0};      //!< Time step of the send
+};
+
+/**
+ * @brief Per-flow throughput, loss, delay and jitter, in flat arrays indexed by flow.
+ *
+ * A light replacement for FlowMonitor: instead of classifying every packet in maps, the
+ * traffic source reports (flow, packet, bytes) at send time and the receiver the same at
+ * delivery. The send tags the packet with a FlowKpiTag, the next sequence number of its flow
+ * and the send time, and marks that number in flight in a small ring per flow, at its slot
+ * modulo the ring size; the delivery reads the tag back, finds the slot of its number in
+ * O(1), and takes the delay from the send time of the tag. A delivery whose number is no
+ * longer in flight (delivered twice, or sent more than a ring ago) or without a tag is
+ * counted apart. Delays go to fixed-width histograms, from which the percentiles are read.
+ * Nothing is allocated after construction, apart from the tags.
+ */
+class FlowKpiCollector
+{
+  public:
+    /**
+     * @param numFlows flows, indexed from 0
+     * @param binWidth width of the delay histogram bins
+     * @param numBins bins of the delay histogram, the last one collecting all longer delays
+     */
+    explicit FlowKpiCollector(uint32_t numFlows,
+                              Time binWidth = MilliSeconds(1),
+                              uint32_t numBins = 200)
+        : m_numBins(numBins),
+          m_binWidthNs(binWidth.GetNanoSeconds()),
+          m_flows(numFlows),
+          m_ring(static_cast<std::size_t>(numFlows) * RING_SIZE, 0),
+          m_histogram(static_cast<std::size_t>(numFlows) * numBins, 0)
+    {
+    }
+
+    /**
+     * @return the number of flows
+     */
+    uint32_t GetNumFlows() const
+    {
+        return static_cast<uint32_t>(m_flows.size());
+    }
+
+    /**
+     * @brief A packet of a flow is being sent: tag it.
+     * @param flow flow index
+     * @param packet the packet, before any copy of it is passed on
+     * @param bytes application bytes
+     */
+    void RecordTx(uint32_t flow, Ptr<const Packet> packet, uint32_t bytes)
+    {
+        Flow& f = m_flows[flow];
+        int64_t now = Simulator::Now().GetTimeStep();
+        if (f.txPackets == 0)
+        {
+            f.firstTx = now;
+        }
+        uint64_t sequence = f.txPackets++;
+        f.txBytes += bytes;
+        // Overwrites the packet sent a ring ago: counted as lost if never delivered
+        m_ring[Slot(flow, sequence)] = sequence + 1;
+        packet->AddByteTag(FlowKpiTag(sequence, now));
+    }
+
+    /**
+     * @brief A packet of a flow has been delivered.
+     * @param flow flow index
+     * @param packet the packet, with the tag of its send
+     * @param bytes application bytes
+     */
+    void RecordRx(uint32_t flow, Ptr<const Packet> packet, uint32_t bytes)
+    {
+        Flow& f = m_flows[flow];
+        int64_t now = Simulator::Now().GetTimeStep();
+        f.rxPackets++;
+        f.rxBytes += bytes;
+        f.lastRx = now;
+        FlowKpiTag tag;
+        if (!packet->FindFirstMatchingByteTag(tag))
+        {
+            f.unmatched++; // Not sent by a flow
+            return;
+        }
+        uint64_t& inFlight = m_ring[Slot(flow, tag.GetSequence())];
+        if (inFlight != tag.GetSequence() + 1)
+        {
+            f.unmatched++; // Delivered twice, sent more than a ring ago, or by another flow
+            return;
+        }
+        inFlight = 0;
+        RecordDelay(flow, f, Time(now - tag.GetSent()).GetNanoSeconds());
+    }
+
+    /**
+     * @brief Write one line per flow: packets, loss, throughput, delay and jitter.
+     * @param path output file
+     */
+    void Write(const std::string& path) const
+    {
+        FILE* out = fopen(path.c_str(), "w");
+        if (!out)
+        {
+            return;
+        }
+        fprintf(out,
+                "flow\ttxPackets\trxPackets\tlossRatio\tthroughputMbps\tmeanDelayMs\t"
+                "p50DelayMs\tp95DelayMs\tp99DelayMs\tmaxDelayMs\tmeanJitterMs\n");
+        for (uint32_t i = 0; i < m_flows.size(); ++i)
+        {
+            const Flow& f = m_flows[i];
+            fprintf(out,
+                    "%u\t%lu\t%lu\t%.6f\t%.6f\t%.6f\t%.3f\t%.3f\t%.3f\t%.6f\t%.6f\n",
+                    i,
+                    static_cast<unsigned long>(f.txPackets),
+                    static_cast<unsigned long>(f.rxPackets),
+                    LossRatio(f),
+                    ThroughputMbps(f),
+                    f.delayed > 0 ? f.delaySumNs / f.delayed / 1e6 : 0.0,
+                    Percentile(i, 0.50),
+                    Percentile(i, 0.95),
+                    Percentile(i, 0.99),
+                    f.delayMaxNs / 1e6,
+                    f.delayed > 1 ? f.jitterSumNs / (f.delayed - 1) / 1e6 : 0.0);
+        }
+        fclose(out);
+    }
+
+    /**
+     * @brief Print the KPIs over all the flows.
+     */
+    void Print() const
+    {
+        Totals t = GetTotals();
+        printf("Flow KPIs (%zu flows): %lu/%lu packets delivered (%.2f%% lost), %.3f Mbps, "
+               "delay mean %.3f ms p95 %.3f ms p99 %.3f ms, jitter %.3f ms\n",
+               m_flows.size(),
+               static_cast<unsigned long>(t.rxPackets),
+               static_cast<unsigned long>(t.txPackets),
+               100.0 * t.lossRatio,
+               t.throughputMbps,
+               t.meanDelayMs,
+               t.p95DelayMs,
+               t.p99DelayMs,
+               t.meanJitterMs);
+    }
+
+    /**
+     * @return the KPIs over all the flows, for the benchmark record
+     */
+    RunRecord ToRecord() const
+    {
+        Totals t = GetTotals();
+        RunRecord record;
+        record.Set("flows", static_cast<uint64_t>(m_flows.size()));
+        record.Set("txPackets", t.txPackets);
+        record.Set("rxPackets", t.rxPackets);
+        record.Set("lossRatio", t.lossRatio);
+        record.Set("throughputMbps", t.throughputMbps);
+        record.Set("meanDelayMs", t.meanDelayMs);
+        record.Set("p95DelayMs", t.p95DelayMs);
+        record.Set("p99DelayMs", t.p99DelayMs);
+        record.Set("meanJitterMs", t.meanJitterMs);
+        return record;
+    }
+
+  private:
+    static constexpr uint64_t RING_SIZE = 256; //!< Packets in flight tracked per flow
+
+    /// Counters of one flow
+    struct Flow
+    {
+        uint64_t txPackets{0}; //!< Packets sent
+        uint64_t txBytes{0};   //!< Bytes sent
+        uint64_t rxPackets{0}; //!< Packets delivered
+        uint64_t rxBytes{0};   //!< Bytes delivered
+        uint64_t delayed{0};   //!< Deliveries matched to their send
+        uint64_t unmatched{0}; //!< Deliveries without a send in flight
+        double delaySumNs{0};  //!< Sum of the delays
+        double delayMaxNs{0};  //!< Largest delay
+        double jitterSumNs{0}; //!< Sum of the delay variations between deliveries
+        double lastDelayNs{0}; //!< Delay of the previous delivery
+        int64_t firstTx{0};    //!< Time step of the first send
+        int64_t lastRx{0};     //!< Time step of the last delivery
+    };
+
+    /// KPIs over all the flows
+    struct Totals
+    {
+        uint64_t txPackets{0};    //!< Packets sent
+        uint64_t rxPackets{0};    //!< Packets delivered
+        double lossRatio{0};      //!< Packets not delivered, over those sent
+        double throughputMbps{0}; //!< Sum of the flow throughputs
+        double meanDelayMs{0};    //!< Mean delay over all deliveries
+        double p95DelayMs{0};     //!< 95th percentile of all delays
+        double p99DelayMs{0};     //!< 99th percentile of all delays
+        double meanJitterMs{0};   //!< Mean delay variation over all deliveries
+    };
+
+    /**
+     * @param flow flow index
+     * @param sequence sequence number of a packet of the flow
+     * @return the index of its slot in m_ring
+     */
+    static std::size_t Slot(uint32_t flow, uint64_t sequence)
+    {
+        return static_cast<std::size_t>(flow) * RING_SIZE + sequence % RING_SIZE;
+    }
+
+    /// Account one matched delay
+    void RecordDelay(uint32_t flow, Flow& f, int64_t delayNs)
+    {
+        double delay = static_cast<double>(delayNs);
+        if (f.delayed > 0)
+        {
+            f.jitterSumNs += std::abs(delay - f.lastDelayNs);
+        }
+        f.lastDelayNs = delay;
+        f.delayed++;
+        f.delaySumNs += delay;
+        f.delayMaxNs = std::max(f.delayMaxNs, delay);
+        uint64_t bin = std::min<uint64_t>(delayNs / m_binWidthNs, m_numBins - 1);
+        m_histogram[static_cast<std::size_t>(flow) * m_numBins + bin]++;
+    }
+
+    /// @return the fraction of the packets sent that were not delivered
+    static double LossRatio(const Flow& f)
+    {
+        return f.txPackets > 0 && f.txPackets > f.rxPackets
+                   ? static_cast<double>(f.txPackets - f.rxPackets) / f.txPackets
+                   : 0.0;
+    }
+
+    /// @return the delivered bits per second, from the first send to the last delivery
+    static double ThroughputMbps(const Flow& f)
+    {
+        double seconds = Time(f.lastRx - f.firstTx).GetSeconds();
+        return seconds > 0 ? f.rxBytes * 8.0 / seconds / 1e6 : 0.0;
+    }
+
+    /**
+     * @param counts histogram
+     * @param total samples in the histogram
+     * @param quantile between 0 and 1
+     * @return the upper edge of the bin holding the quantile, in ms
+     */
+    double Quantile(const uint64_t* counts, uint64_t total, double quantile) const
+    {
+        if (total == 0)
+        {
+            return 0.0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * total));
+        uint64_t seen = 0;
+        for (uint32_t bin = 0; bin < m_numBins; ++bin)
+        {
+            seen += counts[bin];
+            if (seen >= rank)
+            {
+                return (bin + 1) * m_binWidthNs / 1e6;
+            }
+        }
+        return m_numBins * m_binWidthNs / 1e6;
+    }
+
+    /// @return a delay percentile of one flow, in ms
+    double Percentile(uint32_t flow, double quantile) const
+    {
+        return Quantile(&m_histogram[static_cast<std::size_t>(flow) * m_numBins],
+                        m_flows[flow].delayed,
+                        quantile);
+    }
+
+    /// @return the KPIs over all the flows
+    Totals GetTotals() const
+    {
+        Totals t;
+        std::vector<uint64_t> histogram(m_numBins, 0);
+        uint64_t delayed = 0;
+        double delaySum = 0;
+        double jitterSum = 0;
+        uint64_t jitterSamples = 0;
+        for (uint32_t i = 0; i < m_flows.size(); ++i)
+        {
+            const Flow& f = m_flows[i];
+            t.txPackets += f.txPackets;
+            t.rxPackets += f.rxPackets;
+            t.throughputMbps += ThroughputMbps(f);
+            delayed += f.delayed;
+            delaySum += f.delaySumNs;
+            jitterSum += f.jitterSumNs;
+            jitterSamples += f.delayed > 1 ? f.delayed - 1 : 0;
+            for (uint32_t bin = 0; bin < m_numBins; ++bin)
+            {
+                histogram[bin] += m_histogram[static_cast<std::size_t>(i) * m_numBins + bin];
+            }
+        }
+        if (t.txPackets > t.rxPackets)
+        {
+            t.lossRatio = static_cast<double>(t.txPackets - t.rxPackets) / t.txPackets;
+        }
+        t.meanDelayMs = delayed > 0 ? delaySum / delayed / 1e6 : 0.0;
+        t.p95DelayMs = Quantile(histogram.data(), delayed, 0.95);
+        t.p99DelayMs = Quantile(histogram.data(), delayed, 0.99);
+        t.meanJitterMs = jitterSamples > 0 ? jitterSum / jitterSamples / 1e6 : 0.0;
+        return t;
+    }
+
+    uint32_t m_numBins;                //!< Bins of every delay histogram
+    int64_t m_binWidthNs;              //!< Width of the bins
+    std::vector<Flow> m_flows;         //!< Counters per flow
+    std::vector<uint64_t> m_ring;      //!< Sequence number + 1 in flight, 0 if none, per slot
+    std::vector<uint64_t> m_histogram; //!< Delay histograms, m_numBins per flow
+};
+
+NS_OBJECT_ENSURE_REGISTERED(FlowKpiTag);
+
+} // namespace ns3
+
+#endif // FLOW_KPI_COLLECTOR_H
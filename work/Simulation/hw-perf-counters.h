@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef HW_PERF_COUNTERS_H
+#define HW_PERF_COUNTERS_H
+
+/**
+ * @file
+ * Hardware performance counters of the calling thread, read through perf_event_open(2).
+ *
+ * Only user-space events are counted, which works with the default perf_event_paranoid
+ * setting of 2. Counters the CPU or the hypervisor does not expose are reported as missing
+ * instead of failing, and on other platforms no counter is available at all.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ns3
+{
+
+/**
+ * @brief Values of the hardware counters, or their difference between two reads.
+ *
+ * A read holds the raw counts with the times the counters were enabled and running. When
+ * the counters share the PMU with other events, they only run part of the time: the
+ * difference of two reads scales the raw count difference by the ratio of the enabled and
+ * running time differences, so both ends are extrapolated over the same interval.
+ */
+struct HwCounterValues
+{
+    /// The counted events
+    enum Counter
+    {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        NUM_COUNTERS
+    };
+
+    uint64_t value[NUM_COUNTERS]{};   //!< Raw counts of a read, scaled counts of a difference
+    uint64_t enabled[NUM_COUNTERS]{}; //!< Time enabled in ns
+    uint64_t running[NUM_COUNTERS]{}; //!< Time running in ns, at most the time enabled
+    bool valid[NUM_COUNTERS]{};       //!< Whether each counter is available
+
+    /**
+     * @return whether at least one counter is available
+     */
+    bool Any() const
+    {
+        for (bool v : valid)
+        {
+            if (v)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @return instructions per cycle, or 0 if either counter is missing
+     */
+    double Ipc() const
+    {
+        return valid[CYCLES] && valid[INSTRUCTIONS] && value[CYCLES] > 0
+                   ? static_cast<double>(value[INSTRUCTIONS]) / value[CYCLES]
+                   : 0.0;
+    }
+
+    /**
+     * @param later a later read of the same counters
+     * @return the counts between this read and the later one; a counter that did not run in
+     *         between is invalid
+     */
+    HwCounterValues Until(const HwCounterValues& later) const
+    {
+        HwCounterValues delta;
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+        {
+            if (!valid[i] || !later.valid[i] || later.running[i] <= running[i])
+            {
+                continue;
+            }
+            delta.valid[i] = true;
+            delta.enabled[i] = later.enabled[i] - enabled[i];
+            delta.running[i] = later.running[i] - running[i];
+            uint64_t raw = later.value[i] - value[i];
+            // Extrapolate if the counter shared the PMU with other events in between
+            delta.value[i] = delta.running[i] < delta.enabled[i]
+                                 ? static_cast<uint64_t>(static_cast<double>(raw) *
+                                                         delta.enabled[i] / delta.running[i])
+                                 : raw;
+        }
+        return delta;
+    }
+
+    /**
+     * @brief Add the counts of another interval.
+     * @param other the counts to add
+     * @return this object
+     */
+    HwCounterValues& operator+=(const HwCounterValues& other)
+    {
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+        {
+            valid[i] = valid[i] || other.valid[i];
+            value[i] += other.value[i];
+            enabled[i] += other.enabled[i];
+            running[i] += other.running[i];
+        }
+        return *this;
+    }
+
+    /**
+     * @param counter a counter
+     * @return its name
+     */
+    static const char* Name(int counter)
+    {
+        static const char* names[NUM_COUNTERS] = {"cycles",
+                                                  "instructions",
+                                                  "llcMisses",
+                                                  "branchMisses"};
+        return names[counter];
+    }
+};
+
+/**
+ * @brief Free-running hardware counters of the calling thread.
+ *
+ * The counters start when the object is created; Read() returns their current values, so the
+ * cost of a piece of code is the difference between two reads (HwCounterValues::Until). A read is one system call per
+ * counter, about a microsecond in total.
+ */
+class HwPerfCounters
+{
+  public:
+    HwPerfCounters()
+    {
+#ifdef __linux__
+        static const uint64_t configs[HwCounterValues::NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES,
+        };
+        for (int i = 0; i < HwCounterValues::NUM_COUNTERS; ++i)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            m_fd[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (m_fd[i] < 0 && m_error.empty())
+            {
+                m_error = std::string(HwCounterValues::Name(i)) + ": " + std::strerror(errno);
+            }
+        }
+#else
+        m_error = "perf_event_open is only available on Linux";
+#endif
+    }
+
+    ~HwPerfCounters()
+    {
+#ifdef __linux__
+        for (int fd : m_fd)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    HwPerfCounters(const HwPerfCounters&) = delete;
+    HwPerfCounters& operator=(const HwPerfCounters&) = delete;
+
+    /**
+     * @return whether at least one counter could be opened
+     */
+    bool IsAvailable() const
+    {
+        for (int fd : m_fd)
+        {
+            if (fd >= 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @return why the first missing counter could not be opened, empty if all are available
+     */
+    const std::string& GetError() const
+    {
+        return m_error;
+    }
+
+    /**
+     * @return the current raw counter values, with their enabled and running times
+     */
+    HwCounterValues Read() const
+    {
+        HwCounterValues values;
+#ifdef __linux__
+        for (int i = 0; i < HwCounterValues::NUM_COUNTERS; ++i)
+        {
+            // value, time enabled, time running
+            uint64_t data[3];
+            if (m_fd[i] < 0 || read(m_fd[i], data, sizeof(data)) != sizeof(data))
+            {
+                continue;
+            }
+            values.valid[i] = true;
+            values.value[i] = data[0];
+            values.enabled[i] = data[1];
+            values.running[i] = data[2];
+        }
+#endif
+        return values;
+    }
+
+  private:
+    int m_fd[HwCounterValues::NUM_COUNTERS]{-1, -1, -1, -1}; //!< Counter file descriptors
+    std::string m_error;                                     //!< First opening error
+};
+
+} // namespace ns3
+
+#endif // HW_PERF_COUNTERS_H
@@ -0,0 +1,446 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef MCS_AGENT_CHANNEL_H
+#define MCS_AGENT_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace ns3
+{
+
+/**
+ * @brief Observation of one UE, published to the agent every slot (64 bytes).
+ */
+struct McsAgentObservation
+{
+    static constexpr uint32_t SINR_HISTORY = 8; //!< SINR samples kept per UE
+
+    uint32_t ue;                //!< UE index
+    uint16_t cellId;            //!< Serving cell, 0 until the UE was scheduled
+    uint16_t rnti;              //!< RNTI in that cell
+    float sinrDb[SINR_HISTORY]; //!< Average SINR of the last TBs received, newest first
+    uint32_t bufferBytes;       //!< DL bytes waiting at the last scheduling of the UE
+    uint8_t cqi;                //!< Last wideband CQI, 0 before the first report
+    uint8_t amcMcs;             //!< MCS the built-in AMC derives from that CQI
+    uint8_t lastMcs;            //!< MCS of the last TB received
+    uint8_t lastRv;             //!< Redundancy version of that TB
+    uint16_t acks;              //!< TBs decoded since the previous request
+    uint16_t nacks;             //!< TBs lost since the previous request
+    uint32_t rxBytes;           //!< Bytes of the TBs decoded since the previous request
+    uint32_t reserved[2];       //!< Zero
+};
+
+static_assert(sizeof(McsAgentObservation) == 64, "observations are one cache line");
+
+/**
+ * @brief Shared-memory request/response channel between the scenario and an external
+ *        link-adaptation agent.
+ *
+ * The region holds a 64-byte header, the observations of every UE (McsAgentObservation)
+ * and one action byte per UE: the DL MCS to use, or NO_OVERRIDE to leave the UE to the
+ * built-in AMC. Every slot, the scenario writes the observations, bumps the request sequence
+ * number and waits for the agent to write the actions and echo the number in the response
+ * word. Both words are futexes: a side that finds nothing to do spins briefly, then sleeps
+ * in the kernel until the other side wakes it, so a round trip costs a few microseconds
+ * between two busy processes and the scenario never polls a socket.
+ *
+ * The scenario creates the region (Create()) and removes it when destroyed; agents attach
+ * with Open() and record their process ID. A response that misses its deadline is ignored,
+ * the slot keeps the AMC MCS. Without a deadline (lockstep, e.g. to train a policy) the
+ * scenario waits for the first agent to attach, then for every answer as long as the agent
+ * is attached: once it detached, or died without detaching (its process is gone), the slots
+ * go back to the AMC without waiting. One agent answers at a time.
+ */
+class McsAgentChannel
+{
+  public:
+    static constexpr uint8_t NO_OVERRIDE = 0xff;  //!< Action keeping the AMC MCS
+    static constexpr uint32_t MAGIC = 0x4741524e; //!< "NRAG"
+    static constexpr uint32_t VERSION = 2;        //!< Layout version
+
+    /// Start of the shared region
+    struct alignas(64) Header
+    {
+        uint32_t magic;                 //!< MAGIC once the region is initialized
+        uint32_t version;               //!< VERSION
+        uint32_t numUes;                //!< Observations and actions in the region
+        uint32_t observationSize;       //!< sizeof(McsAgentObservation)
+        uint64_t slot;                  //!< Slot of the pending request
+        int64_t simTimeNs;              //!< Simulated time of the pending request
+        std::atomic<uint32_t> request;  //!< Sequence number of the last request (futex)
+        std::atomic<uint32_t> response; //!< Last sequence number answered (futex)
+        std::atomic<uint32_t> agents;   //!< Agents attached
+        std::atomic<uint32_t> closed;   //!< Set by the scenario at the end of the run
+        std::atomic<int32_t> agentPid;  //!< Process of the last agent attached, 0 if none
+    };
+
+    McsAgentChannel() = default;
+    McsAgentChannel(const McsAgentChannel&) = delete;
+    McsAgentChannel& operator=(const McsAgentChannel&) = delete;
+
+    ~McsAgentChannel()
+    {
+        if (m_header == nullptr)
+        {
+            return;
+        }
+        if (m_owner)
+        {
+            Close();
+            shm_unlink(m_name.c_str());
+        }
+        else
+        {
+            int32_t pid = getpid();
+            m_header->agentPid.compare_exchange_strong(pid, 0, std::memory_order_relaxed);
+            m_header->agents.fetch_sub(1, std::memory_order_relaxed);
+        }
+        munmap(m_header, m_size);
+    }
+
+    /**
+     * @param numUes UEs of the scenario
+     * @return bytes of the shared region
+     */
+    static std::size_t RegionSize(uint32_t numUes)
+    {
+        return sizeof(Header) + numUes * sizeof(McsAgentObservation) + numUes;
+    }
+
+    /**
+     * @brief Create the region, scenario side.
+     * @param name POSIX shared memory name, e.g. "/nr-mcs"
+     * @param numUes UEs of the scenario
+     * @return whether the region could be created
+     */
+    bool Create(const std::string& name, uint32_t numUes)
+    {
+        int fd = shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            return false;
+        }
+        m_size = RegionSize(numUes);
+        bool mapped = ftruncate(fd, m_size) == 0 && Map(fd);
+        close(fd);
+        if (!mapped)
+        {
+            shm_unlink(name.c_str());
+            return false;
+        }
+        m_name = name;
+        m_owner = true;
+        m_header->version = VERSION;
+        m_header->numUes = numUes;
+        m_header->observationSize = sizeof(McsAgentObservation);
+        std::memset(GetActions(), NO_OVERRIDE, numUes);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = MAGIC;
+        return true;
+    }
+
+    /**
+     * @brief Attach to the region of a running scenario, agent side.
+     * @param name name given to Create()
+     * @return whether a region of this layout version exists
+     */
+    bool Open(const std::string& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st{};
+        m_size = fstat(fd, &st) == 0 ? st.st_size : 0;
+        bool mapped = m_size >= sizeof(Header) && Map(fd);
+        close(fd);
+        if (!mapped)
+        {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_header->magic != MAGIC || m_header->version != VERSION ||
+            m_header->observationSize != sizeof(McsAgentObservation) ||
+            m_size < RegionSize(m_header->numUes))
+        {
+            munmap(m_header, m_size);
+            m_header = nullptr;
+            return false;
+        }
+        m_name = name;
+        m_header->agentPid.store(getpid(), std::memory_order_relaxed);
+        m_header->agents.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @return the header, null if the channel is not open
+     */
+    Header* GetHeader() const
+    {
+        return m_header;
+    }
+
+    /**
+     * @return the UEs of the region
+     */
+    uint32_t GetNumUes() const
+    {
+        return m_header->numUes;
+    }
+
+    /**
+     * @return the observation of every UE
+     */
+    McsAgentObservation* GetObservations() const
+    {
+        return reinterpret_cast<McsAgentObservation*>(reinterpret_cast<char*>(m_header) +
+                                                      sizeof(Header));
+    }
+
+    /**
+     * @return the action of every UE
+     */
+    uint8_t* GetActions() const
+    {
+        return reinterpret_cast<uint8_t*>(GetObservations() + m_header->numUes);
+    }
+
+    /**
+     * @brief Publish the observations written so far, scenario side.
+     * @param slot slot of the request
+     * @param simTimeNs simulated time of the request
+     * @return the sequence number the response must echo
+     */
+    uint32_t Post(uint64_t slot, int64_t simTimeNs)
+    {
+        m_header->slot = slot;
+        m_header->simTimeNs = simTimeNs;
+        uint32_t seq = m_header->request.load(std::memory_order_relaxed) + 1;
+        m_header->request.store(seq, std::memory_order_release);
+        Wake(m_header->request);
+        return seq;
+    }
+
+    /**
+     * @brief Wait for the agent to answer a request, scenario side.
+     * @param seq sequence number returned by Post()
+     * @param timeout longest wait, zero to wait as long as an agent is attached
+     * @return whether the actions were written in time
+     */
+    bool AwaitResponse(uint32_t seq, std::chrono::nanoseconds timeout)
+    {
+        if (timeout.count() > 0)
+        {
+            if (AwaitValue(m_header->response, seq, timeout))
+            {
+                return true;
+            }
+            HasAgent(); // A dead agent is not waited for again
+            return false;
+        }
+        while (!AwaitValue(m_header->response, seq, LOCKSTEP_CHECK))
+        {
+            if (!HasAgent())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Wait for the first agent to attach, scenario side; returns at once afterwards,
+     *        so that a run whose agent left goes on with the AMC.
+     */
+    void AwaitAgent()
+    {
+        while (!m_attached && m_header->agents.load(std::memory_order_relaxed) == 0)
+        {
+            std::this_thread::sleep_for(LOCKSTEP_CHECK);
+        }
+        m_attached = true;
+    }
+
+    /**
+     * @brief Whether an agent is attached, scenario side; an agent killed before it could
+     *        detach is detached here.
+     * @return false if no agent is attached
+     */
+    bool HasAgent()
+    {
+        if (m_header->agents.load(std::memory_order_relaxed) == 0)
+        {
+            return false;
+        }
+        int32_t pid = m_header->agentPid.load(std::memory_order_relaxed);
+        if (pid > 0 && kill(pid, 0) != 0 && errno == ESRCH)
+        {
+            m_header->agentPid.store(0, std::memory_order_relaxed);
+            m_header->agents.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Wait for the next request, agent side.
+     * @param last sequence number of the last request answered
+     * @return the sequence number of the new request, or 0 once the scenario closed
+     */
+    uint32_t AwaitRequest(uint32_t last)
+    {
+        while (!m_header->closed.load(std::memory_order_acquire))
+        {
+            uint32_t seq = m_header->request.load(std::memory_order_acquire);
+            if (seq != last)
+            {
+                return seq;
+            }
+            for (int i = 0; i < SPIN_ITERATIONS && m_header->request.load() == last; ++i)
+            {
+                CpuRelax();
+            }
+            if (m_header->request.load(std::memory_order_acquire) == last)
+            {
+                Futex(m_header->request, FUTEX_WAIT, last, nullptr);
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Publish the actions written so far, agent side.
+     * @param seq sequence number of the request answered
+     */
+    void Respond(uint32_t seq)
+    {
+        m_header->response.store(seq, std::memory_order_release);
+        Wake(m_header->response);
+    }
+
+    /**
+     * @brief Tell the agents the run is over, scenario side.
+     */
+    void Close()
+    {
+        m_header->closed.store(1, std::memory_order_release);
+        m_header->request.fetch_add(1, std::memory_order_release);
+        Wake(m_header->request);
+    }
+
+  private:
+    /// Polls of a futex word before sleeping on it, a few microseconds
+    static constexpr int SPIN_ITERATIONS = 100;
+    /// Period of the checks for an agent in lockstep
+    static constexpr std::chrono::milliseconds LOCKSTEP_CHECK{100};
+
+    /**
+     * @param fd descriptor of the shared memory object, m_size bytes
+     * @return whether it could be mapped
+     */
+    bool Map(int fd)
+    {
+        void* p = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            return false;
+        }
+        m_header = static_cast<Header*>(p);
+        return true;
+    }
+
+    /// Pause hint inside a spin loop
+    static void CpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    /**
+     * @brief futex(2) on a word shared between processes (hence not FUTEX_PRIVATE_FLAG).
+     * @param word the word
+     * @param op FUTEX_WAIT or FUTEX_WAKE
+     * @param value expected value (FUTEX_WAIT) or waiters to wake (FUTEX_WAKE)
+     * @param timeout relative timeout of FUTEX_WAIT, null to wait forever
+     */
+    static void Futex(std::atomic<uint32_t>& word, int op, uint32_t value, const timespec* timeout)
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), op, value, timeout, nullptr, 0);
+    }
+
+    /**
+     * @brief Wake every waiter of a word.
+     * @param word the word
+     */
+    static void Wake(std::atomic<uint32_t>& word)
+    {
+        Futex(word, FUTEX_WAKE, INT32_MAX, nullptr);
+    }
+
+    /**
+     * @param word a futex word
+     * @param value value to wait for
+     * @param timeout longest wait
+     * @return whether the word took the value in time
+     */
+    static bool AwaitValue(std::atomic<uint32_t>& word,
+                           uint32_t value,
+                           std::chrono::nanoseconds timeout)
+    {
+        for (int i = 0; i < SPIN_ITERATIONS; ++i)
+        {
+            if (word.load(std::memory_order_acquire) == value)
+            {
+                return true;
+            }
+            CpuRelax();
+        }
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true)
+        {
+            uint32_t seen = word.load(std::memory_order_acquire);
+            if (seen == value)
+            {
+                return true;
+            }
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            deadline - std::chrono::steady_clock::now())
+                            .count();
+            if (left <= 0)
+            {
+                return false;
+            }
+            timespec ts{static_cast<time_t>(left / 1000000000),
+                        static_cast<long>(left % 1000000000)};
+            Futex(word, FUTEX_WAIT, seen, &ts);
+        }
+    }
+
+    Header* m_header{nullptr}; //!< Mapped region
+    std::size_t m_size{0};     //!< Bytes mapped
+    std::string m_name;        //!< Shared memory name
+    bool m_owner{false};       //!< Whether this side created the region
+    bool m_attached{false};    //!< Whether an agent ever attached (scenario side)
+};
+
+} // namespace ns3
+
+#endif // MCS_AGENT_CHANNEL_H
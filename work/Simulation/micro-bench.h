@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+/**
+ * @file
+ * Minimal micro-benchmark harness, after the Google Benchmark API.
+ *
+ * A benchmark is a function taking a MicroBenchState and looping over it; the harness picks
+ * the number of iterations so that one repetition runs for a minimum time, repeats it and
+ * reports the median time per iteration:
+ *
+ *     static void BM_Foo(MicroBenchState& state)
+ *     {
+ *         Setup();
+ *         for (auto _ : state)
+ *         {
+ *             DoNotOptimize(Foo());
+ *         }
+ *     }
+ *     MICRO_BENCHMARK(BM_Foo);
+ *
+ * Work that must not be timed inside the loop goes between PauseTiming() and ResumeTiming().
+ */
+
+#include "run-record.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Keep the compiler from optimizing a value, and the computation behind it, away.
+ * @param value the value
+ */
+template <typename T>
+inline void
+DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Iteration state of one benchmark repetition.
+ */
+class MicroBenchState
+{
+  public:
+    using Clock = std::chrono::steady_clock; //!< Clock of the measurements
+
+    /**
+     * @param iterations iterations of the loop
+     */
+    explicit MicroBenchState(uint64_t iterations)
+        : m_iterations(iterations)
+    {
+    }
+
+    /// Loop variable of the benchmarks, marked unused so that `for (auto _ : state)` is quiet
+    struct __attribute__((unused)) Value
+    {
+    };
+
+    /// Range-for iterator counting the iterations down
+    struct Iterator
+    {
+        MicroBenchState* state; //!< The state, to stop the clock at the end
+        uint64_t left;          //!< Iterations left
+
+        /// @return a dummy value
+        Value operator*() const
+        {
+            return Value();
+        }
+
+        /// Count one iteration
+        Iterator& operator++()
+        {
+            --left;
+            return *this;
+        }
+
+        /**
+         * @return true while iterations are left; stops the clock after the last one
+         */
+        bool operator!=(const Iterator& /* end */)
+        {
+            if (left > 0)
+            {
+                return true;
+            }
+            state->Finish();
+            return false;
+        }
+    };
+
+    /// @return an iterator over the iterations, starting the clock
+    Iterator begin()
+    {
+        m_start = Clock::now();
+        return Iterator{this, m_iterations};
+    }
+
+    /// @return the end iterator
+    Iterator end()
+    {
+        return Iterator{this, 0};
+    }
+
+    /**
+     * @brief Stop the clock, e.g. to rebuild the input of the next iteration.
+     */
+    void PauseTiming()
+    {
+        m_elapsed += Clock::now() - m_start;
+    }
+
+    /**
+     * @brief Restart the clock after PauseTiming().
+     */
+    void ResumeTiming()
+    {
+        m_start = Clock::now();
+    }
+
+    /**
+     * @brief Set the items processed by all the iterations, to also report the time per item.
+     * @param items the items
+     */
+    void SetItemsProcessed(uint64_t items)
+    {
+        m_items = items;
+    }
+
+    /// @return the iterations of the loop
+    uint64_t GetIterations() const
+    {
+        return m_iterations;
+    }
+
+    /// @return the timed duration of the loop in ns
+    double GetElapsedNs() const
+    {
+        return std::chrono::duration<double, std::nano>(m_elapsed).count();
+    }
+
+    /// @return the items processed, 0 if not set
+    uint64_t GetItemsProcessed() const
+    {
+        return m_items;
+    }
+
+  private:
+    /// Stop the clock at the end of the loop
+    void Finish()
+    {
+        m_elapsed += Clock::now() - m_start;
+    }
+
+    uint64_t m_iterations;                    //!< Iterations of the loop
+    uint64_t m_items{0};                      //!< Items processed, if set
+    Clock::time_point m_start;                //!< Start of the running interval
+    Clock::duration m_elapsed{};               //!< Timed duration so far
+};
+
+/**
+ * @brief Result of a benchmark.
+ */
+struct MicroBenchResult
+{
+    std::string name;       //!< Benchmark name
+    uint64_t iterations{0}; //!< Iterations per repetition
+    double nsPerOp{0};      //!< Median time per iteration in ns
+    double minNsPerOp{0};   //!< Fastest repetition, per iteration
+    double maxNsPerOp{0};   //!< Slowest repetition, per iteration
+    double nsPerItem{0};    //!< Median time per item in ns, 0 if no items were set
+};
+
+/**
+ * @brief Registry and runner of the benchmarks of a program.
+ */
+class MicroBenchRunner
+{
+  public:
+    using Function = std::function<void(MicroBenchState&)>; //!< A benchmark
+
+    /**
+     * @return the benchmarks registered with MICRO_BENCHMARK
+     */
+    static std::vector<std::pair<std::string, Function>>& GetRegistry()
+    {
+        static std::vector<std::pair<std::string, Function>> registry;
+        return registry;
+    }
+
+    /**
+     * @brief Register a benchmark.
+     * @param name benchmark name
+     * @param function the benchmark
+     * @return a dummy value, for the static registration
+     */
+    static int Register(const std::string& name, Function function)
+    {
+        GetRegistry().emplace_back(name, std::move(function));
+        return 0;
+    }
+
+    /**
+     * @param minTimeSec minimum duration of one repetition
+     * @param repetitions repetitions of every benchmark; the median is reported
+     */
+    MicroBenchRunner(double minTimeSec, uint32_t repetitions)
+        : m_minTimeNs(minTimeSec * 1e9),
+          m_repetitions(std::max<uint32_t>(repetitions, 1))
+    {
+    }
+
+    /**
+     * @brief Run one benchmark.
+     *
+     * The iterations grow tenfold (at most) until one repetition lasts the minimum time,
+     * then the benchmark is repeated with that count.
+     *
+     * @param name benchmark name
+     * @param function the benchmark
+     * @return its result
+     */
+    MicroBenchResult Run(const std::string& name, const Function& function) const
+    {
+        uint64_t iterations = 1;
+        while (true)
+        {
+            MicroBenchState state(iterations);
+            function(state);
+            double elapsed = state.GetElapsedNs();
+            if (elapsed >= m_minTimeNs || iterations >= (1ULL << 40))
+            {
+                break;
+            }
+            double scale = elapsed > 0 ? 1.4 * m_minTimeNs / elapsed : 10.0;
+            iterations = static_cast<uint64_t>(iterations * std::clamp(scale, 2.0, 10.0));
+        }
+
+        std::vector<double> perOp;
+        std::vector<double> perItem;
+        for (uint32_t r = 0; r < m_repetitions; ++r)
+        {
+            MicroBenchState state(iterations);
+            function(state);
+            perOp.push_back(state.GetElapsedNs() / iterations);
+            if (state.GetItemsProcessed() > 0)
+            {
+                perItem.push_back(state.GetElapsedNs() / state.GetItemsProcessed());
+            }
+        }
+        std::sort(perOp.begin(), perOp.end());
+        std::sort(perItem.begin(), perItem.end());
+
+        MicroBenchResult result;
+        result.name = name;
+        result.iterations = iterations;
+        result.nsPerOp = perOp[perOp.size() / 2];
+        result.minNsPerOp = perOp.front();
+        result.maxNsPerOp = perOp.back();
+        result.nsPerItem = perItem.empty() ? 0.0 : perItem[perItem.size() / 2];
+        return result;
+    }
+
+    /**
+     * @brief Run the registered benchmarks whose name contains a filter, printing a table.
+     * @param filter substring of the names to run; empty for all
+     * @return the results
+     */
+    std::vector<MicroBenchResult> RunAll(const std::string& filter) const
+    {
+        printf("%-36s %14s %14s %12s %12s\n",
+               "Benchmark",
+               "ns/op",
+               "spread",
+               "iterations",
+               "ns/item");
+        std::vector<MicroBenchResult> results;
+        for (const auto& [name, function] : GetRegistry())
+        {
+            if (name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+            MicroBenchResult result = Run(name, function);
+            printf("%-36s %14.1f %13.1f%% %12lu %12.2f\n",
+                   result.name.c_str(),
+                   result.nsPerOp,
+                   result.nsPerOp > 0
+                       ? 100.0 * (result.maxNsPerOp - result.minNsPerOp) / result.nsPerOp
+                       : 0.0,
+                   static_cast<unsigned long>(result.iterations),
+                   result.nsPerItem);
+            fflush(stdout);
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    /**
+     * @param results benchmark results
+     * @return a record with one nested record per benchmark
+     */
+    static RunRecord ToRecord(const std::vector<MicroBenchResult>& results)
+    {
+        RunRecord record;
+        for (const MicroBenchResult& result : results)
+        {
+            RunRecord entry;
+            entry.Set("nsPerOp", result.nsPerOp);
+            entry.Set("minNsPerOp", result.minNsPerOp);
+            entry.Set("maxNsPerOp", result.maxNsPerOp);
+            entry.Set("iterations", result.iterations);
+            if (result.nsPerItem > 0)
+            {
+                entry.Set("nsPerItem", result.nsPerItem);
+            }
+            record.Set(result.name, entry);
+        }
+        return record;
+    }
+
+  private:
+    double m_minTimeNs;     //!< Minimum duration of one repetition in ns
+    uint32_t m_repetitions; //!< Repetitions of every benchmark
+};
+
+} // namespace ns3
+
+/// Register a benchmark function under its own name
+#define MICRO_BENCHMARK(function)                                                                  \
+    static int function##_registration [[maybe_unused]] =                                          \
+        ns3::MicroBenchRunner::Register(#function, function)
+
+#endif // MICRO_BENCH_H
@@ -0,0 +1,363 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef NODE_SPATIAL_INDEX_H
+#define NODE_SPATIAL_INDEX_H
+
+#include "ns3/abort.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/simulator.h"
+#include "ns3/vector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Uniform-grid spatial index over the positions of a set of nodes.
+ *
+ * Nodes are bucketed by the (x, y) cell of their position; queries expand ring by ring around
+ * the query cell and stop as soon as no unvisited cell can hold a closer node, so closest,
+ * k-nearest and radius queries cost O(nodes in the visited cells) instead of O(all nodes).
+ *
+ * The index follows the MobilityModel "CourseChange" trace of every node. Between course
+ * changes a node moving at constant velocity drifts away from the cell it was filed in; the
+ * queries widen their search by the largest possible drift and compare live positions, and
+ * the index re-files all nodes once the drift exceeds one cell. Results are therefore exact at
+ * any simulation time.
+ *
+ * Distances are 3D, as in NrHelper::AttachToClosestGnb, and ties are broken in favour of the
+ * node added first, so attaching through the index selects the same gNB.
+ *
+ * The index connects member callbacks to the mobility models: it must outlive the simulation.
+ */
+class NodeSpatialIndex
+{
+  public:
+    /**
+     * @brief Create an empty index.
+     * @param cellSize side of a grid cell in meters; a fraction of the inter-site distance
+     */
+    explicit NodeSpatialIndex(double cellSize)
+        : m_cellSize(cellSize)
+    {
+        NS_ABORT_MSG_IF(cellSize <= 0, "The cell size of the spatial index must be positive");
+    }
+
+    NodeSpatialIndex(const NodeSpatialIndex&) = delete;
+    NodeSpatialIndex& operator=(const NodeSpatialIndex&) = delete;
+
+    /**
+     * @brief Add nodes to the index and follow their course changes.
+     *
+     * Items are numbered in insertion order, starting from 0.
+     *
+     * @param nodes nodes with an aggregated MobilityModel
+     */
+    void Add(const NodeContainer& nodes)
+    {
+        for (uint32_t i = 0; i < nodes.GetN(); ++i)
+        {
+            Ptr<MobilityModel> mm = nodes.Get(i)->GetObject<MobilityModel>();
+            NS_ABORT_MSG_IF(!mm, "Node " << nodes.Get(i)->GetId() << " has no MobilityModel");
+            uint32_t index = m_items.size();
+            m_items.push_back({nodes.Get(i), mm, Vector(), 0, 0, Seconds(0)});
+            m_indexOf[PeekPointer(mm)] = index;
+            File(index);
+            mm->TraceConnectWithoutContext("CourseChange",
+                                           MakeCallback(&NodeSpatialIndex::CourseChanged, this));
+        }
+    }
+
+    /**
+     * @return the number of indexed nodes
+     */
+    uint32_t GetN() const
+    {
+        return m_items.size();
+    }
+
+    /**
+     * @param index item index
+     * @return the indexed node
+     */
+    Ptr<Node> GetNode(uint32_t index) const
+    {
+        return m_items.at(index).node;
+    }
+
+    /**
+     * @brief Find the node closest to a position.
+     * @param pos the query position
+     * @return the index of the closest node
+     */
+    uint32_t FindClosest(const Vector& pos)
+    {
+        std::vector<uint32_t> nearest = FindKNearest(pos, 1);
+        NS_ABORT_MSG_IF(nearest.empty(), "Closest-node query on an empty spatial index");
+        return nearest.front();
+    }
+
+    /**
+     * @brief Find the k nodes closest to a position.
+     * @param pos the query position
+     * @param k number of nodes requested
+     * @return up to k indices, closest first
+     */
+    std::vector<uint32_t> FindKNearest(const Vector& pos, uint32_t k)
+    {
+        std::vector<uint32_t> result;
+        if (k == 0 || m_items.empty())
+        {
+            return result;
+        }
+        const double drift = UpdateDrift();
+        const int64_t cx = CellCoord(pos.x);
+        const int64_t cy = CellCoord(pos.y);
+
+        // Max-heap of the best k candidates, ordered by (distance, index)
+        std::vector<std::pair<double, uint32_t>> best;
+        uint32_t visited = 0;
+        for (int64_t ring = 0;; ++ring)
+        {
+            ForEachInRing(cx, cy, ring, [&](uint32_t index) {
+                ++visited;
+                std::pair<double, uint32_t> candidate{
+                    CalculateDistance(pos, m_items[index].mobility->GetPosition()),
+                    index};
+                if (best.size() < k)
+                {
+                    best.push_back(candidate);
+                    std::push_heap(best.begin(), best.end());
+                }
+                else if (candidate < best.front())
+                {
+                    std::pop_heap(best.begin(), best.end());
+                    best.back() = candidate;
+                    std::push_heap(best.begin(), best.end());
+                }
+            });
+            // Nodes in outer rings were filed at least ring * cellSize away in the plane
+            const double bound = ring * m_cellSize - drift;
+            if (visited == m_items.size() || (best.size() == k && best.front().first < bound))
+            {
+                break;
+            }
+        }
+        std::sort_heap(best.begin(), best.end());
+        result.reserve(best.size());
+        for (const auto& entry : best)
+        {
+            result.push_back(entry.second);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Find all nodes within a distance of a position.
+     * @param pos the query position
+     * @param radius the distance in meters
+     * @return the indices of the nodes within the radius, in increasing index order
+     */
+    std::vector<uint32_t> FindWithinRadius(const Vector& pos, double radius)
+    {
+        std::vector<uint32_t> result;
+        const double reach = radius + UpdateDrift();
+        const int64_t x0 = CellCoord(pos.x - reach);
+        const int64_t x1 = CellCoord(pos.x + reach);
+        const int64_t y0 = CellCoord(pos.y - reach);
+        const int64_t y1 = CellCoord(pos.y + reach);
+        for (int64_t x = x0; x <= x1; ++x)
+        {
+            for (int64_t y = y0; y <= y1; ++y)
+            {
+                auto it = m_cells.find(CellKey(x, y));
+                if (it == m_cells.end())
+                {
+                    continue;
+                }
+                for (uint32_t index : it->second)
+                {
+                    if (CalculateDistance(pos, m_items[index].mobility->GetPosition()) <= radius)
+                    {
+                        result.push_back(index);
+                    }
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+  private:
+    /// Indexed node and the state it was filed with
+    struct Item
+    {
+        Ptr<Node> node;              //!< The node
+        Ptr<MobilityModel> mobility; //!< Its mobility model
+        Vector filedPosition;        //!< Position when filed
+        double speed;                //!< Speed when filed, in m/s
+        uint64_t cellKey;            //!< Cell it is filed in
+        Time filedAt;                //!< Simulation time when filed
+    };
+
+    /**
+     * @brief Re-file a node whose mobility model changed course.
+     * @param model the mobility model
+     */
+    void CourseChanged(Ptr<const MobilityModel> model)
+    {
+        auto it = m_indexOf.find(PeekPointer(model));
+        if (it == m_indexOf.end())
+        {
+            return;
+        }
+        Unfile(it->second);
+        File(it->second);
+    }
+
+    /**
+     * @brief Largest distance any node can have moved since it was filed.
+     *
+     * Re-files every node when the drift exceeds one cell, to keep the searches local.
+     *
+     * @return the drift in meters
+     */
+    double UpdateDrift()
+    {
+        if (m_maxSpeed == 0)
+        {
+            return 0;
+        }
+        double drift = m_maxSpeed * (Simulator::Now() - m_oldestFiling).GetSeconds();
+        if (drift > m_cellSize)
+        {
+            m_cells.clear();
+            m_maxSpeed = 0;
+            for (uint32_t i = 0; i < m_items.size(); ++i)
+            {
+                File(i);
+            }
+            drift = 0;
+        }
+        return drift;
+    }
+
+    /**
+     * @brief File a node in the cell of its current position.
+     * @param index item index
+     */
+    void File(uint32_t index)
+    {
+        Item& item = m_items[index];
+        item.filedPosition = item.mobility->GetPosition();
+        item.speed = item.mobility->GetVelocity().GetLength();
+        item.filedAt = Simulator::Now();
+        item.cellKey = CellKey(CellCoord(item.filedPosition.x), CellCoord(item.filedPosition.y));
+        if (item.speed > 0 && m_maxSpeed == 0)
+        {
+            // First moving node since the last re-filing: later filings are more recent, so
+            // the drift bound only needs this one
+            m_oldestFiling = item.filedAt;
+        }
+        m_maxSpeed = std::max(m_maxSpeed, item.speed);
+        std::vector<uint32_t>& cell = m_cells[item.cellKey];
+        cell.insert(std::upper_bound(cell.begin(), cell.end(), index), index);
+    }
+
+    /**
+     * @brief Remove a node from its cell.
+     * @param index item index
+     */
+    void Unfile(uint32_t index)
+    {
+        auto it = m_cells.find(m_items[index].cellKey);
+        if (it == m_cells.end())
+        {
+            return;
+        }
+        auto pos = std::lower_bound(it->second.begin(), it->second.end(), index);
+        if (pos != it->second.end() && *pos == index)
+        {
+            it->second.erase(pos);
+        }
+        if (it->second.empty())
+        {
+            m_cells.erase(it);
+        }
+    }
+
+    /**
+     * @brief Visit the nodes filed in the cells at Chebyshev distance ring from (cx, cy).
+     * @param cx cell column of the query
+     * @param cy cell row of the query
+     * @param ring ring number, 0 being the query cell itself
+     * @param visit callable invoked with every item index
+     */
+    template <typename F>
+    void ForEachInRing(int64_t cx, int64_t cy, int64_t ring, F&& visit) const
+    {
+        auto visitCell = [&](int64_t x, int64_t y) {
+            auto it = m_cells.find(CellKey(x, y));
+            if (it != m_cells.end())
+            {
+                for (uint32_t index : it->second)
+                {
+                    visit(index);
+                }
+            }
+        };
+        if (ring == 0)
+        {
+            visitCell(cx, cy);
+            return;
+        }
+        for (int64_t x = cx - ring; x <= cx + ring; ++x)
+        {
+            visitCell(x, cy - ring);
+            visitCell(x, cy + ring);
+        }
+        for (int64_t y = cy - ring + 1; y <= cy + ring - 1; ++y)
+        {
+            visitCell(cx - ring, y);
+            visitCell(cx + ring, y);
+        }
+    }
+
+    /**
+     * @param v a coordinate in meters
+     * @return the grid coordinate of the cell containing it
+     */
+    int64_t CellCoord(double v) const
+    {
+        return static_cast<int64_t>(std::floor(v / m_cellSize));
+    }
+
+    /**
+     * @param x cell column
+     * @param y cell row
+     * @return a hash key for the cell
+     */
+    static uint64_t CellKey(int64_t x, int64_t y)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+               static_cast<uint32_t>(y);
+    }
+
+    double m_cellSize;                                            //!< Side of a grid cell in meters
+    std::vector<Item> m_items;                                    //!< Indexed nodes
+    std::unordered_map<const MobilityModel*, uint32_t> m_indexOf; //!< Mobility model to index
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;  //!< Sorted indices per cell
+    double m_maxSpeed{0};                                         //!< Fastest filed node in m/s
+    Time m_oldestFiling;                                          //!< Oldest moving-node filing
+};
+
+} // namespace ns3
+
+#endif // NODE_SPATIAL_INDEX_H
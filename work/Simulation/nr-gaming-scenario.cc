@@ -0,0 +1,772 @@
+// Copyright (c) 2024 LASSE / Universidade Federal do Pará (UFPA)
+// Copyright (c) 2024 Centre Tecnologic de Telecomunicacions de Catalunya (CTTC)
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "nr-gaming-scenario.h"
+
+#include "batched-gaming-traffic.h"
+#include "binary-log.h"
+#include "crn-streams.h"
+#include "pooled-rlc-um.h"
+#include "radio-traffic-injector.h"
+#include "traffic-trace-replay.h"
+
+#include "ns3/antenna-module.h"
+#include "ns3/channel-list.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/isotropic-antenna-model.h"
+#include "ns3/mobility-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/parabolic-antenna-model.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/pointer.h"
+#include "ns3/traffic-generator-helper.h"
+#include "ns3/traffic-generator-ngmn-gaming.h"
+
+#include <unordered_map>
+
+namespace ns3
+{
+
+namespace
+{
+
+/// UDP header in front of the payload of a gaming packet
+constexpr uint32_t UDP_HEADER_BYTES = 8;
+
+/// IPv4 and UDP headers in front of the payload of a gaming packet
+constexpr uint32_t IP_UDP_HEADER_BYTES = 20 + UDP_HEADER_BYTES;
+
+/// Application bytes of a packet with some header bytes in front of the payload
+uint32_t
+PayloadBytes(Ptr<const Packet> packet, uint32_t headerBytes)
+{
+    return packet->GetSize() > headerBytes ? packet->GetSize() - headerBytes : 0;
+}
+
+/// Tx trace sink of a per-UE application, forwarded with the UE index and the payload size
+void
+ForwardTx(NrGamingScenario::FlowPacketCallback sink,
+          uint32_t ue,
+          uint32_t headerBytes,
+          Ptr<const Packet> packet)
+{
+    sink(ue, packet, PayloadBytes(packet, headerBytes));
+}
+
+/// Tx trace sink of BatchedGamingTraffic, whose flows are the UEs in order
+void
+ForwardBatchedTx(NrGamingScenario::FlowPacketCallback sink,
+                 uint32_t headerBytes,
+                 Ptr<const Packet> packet,
+                 uint32_t flow)
+{
+    sink(flow, packet, PayloadBytes(packet, headerBytes));
+}
+
+/// Ipv4L3Protocol SendOutgoing trace sink of the remote host, before the packet is copied on
+/// its way; the packet has its UDP header, and the UE is that of the destination address
+void
+ForwardIpv4Tx(NrGamingScenario::FlowPacketCallback sink,
+              const std::unordered_map<uint32_t, uint32_t>& ueByAddress,
+              const Ipv4Header& header,
+              Ptr<const Packet> packet,
+              uint32_t interface)
+{
+    auto it = ueByAddress.find(header.GetDestination().Get());
+    if (it != ueByAddress.end())
+    {
+        sink(it->second, packet, PayloadBytes(packet, UDP_HEADER_BYTES));
+    }
+}
+
+/// Ipv4L3Protocol Rx trace sink of a UE node; the packet still has its IPv4 header
+void
+ForwardIpv4Rx(NrGamingScenario::FlowPacketCallback sink,
+              uint32_t ue,
+              Ptr<const Packet> packet,
+              Ptr<Ipv4> ipv4,
+              uint32_t interface)
+{
+    sink(ue, packet, PayloadBytes(packet, IP_UDP_HEADER_BYTES));
+}
+
+/// Packets delivered by a UE device in radio-only mode, forwarded as IP packets
+void
+ForwardUeRx(NrGamingScenario::FlowPacketCallback sink, uint32_t ue, Ptr<const Packet> packet)
+{
+    sink(ue, packet, PayloadBytes(packet, IP_UDP_HEADER_BYTES));
+}
+
+} // namespace
+
+NrGamingScenario::NrGamingScenario(const NrGamingScenarioParams& params)
+    : m_params(params)
+{
+    /**
+     * Set the scenario parameters for the simulation, considering the UMa scenario.
+     * Following the TR 38.901 specification - Table 7.4.1-1 pathloss models.
+     * hBS = 25m for UMa scenario.
+     * hUT = 1.5m for UMa scenario.
+     */
+    m_hexGrid.SetUtHeight(1.5); // Height of the UE in meters
+    m_hexGrid.SetBsHeight(25);  // Height of the gNB in meters
+    if (m_params.largeScale)
+    {
+        // Three sectors per site over the requested rings; UEs are dropped per sector
+        m_hexGrid.SetSectorization(HexagonalGridScenarioHelper::TRIPLE);
+        m_hexGrid.SetNumRings(m_params.numRings);
+        m_params.numGnbs = m_hexGrid.GetNumCells();
+        m_params.numUes = m_params.uesPerSector * m_params.numGnbs;
+        BINLOG_INFO("Large-scale mode: %zu sites, %u sectors, %u UEs",
+                    m_hexGrid.GetNumSites(),
+                    m_params.numGnbs,
+                    m_params.numUes);
+    }
+    else
+    {
+        m_hexGrid.SetSectorization(1); // Number of sectors
+    }
+    m_hexGrid.m_isd = 200; // Inter-site distance in meters
+    // Set the number of UEs and gNBs nodes in the scenario
+    m_hexGrid.SetUtNumber(m_params.numUes); // Number of UEs
+    if (!m_params.largeScale)
+    {
+        // Number of gNBs (set by the rings in large-scale mode)
+        m_hexGrid.SetBsNumber(m_params.numGnbs);
+    }
+}
+
+ScenarioFootprint
+NrGamingScenario::GetFootprint() const
+{
+    ScenarioFootprint footprint;
+    footprint.sites = m_params.largeScale ? m_hexGrid.GetNumSites() : m_params.numGnbs;
+    footprint.sectors = m_params.numGnbs;
+    footprint.ues = m_params.numUes;
+    footprint.bandwidth = m_params.bandwidth;
+    footprint.numerology = m_params.numerology;
+    footprint.spatialChannel = m_params.channelModel != "Friis";
+    footprint.gnbAntennaElements =
+        footprint.spatialChannel ? m_params.gnbNumRows * m_params.gnbNumCols : 1;
+    footprint.ueAntennaElements =
+        footprint.spatialChannel ? m_params.ueNumRows * m_params.ueNumCols : 1;
+    footprint.simTimeSeconds = m_params.simTime.GetSeconds();
+    footprint.rlcTxBufferBytes = m_params.rlcBufferMs > 0 ? GetRlcTxBufferBytes() : 0;
+    return footprint;
+}
+
+uint64_t
+NrGamingScenario::GetRlcTxBufferBytes() const
+{
+    if (m_params.rlcBufferMs <= 0)
+    {
+        return 999999999;
+    }
+    return RlcTxBufferBytes(m_params.bandwidth, m_params.numerology, m_params.rlcBufferMs);
+}
+
+void
+NrGamingScenario::Build(const PhaseCallback& beginPhase)
+{
+    auto begin = [&beginPhase](const std::string& phase) {
+        if (beginPhase)
+        {
+            beginPhase(phase);
+        }
+    };
+
+    if (m_params.crn)
+    {
+        m_hexGrid.AssignStreams(CrnStreams::Get(CrnStreams::MOBILITY, 0));
+    }
+    double ueSpeed = 30; // in m/s (3 km/h)
+    // Create a scenario with mobility
+    m_hexGrid.CreateScenarioWithMobility(Vector(ueSpeed, 0.0, 0.0),
+                                         0); // move UE with 3 km/h in x-axis
+    m_ueNodes = m_hexGrid.GetUserTerminals();
+    m_gnbNodes = m_hexGrid.GetBaseStations();
+    BINLOG_INFO("Number of UEs: %u, Number of gNBs: %u", m_ueNodes.GetN(), m_gnbNodes.GetN());
+    // The hexagonal drop is kept in large-scale mode; the small scenario uses fixed positions
+    // and a zigzag movement per UE
+    if (!m_params.largeScale)
+    {
+        PlaceUes();
+    }
+    BINLOG_INFO("hex grid setup completed");
+
+    /*
+     * Setup the NR module:
+     * - NrHelper, which takes care of creating and connecting the various
+     * part of the NR stack
+     * - NrChannelHelper, which takes care of the spectrum channel
+     */
+    begin("channel");
+    BuildChannel();
+    begin("devices");
+    BuildDevices();
+    begin("streams");
+    if (m_params.crn)
+    {
+        AssignRoleStreams();
+    }
+    else
+    {
+        m_params.randomStream += m_nrHelper->AssignStreams(m_gnbDevices, m_params.randomStream);
+        m_params.randomStream += m_nrHelper->AssignStreams(m_ueDevices, m_params.randomStream);
+    }
+    BINLOG_INFO("NetDevices installed and streams assigned");
+    if (m_params.radioOnly)
+    {
+        begin("bearers");
+        BuildRadioBearers();
+    }
+    else
+    {
+        begin("epc-internet");
+        BuildInternet();
+    }
+    begin("applications");
+    BuildApplications();
+    if (m_params.crn)
+    {
+        AssignTrafficStreams();
+    }
+    begin("attach");
+    AttachUes();
+}
+
+void
+NrGamingScenario::StartApplications()
+{
+    // start UDP server and client apps
+    m_serverApps.Start(m_params.udpTime);
+    m_clientApps.Start(m_params.udpTime);
+    m_serverApps.Stop(m_params.simTime);
+    m_clientApps.Stop(m_params.simTime);
+    BINLOG_INFO("Gaming applications started");
+}
+
+void
+NrGamingScenario::UseAbstractChannel()
+{
+    // Received PSDs are then the transmitted ones scaled by the pathloss, without the per-RB
+    // channel matrices and beamforming gains
+    Config::Set("/ChannelList/*/$ns3::SpectrumChannel/PhasedArraySpectrumPropagationLossModel",
+                PointerValue(nullptr));
+    BINLOG_WARN("Fast fading disabled at %.3f s: pathloss-only channel",
+                Simulator::Now().GetSeconds());
+}
+
+void
+NrGamingScenario::PlaceUes()
+{
+    for (size_t ueIndex = 0; ueIndex < m_ueNodes.GetN(); ueIndex++)
+    {
+        Vector3D position(10.0, 20.0, 1.5);
+        Ptr<MobilityModel> mob = m_ueNodes.Get(ueIndex)->GetObject<MobilityModel>();
+        BINLOG_DEBUG("UE [%zu] dropped at (%.2f, %.2f, %.2f)",
+                     ueIndex,
+                     mob->GetPosition().x,
+                     mob->GetPosition().y,
+                     mob->GetPosition().z);
+        if (ueIndex > 0)
+        {
+            position.x = 50.0 * ueIndex;
+            position.y = 30.0 * ((ueIndex % 2 == 0) ? 1 : -1);
+        }
+        mob->SetPosition(position);
+        BINLOG_INFO("UE [%zu] position set to (%.2f, %.2f, %.2f)",
+                    ueIndex,
+                    position.x,
+                    position.y,
+                    position.z);
+    }
+    for (size_t ueIndex = 0; ueIndex < m_ueNodes.GetN(); ueIndex++)
+    {
+        Ptr<ConstantVelocityMobilityModel> mob =
+            m_ueNodes.Get(ueIndex)->GetObject<ConstantVelocityMobilityModel>();
+
+        double speed = 1.0 + ueIndex * 3.0; // 1 m/s, 4 m/s, 7 m/s, etc.
+        // zigzag movement
+        mob->SetVelocity(Vector(speed, (ueIndex % 2 == 0 ? 1 : -1) * speed, 0));
+    }
+}
+
+void
+NrGamingScenario::BuildChannel()
+{
+    Config::SetDefault("ns3::NrAmc::ErrorModelType",
+                       TypeIdValue(TypeId::LookupByName(m_params.errorModelType)));
+    if (m_params.amcSelectionModel == "ErrorModel")
+    {
+        Config::SetDefault("ns3::NrAmc::AmcModel", EnumValue(NrAmc::ErrorModel));
+    }
+    else if (m_params.amcSelectionModel == "ShannonModel")
+    {
+        Config::SetDefault("ns3::NrAmc::AmcModel", EnumValue(NrAmc::ShannonModel));
+    }
+    else
+    {
+        NS_FATAL_ERROR("Invalid amcSelectionModel: " << m_params.amcSelectionModel);
+    }
+    // RLC UM buffers: practically unbounded by default; bounded to a few ms of the peak rate
+    // of the carrier, they drop new SDUs once full, which caps the memory of every bearer and
+    // the length of the SDU list the RLC walks to build its PDUs in overloaded runs
+    Config::SetDefault("ns3::NrRlcUm::MaxTxBufferSize", UintegerValue(GetRlcTxBufferBytes()));
+    if (m_params.rlcBufferMs > 0)
+    {
+        BINLOG_INFO("RLC UM transmit buffers bounded to %.1f kB (%.1f ms at the peak rate)",
+                    GetRlcTxBufferBytes() / 1e3,
+                    m_params.rlcBufferMs);
+    }
+
+    if (!m_params.radioOnly)
+    {
+        m_epcHelper = CreateObject<NrPointToPointEpcHelper>();
+    }
+    m_nrHelper = CreateObject<NrHelper>();
+    Ptr<NrChannelHelper> channelHelper = CreateObject<NrChannelHelper>();
+    if (m_epcHelper)
+    {
+        m_nrHelper->SetEpcHelper(m_epcHelper);
+    }
+
+    uint8_t numCc = 1; // Number of component carriers
+    CcBwpCreator ccBwpCreator;
+    m_band = ccBwpCreator.CreateOperationBandContiguousCc(
+        {m_params.centralFrequency, m_params.bandwidth, numCc});
+
+    const std::string& channelModel = m_params.channelModel;
+    if (channelModel == "ThreeGpp" || channelModel == "NYU" || channelModel == "TwoRay")
+    {
+        // Create the ideal beamforming helper in case of a non-phased array model
+        Ptr<IdealBeamformingHelper> idealBeamformingHelper = CreateObject<IdealBeamformingHelper>();
+        m_nrHelper->SetBeamformingHelper(idealBeamformingHelper);
+        // First configure the channel helper object factories
+        channelHelper->ConfigureFactories(m_params.scenario,
+                                          m_params.channelConditionModel,
+                                          channelModel);
+        // Enable slow fading (shadowing)
+        channelHelper->SetPathlossAttribute("ShadowingEnabled", BooleanValue(true));
+        // Optional: exaggerate it
+        // channelHelper->SetPathlossAttribute("ShadowSigma", DoubleValue(10.0));
+        // Set channel condition attributes
+        if (m_params.channelConditionModel == "Default" ||
+            m_params.channelConditionModel == "Buildings")
+        {
+            channelHelper->SetChannelConditionModelAttribute("UpdatePeriod",
+                                                             TimeValue(MilliSeconds(100)));
+        }
+        // Beamforming method
+        idealBeamformingHelper->SetAttribute("BeamformingMethod",
+                                             TypeIdValue(DirectPathBeamforming::GetTypeId()));
+
+        // Antennas for all the UEs
+        m_nrHelper->SetUeAntennaAttribute("NumRows", UintegerValue(m_params.ueNumRows));
+        m_nrHelper->SetUeAntennaAttribute("NumColumns", UintegerValue(m_params.ueNumCols));
+        m_nrHelper->SetUeAntennaAttribute("AntennaElement",
+                                          PointerValue(CreateObject<IsotropicAntennaModel>()));
+
+        // Antennas for all the gNbs
+        m_nrHelper->SetGnbAntennaAttribute("NumRows", UintegerValue(m_params.gnbNumRows));
+        m_nrHelper->SetGnbAntennaAttribute("NumColumns", UintegerValue(m_params.gnbNumCols));
+        m_nrHelper->SetGnbAntennaAttribute("AntennaElement",
+                                           PointerValue(CreateObject<IsotropicAntennaModel>()));
+    }
+    else if (channelModel == "Friis")
+    {
+        // Override the default antenna model with ParabolicAntennaModel
+        m_nrHelper->SetUeAntennaTypeId(ParabolicAntennaModel::GetTypeId().GetName());
+        m_nrHelper->SetGnbAntennaTypeId(ParabolicAntennaModel::GetTypeId().GetName());
+        // Configure Friis propagation loss model before assign it to band
+        channelHelper->ConfigurePropagationFactory(FriisPropagationLossModel::GetTypeId());
+    }
+    else
+    {
+        NS_FATAL_ERROR("Invalid channel model: "
+                       << channelModel << ". Choose among 'ThreeGpp', 'NYU', 'TwoRay', 'Friis'.");
+    }
+
+    // After configuring the factories, create and assign the spectrum channels to the bands
+    channelHelper->AssignChannelsToBands({m_band});
+    BINLOG_INFO("Spectrum channel created and assigned to the band");
+}
+
+void
+NrGamingScenario::BuildDevices()
+{
+    uint32_t ueTxPower = 23; // UE transmission power in dBm
+    uint32_t bsTxPower = 41; // gNB transmission power in dBm
+    // Get all the BWPs
+    auto allBwps = CcBwpCreator::GetAllBwps({m_band});
+    // Set the numerology and transmission powers attributes to all the gNBs and UEs
+    m_nrHelper->SetGnbPhyAttribute("TxPower", DoubleValue(bsTxPower));
+    m_nrHelper->SetGnbPhyAttribute("Numerology", UintegerValue(m_params.numerology));
+    m_nrHelper->SetUePhyAttribute("TxPower", DoubleValue(ueTxPower));
+    BINLOG_INFO("Attributes set for gNBs and UEs");
+    // Scheduler: Ensure AMC is active, not fixed MCS
+    m_nrHelper->SetSchedulerTypeId(TypeId::LookupByName(m_params.macScheduler));
+    m_nrHelper->SetSchedulerAttribute("FixedMcsDl", BooleanValue(false));
+    m_nrHelper->SetSchedulerAttribute("FixedMcsUl", BooleanValue(false));
+
+    // Error Model: Apply to UEs and gNBs
+    m_nrHelper->SetUlErrorModel(m_params.errorModelType);
+    m_nrHelper->SetDlErrorModel(m_params.errorModelType);
+
+    // AMC Model: Ensure gNB uses the chosen AMC logic for DL and UL scheduling
+    if (m_params.amcSelectionModel == "ErrorModel")
+    {
+        m_nrHelper->SetGnbDlAmcAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
+        m_nrHelper->SetGnbUlAmcAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
+        // UEs will also use this for CQI reporting by default matching NrAmc global default
+    }
+    else if (m_params.amcSelectionModel == "ShannonModel")
+    {
+        m_nrHelper->SetGnbDlAmcAttribute("AmcModel", EnumValue(NrAmc::ShannonModel));
+        m_nrHelper->SetGnbUlAmcAttribute("AmcModel", EnumValue(NrAmc::ShannonModel));
+    }
+    // Install and get the pointers to the NetDevices
+    m_gnbDevices = m_nrHelper->InstallGnbDevice(m_gnbNodes, allBwps);
+    m_ueDevices = m_nrHelper->InstallUeDevice(m_ueNodes, allBwps);
+
+    // The helper leaves the data bearers of both sides in RLC saturation mode without EPC, which
+    // ignores the packets the radio-only injectors hand to the gNBs, and forces UM on the gNBs
+    // only with EPC: the mode is set on both sides. In full-buffer mode, saturation reports a
+    // standing backlog and builds every PDU at the size of the transmit opportunity the MAC
+    // gives it, in both directions and without any packet; otherwise UM carries the traffic
+    SetDataBearerRlc(m_params.fullBuffer);
+    if (!m_params.fullBuffer && m_params.pooledRlc)
+    {
+        // DL data bearers on a ring of pooled SDU slots, with the same bound as the stock
+        // buffers and a choice of drop policy; the UEs send no data and keep NrRlcUm
+        ObjectFactory factory("ns3::PooledRlcUm");
+        factory.Set("MaxBytes", UintegerValue(GetRlcTxBufferBytes()));
+        factory.Set("DropPolicy", StringValue(m_params.rlcDropPolicy));
+        for (uint32_t i = 0; i < m_gnbDevices.GetN(); ++i)
+        {
+            PooledRlcUm::Install(DynamicCast<NrGnbNetDevice>(m_gnbDevices.Get(i)), factory);
+        }
+        BINLOG_INFO("Pooled RLC UM buffers on the gNBs, %s", m_params.rlcDropPolicy);
+    }
+}
+
+void
+NrGamingScenario::SetDataBearerRlc(bool saturation)
+{
+    for (uint32_t i = 0; i < m_gnbDevices.GetN(); ++i)
+    {
+        DynamicCast<NrGnbNetDevice>(m_gnbDevices.Get(i))
+            ->GetRrc()
+            ->SetAttribute("EpsBearerToRlcMapping",
+                           EnumValue(saturation ? NrGnbRrc::RLC_SM_ALWAYS
+                                                : NrGnbRrc::RLC_UM_ALWAYS));
+    }
+    for (uint32_t i = 0; i < m_ueDevices.GetN(); ++i)
+    {
+        DynamicCast<NrUeNetDevice>(m_ueDevices.Get(i))->GetRrc()->SetUseRlcSm(saturation);
+    }
+}
+
+void
+NrGamingScenario::BuildInternet()
+{
+    // create the internet and install the IP stack on the UEs
+    // get SGW/PGW and create a single RemoteHost
+    Ptr<Node> pgw = m_epcHelper->GetPgwNode();
+    m_remoteHost = CreateObject<Node>();
+    InternetStackHelper internet;
+    internet.Install(m_remoteHost);
+    BINLOG_INFO("Internet stack installed on remote host");
+    // connect a remoteHost to pgw. Setup routing too
+    PointToPointHelper p2ph;
+    p2ph.SetDeviceAttribute("DataRate", DataRateValue(DataRate("100Gb/s")));
+    p2ph.SetDeviceAttribute("Mtu", UintegerValue(2500));
+    p2ph.SetChannelAttribute("Delay", TimeValue(Seconds(0.010)));
+    NetDeviceContainer internetDevices = p2ph.Install(pgw, m_remoteHost);
+
+    Ipv4AddressHelper ipv4h;
+    ipv4h.SetBase("1.0.0.0", "255.0.0.0");
+    Ipv4InterfaceContainer internetIpIfaces = ipv4h.Assign(internetDevices);
+    Ipv4StaticRoutingHelper ipv4RoutingHelper;
+
+    Ptr<Ipv4StaticRouting> remoteHostStaticRouting =
+        ipv4RoutingHelper.GetStaticRouting(m_remoteHost->GetObject<Ipv4>());
+    remoteHostStaticRouting->AddNetworkRouteTo(Ipv4Address("7.0.0.0"), Ipv4Mask("255.0.0.0"), 1);
+    internet.Install(m_ueNodes);
+
+    m_ueIpIfaces = m_epcHelper->AssignUeIpv4Address(NetDeviceContainer(m_ueDevices));
+    BINLOG_INFO("IPv4 addresses assigned to UEs");
+}
+
+void
+NrGamingScenario::BuildRadioBearers()
+{
+    // Same bearer as the default one the EPC sets up
+    m_nrHelper->ActivateDataRadioBearer(m_ueDevices,
+                                        NrEpsBearer(NrEpsBearer::NGBR_VIDEO_TCP_DEFAULT));
+    // Without an IP stack the packets the UEs receive end in the UeRx trace
+    for (uint32_t i = 0; i < m_ueDevices.GetN(); ++i)
+    {
+        m_ueDevices.Get(i)->SetReceiveCallback(
+            MakeBoundCallback(&NrGamingScenario::UeDeviceRx, this, i));
+    }
+    BINLOG_INFO("Data radio bearers activated without EPC");
+}
+
+void
+NrGamingScenario::BuildApplications()
+{
+    if (m_params.fullBuffer)
+    {
+        // The saturation-mode RLCs generate the traffic themselves
+        BINLOG_INFO("Full-buffer traffic: every bearer backlogged in DL and UL, no applications");
+        return;
+    }
+    if (m_params.batchedTraffic || !m_params.replayTrace.empty())
+    {
+        // One application for all the UEs, delivering the arrivals of a slot together, or
+        // every arrival at its own time when only replaying; it runs on the remote host, or
+        // on the first UE node in radio-only mode
+        Time slot = m_params.batchedTraffic ? MilliSeconds(1.0 / (1 << m_params.numerology))
+                                            : NanoSeconds(1);
+        m_batchedTraffic =
+            CreateObjectWithAttributes<BatchedGamingTraffic>("SlotDuration", TimeValue(slot));
+        Ptr<MappedTrafficTrace> trace;
+        if (!m_params.replayTrace.empty())
+        {
+            trace = Create<MappedTrafficTrace>(m_params.replayTrace);
+            NS_ABORT_MSG_IF(trace->GetRntis().empty(), "No RNTI in " << m_params.replayTrace);
+            BINLOG_INFO("Replaying %lu records of %zu RNTIs from %s",
+                        trace->GetNumRecords(),
+                        trace->GetRntis().size(),
+                        m_params.replayTrace);
+        }
+        for (uint32_t i = 0; i < m_ueNodes.GetN(); ++i)
+        {
+            Ptr<RadioTrafficSource> source;
+            if (trace)
+            {
+                // UE i replays the (i mod N)-th RNTI of the capture, with its own cursor over
+                // the shared mapping
+                Ptr<TraceReplaySource> replay = CreateObject<TraceReplaySource>();
+                replay->SetTrace(trace, i % trace->GetRntis().size());
+                source = replay;
+            }
+            else
+            {
+                source = CreateObject<NgmnGamingDlSource>();
+            }
+            if (m_params.radioOnly)
+            {
+                m_batchedTraffic->AddRadioFlow(source,
+                                               DynamicCast<NrUeNetDevice>(m_ueDevices.Get(i)));
+            }
+            else
+            {
+                m_batchedTraffic->AddSocketFlow(
+                    source,
+                    InetSocketAddress(m_ueIpIfaces.GetAddress(i), GAMING_UDP_PORT));
+            }
+        }
+        (m_params.radioOnly ? m_ueNodes.Get(0) : m_remoteHost)->AddApplication(m_batchedTraffic);
+        m_clientApps.Add(m_batchedTraffic);
+        return;
+    }
+    if (m_params.radioOnly)
+    {
+        // Same NGMN gaming arrivals, handed to the gNB of every UE instead of a socket
+        for (uint32_t i = 0; i < m_ueNodes.GetN(); ++i)
+        {
+            Ptr<RadioTrafficInjector> injector = CreateObjectWithAttributes<RadioTrafficInjector>(
+                "Source",
+                PointerValue(CreateObject<NgmnGamingDlSource>()));
+            injector->SetUeDevice(DynamicCast<NrUeNetDevice>(m_ueDevices.Get(i)));
+            m_ueNodes.Get(i)->AddApplication(injector);
+            m_clientApps.Add(injector);
+        }
+        return;
+    }
+    // assign IP address to UEs, and install UDP downlink applications
+    uint16_t dlPort = GAMING_UDP_PORT;
+    for (size_t i = 0; i < m_ueNodes.GetN(); i++)
+    {
+        TrafficGeneratorHelper trafficHelper("ns3::UdpSocketFactory", // or "ns3::TcpSocketFactory"
+                                             InetSocketAddress(m_ueIpIfaces.GetAddress(i), dlPort),
+                                             TrafficGeneratorNgmnGaming::GetTypeId());
+
+        m_clientApps.Add(trafficHelper.Install(m_remoteHost));
+    }
+}
+
+void
+NrGamingScenario::AttachUes()
+{
+    // attach UEs to the closest gNB, looked up in a spatial index over the gNB positions
+    // instead of scanning every gNB for every UE; it serves the closest-gNB queries of
+    // CountHandoverCandidates as well
+    m_gnbIndex = std::make_unique<NodeSpatialIndex>(m_hexGrid.m_isd / 2);
+    m_gnbIndex->Add(m_gnbNodes);
+    for (uint32_t i = 0; i < m_ueDevices.GetN(); ++i)
+    {
+        Vector uePos = m_ueNodes.Get(i)->GetObject<MobilityModel>()->GetPosition();
+        m_nrHelper->AttachToGnb(m_ueDevices.Get(i),
+                                m_gnbDevices.Get(m_gnbIndex->FindClosest(uePos)));
+    }
+}
+
+uint32_t
+NrGamingScenario::CountHandoverCandidates()
+{
+    std::unordered_map<const NetDevice*, uint32_t> gnbOfDevice;
+    for (uint32_t j = 0; j < m_gnbDevices.GetN(); ++j)
+    {
+        gnbOfDevice[PeekPointer(m_gnbDevices.Get(j))] = j;
+    }
+    uint32_t candidates = 0;
+    for (uint32_t i = 0; i < m_ueNodes.GetN(); ++i)
+    {
+        Vector uePos = m_ueNodes.Get(i)->GetObject<MobilityModel>()->GetPosition();
+        uint32_t closest = m_gnbIndex->FindClosest(uePos);
+        uint32_t serving = gnbOfDevice.at(
+            PeekPointer(DynamicCast<NrUeNetDevice>(m_ueDevices.Get(i))->GetTargetGnb()));
+        // The sector antennas of a site are offset from each other: a closer sector of the
+        // serving site is not a handover candidate
+        if (m_hexGrid.GetSiteIndex(closest) != m_hexGrid.GetSiteIndex(serving))
+        {
+            candidates++;
+        }
+    }
+    return candidates;
+}
+
+void
+NrGamingScenario::AssignRoleStreams()
+{
+    // One device at a time, so that the streams of a device do not depend on how many the
+    // devices before it used
+    for (uint32_t i = 0; i < m_gnbDevices.GetN(); ++i)
+    {
+        int64_t stream = CrnStreams::Get(CrnStreams::GNB_DEVICE, i);
+        CrnStreams::CheckSpan(CrnStreams::GNB_DEVICE,
+                              m_nrHelper->AssignStreams(NetDeviceContainer(m_gnbDevices.Get(i)),
+                                                        stream));
+    }
+    for (uint32_t i = 0; i < m_ueDevices.GetN(); ++i)
+    {
+        int64_t stream = CrnStreams::Get(CrnStreams::UE_DEVICE, i);
+        CrnStreams::CheckSpan(CrnStreams::UE_DEVICE,
+                              m_nrHelper->AssignStreams(NetDeviceContainer(m_ueDevices.Get(i)),
+                                                        stream));
+    }
+    // After the devices, in case the helper reached the propagation models through them
+    uint32_t index = 0;
+    for (auto it = ChannelList::Begin(); it != ChannelList::End(); ++it)
+    {
+        if (Ptr<SpectrumChannel> channel = DynamicCast<SpectrumChannel>(*it))
+        {
+            CrnStreams::AssignChannel(channel, index++);
+        }
+    }
+    BINLOG_INFO("Streams pinned by role for %u spectrum channels", index);
+}
+
+void
+NrGamingScenario::AssignTrafficStreams()
+{
+    // The flow of UE i draws from the same streams in every traffic mode
+    for (uint32_t i = 0; i < m_ueNodes.GetN(); ++i)
+    {
+        int64_t stream = CrnStreams::Get(CrnStreams::TRAFFIC, i);
+        int64_t used = 0;
+        if (m_batchedTraffic)
+        {
+            used = m_batchedTraffic->GetSource(i)->AssignStreams(stream);
+        }
+        else if (m_params.fullBuffer)
+        {
+            return;
+        }
+        else if (m_params.radioOnly)
+        {
+            used = DynamicCast<RadioTrafficInjector>(m_clientApps.Get(i))->AssignStreams(stream);
+        }
+        else
+        {
+            used = DynamicCast<TrafficGenerator>(m_clientApps.Get(i))->AssignStreams(stream);
+        }
+        CrnStreams::CheckSpan(CrnStreams::TRAFFIC, used);
+    }
+}
+
+void
+NrGamingScenario::ConnectUeRx(Callback<void, uint32_t, Ptr<const Packet>> sink)
+{
+    NS_ABORT_MSG_IF(!m_params.radioOnly, "UE devices only deliver to a trace in radio-only mode");
+    m_ueRxTrace.ConnectWithoutContext(sink);
+}
+
+void
+NrGamingScenario::ConnectFlowTraces(FlowPacketCallback tx, FlowPacketCallback rx)
+{
+    // The source tags every packet before passing it on, since a tag added to a packet
+    // already copied would not reach the UE
+    if (m_params.radioOnly)
+    {
+        // Sources: the injectors, which report a packet, with its IPv4 and UDP headers, before
+        // handing it to the gNB; sinks: the UE devices
+        if (m_batchedTraffic)
+        {
+            m_batchedTraffic->TraceConnectWithoutContext(
+                "Tx",
+                MakeBoundCallback(&ForwardBatchedTx, tx, IP_UDP_HEADER_BYTES));
+        }
+        else
+        {
+            // One injector per UE, in UE order
+            for (uint32_t i = 0; i < m_clientApps.GetN(); ++i)
+            {
+                bool connected = m_clientApps.Get(i)->TraceConnectWithoutContext(
+                    "Tx",
+                    MakeBoundCallback(&ForwardTx, tx, i, IP_UDP_HEADER_BYTES));
+                NS_ABORT_MSG_IF(!connected, "Gaming application without a Tx trace");
+            }
+        }
+        m_ueRxTrace.ConnectWithoutContext(MakeBoundCallback(&ForwardUeRx, rx));
+        return;
+    }
+    // Sources: the IP stack of the remote host, where FlowMonitor tags too, since the stock
+    // generators report a packet only once their socket has sent a copy of it; sinks: the IP
+    // stack of every UE
+    std::unordered_map<uint32_t, uint32_t> ueByAddress;
+    for (uint32_t i = 0; i < m_ueIpIfaces.GetN(); ++i)
+    {
+        ueByAddress.emplace(m_ueIpIfaces.GetAddress(i).Get(), i);
+    }
+    m_remoteHost->GetObject<Ipv4L3Protocol>()->TraceConnectWithoutContext(
+        "SendOutgoing",
+        MakeBoundCallback(&ForwardIpv4Tx, tx, ueByAddress));
+    for (uint32_t i = 0; i < m_ueNodes.GetN(); ++i)
+    {
+        Config::ConnectWithoutContext("/NodeList/" + std::to_string(m_ueNodes.Get(i)->GetId()) +
+                                          "/$ns3::Ipv4L3Protocol/Rx",
+                                      MakeBoundCallback(&ForwardIpv4Rx, rx, i));
+    }
+}
+
+bool
+NrGamingScenario::UeDeviceRx(NrGamingScenario* scenario,
+                             uint32_t ue,
+                             Ptr<NetDevice> device,
+                             Ptr<const Packet> packet,
+                             uint16_t protocol,
+                             const Address& from)
+{
+    scenario->m_ueRxTrace(ue, packet);
+    return true;
+}
+
+} // namespace ns3
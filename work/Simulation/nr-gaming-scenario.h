@@ -0,0 +1,305 @@
+// Copyright (c) 2024 LASSE / Universidade Federal do Pará (UFPA)
+// Copyright (c) 2024 Centre Tecnologic de Telecomunicacions de Catalunya (CTTC)
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef NR_GAMING_SCENARIO_H
+#define NR_GAMING_SCENARIO_H
+
+#include "batched-gaming-traffic.h"
+#include "node-spatial-index.h"
+#include "scenario-resource-estimator.h"
+
+#include "ns3/application-container.h"
+#include "ns3/cc-bwp-helper.h"
+#include "ns3/hexagonal-grid-scenario-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/nr-helper.h"
+#include "ns3/nr-point-to-point-epc-helper.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * @brief Parameters of the NR gaming scenario.
+ *
+ * The defaults are those of the opt-gsoc-nr-channel-models-error command line.
+ */
+struct NrGamingScenarioParams
+{
+    int64_t randomStream{1};                       //!< First random stream (unless crn)
+    double centralFrequency{30.5e9};               //!< Carrier frequency in Hz
+    double bandwidth{100e6};                       //!< Channel bandwidth in Hz
+    Time simTime{Seconds(10.0)};                   //!< Simulated time
+    Time udpTime{MilliSeconds(0)};                 //!< Start of the applications
+    std::string scenario{"UMa"};                   //!< 3GPP scenario
+    std::string channelModel{"ThreeGpp"};          //!< ThreeGpp, NYU, TwoRay or Friis
+    std::string channelConditionModel{"Default"};  //!< Default, LOS, NLOS or Buildings
+    uint32_t numUes{4};                            //!< UEs (overridden in large-scale mode)
+    uint32_t numGnbs{1};                           //!< gNBs (overridden in large-scale mode)
+    uint16_t numerology{1};                        //!< NR numerology
+    std::string errorModelType{"ns3::NrEesmCcT1"}; //!< Error model of the PHY and the AMC
+    std::string amcSelectionModel{"ErrorModel"};   //!< ErrorModel or ShannonModel
+    bool largeScale{false};                        //!< Multi-site, three-sector layout
+    uint32_t numRings{1};                          //!< Outer rings of sites (large-scale mode)
+    uint32_t uesPerSector{10};                     //!< UE drop density (large-scale mode)
+    uint32_t ueNumRows{1};                         //!< Rows of the UE antenna
+    uint32_t ueNumCols{1};                         //!< Columns of the UE antenna
+    uint32_t gnbNumRows{4};                        //!< Rows of the gNB antenna
+    uint32_t gnbNumCols{8};                        //!< Columns of the gNB antenna
+    bool radioOnly{false};                         //!< No EPC or IP, traffic injected at the gNB
+    bool batchedTraffic{false};                    //!< One application, arrivals batched per slot
+    std::string replayTrace;                       //!< Binary traffic trace replayed instead
+    bool fullBuffer{false};                        //!< Saturated DL and UL RLC, no applications
+    double rlcBufferMs{0};                         //!< RLC UM buffers, ms at peak rate (0: 1 GB)
+    bool pooledRlc{false};                         //!< PooledRlcUm on the gNB data bearers
+    std::string rlcDropPolicy{"TailDrop"};         //!< TailDrop or HeadDrop (pooledRlc)
+    bool crn{false};                               //!< Streams pinned by role, see CrnStreams
+    /// MAC scheduler of the gNBs
+    std::string macScheduler{"ns3::NrMacSchedulerTdmaRR"};
+};
+
+/**
+ * @brief Hexagonal NR deployment with NGMN gaming traffic from a remote host to every UE.
+ *
+ * The constructor only lays out the grid, so the footprint of the scenario can be estimated
+ * before anything heavy is built; Build() then creates the nodes, the channel, the NR and
+ * EPC stacks and the applications, and attaches every UE to its closest gNB. In radio-only
+ * mode there is no EPC, remote host or IP stack: every UE gets a data radio bearer and a
+ * RadioTrafficInjector hands its gaming packets straight to its gNB. With batched traffic,
+ * or when replaying a binary traffic trace (see MappedTrafficTrace) instead of the NGMN
+ * arrivals, a single BatchedGamingTraffic carries the flows of all the UEs, over either path.
+ * In full-buffer mode the RLCs of the bearers run in saturation mode, keeping every UE
+ * backlogged in both directions without any application. The scenario holds the helpers
+ * and the spatial index used during the run: it must outlive the simulation.
+ */
+class NrGamingScenario
+{
+  public:
+    /// Called with the name of every setup phase as it starts
+    using PhaseCallback = std::function<void(const std::string&)>;
+
+    /// Called for every packet of a gaming flow with the UE index, the packet and the
+    /// application bytes
+    using FlowPacketCallback = Callback<void, uint32_t, Ptr<const Packet>, uint32_t>;
+
+    /**
+     * @brief Lay out the grid.
+     * @param params scenario parameters; in large-scale mode the numbers of UEs and gNBs
+     *        follow from the rings and the UEs per sector
+     */
+    explicit NrGamingScenario(const NrGamingScenarioParams& params);
+
+    NrGamingScenario(const NrGamingScenario&) = delete;
+    NrGamingScenario& operator=(const NrGamingScenario&) = delete;
+
+    /**
+     * @return the parameters, with the numbers of UEs and gNBs actually deployed
+     */
+    const NrGamingScenarioParams& GetParams() const
+    {
+        return m_params;
+    }
+
+    /**
+     * @return the size of the scenario, for the pre-flight resource estimate
+     */
+    ScenarioFootprint GetFootprint() const;
+
+    /**
+     * @brief Build the nodes, channel, devices, IP stacks and applications, and attach the UEs.
+     * @param beginPhase called as every setup phase starts: channel, devices, streams,
+     *        epc-internet (bearers in radio-only mode), applications and attach
+     */
+    void Build(const PhaseCallback& beginPhase = PhaseCallback());
+
+    /**
+     * @brief Start the gaming applications at udpTime and stop them at simTime.
+     */
+    void StartApplications();
+
+    /**
+     * @brief Drop the fast fading and beamforming model from the spectrum channels, keeping
+     *        the pathloss, shadowing and channel condition: a cheaper, abstract PHY that a
+     *        run can switch to while it runs.
+     */
+    void UseAbstractChannel();
+
+    /**
+     * @brief Connect a sink to the packets the UE devices deliver in radio-only mode.
+     * @param sink called with the UE index and the packet, IPv4 header included
+     */
+    void ConnectUeRx(Callback<void, uint32_t, Ptr<const Packet>> sink);
+
+    /**
+     * @brief Connect sinks to the packets of the gaming flows, sent by the IP stack of the
+     *        remote host (or, in radio-only mode, their injector) and delivered to the IP
+     *        stack (or the device) of their UE.
+     *
+     * Call after Build(); in full-buffer mode there are no flows.
+     *
+     * @param tx called for every packet sent, before any copy of it is passed on
+     * @param rx called for every packet delivered
+     */
+    void ConnectFlowTraces(FlowPacketCallback tx, FlowPacketCallback rx);
+
+    /**
+     * @return the UE nodes
+     */
+    const NodeContainer& GetUeNodes() const
+    {
+        return m_ueNodes;
+    }
+
+    /**
+     * @return the gNB nodes
+     */
+    const NodeContainer& GetGnbNodes() const
+    {
+        return m_gnbNodes;
+    }
+
+    /**
+     * @return the UE NR devices
+     */
+    const NetDeviceContainer& GetUeDevices() const
+    {
+        return m_ueDevices;
+    }
+
+    /**
+     * @return the gNB NR devices
+     */
+    const NetDeviceContainer& GetGnbDevices() const
+    {
+        return m_gnbDevices;
+    }
+
+    /**
+     * @return the application carrying all the flows with batched or replayed traffic, else
+     *         null
+     */
+    Ptr<BatchedGamingTraffic> GetBatchedTraffic() const
+    {
+        return m_batchedTraffic;
+    }
+
+    /**
+     * @return the NR helper
+     */
+    Ptr<NrHelper> GetNrHelper() const
+    {
+        return m_nrHelper;
+    }
+
+    /**
+     * @brief Count the UEs that moved closer to another site than to the gNB serving them.
+     *
+     * No handover runs in this scenario, so such UEs stay on a farther cell; the count, at
+     * the current simulation time, tells how far the initial attachment aged. The closest gNB
+     * of every UE is looked up in the gNB index, and the UE counts when that gNB belongs to
+     * another site than its serving gNB, whatever the distance it moved.
+     *
+     * @return the number of UEs
+     */
+    uint32_t CountHandoverCandidates();
+
+  private:
+    /**
+     * @brief Place the UEs of the small scenario and give each one a zigzag movement.
+     */
+    void PlaceUes();
+
+    /**
+     * @return the bound of every RLC UM transmit buffer in bytes
+     */
+    uint64_t GetRlcTxBufferBytes() const;
+
+    /**
+     * @brief Configure the AMC, error model and RLC defaults, and create the spectrum channel.
+     */
+    void BuildChannel();
+
+    /**
+     * @brief Install the NR devices on the gNBs and the UEs, and choose the RLC of the bearers
+     *        (PooledRlcUm on the gNBs with pooledRlc).
+     */
+    void BuildDevices();
+
+    /**
+     * @brief Set the RLC of the data bearers of every gNB and UE, before they are set up.
+     * @param saturation saturation mode (SM) if true, unacknowledged mode (UM) otherwise
+     */
+    void SetDataBearerRlc(bool saturation);
+
+    /**
+     * @brief Connect a remote host to the PGW and install the IP stack on the UEs.
+     */
+    void BuildInternet();
+
+    /**
+     * @brief Give every UE a data radio bearer, without EPC, and a device receive callback.
+     */
+    void BuildRadioBearers();
+
+    /**
+     * @brief Install a gaming traffic generator on the remote host for every UE, or a radio
+     *        traffic injector on every UE in radio-only mode; with batched traffic, a single
+     *        application for all the UEs instead, which also replays traffic traces; none in
+     *        full-buffer mode.
+     */
+    void BuildApplications();
+
+    /**
+     * @brief Attach every UE to its closest gNB.
+     */
+    void AttachUes();
+
+    /**
+     * @brief Pin the streams of the NR devices and the channel by role (crn mode).
+     */
+    void AssignRoleStreams();
+
+    /**
+     * @brief Pin the streams of the gaming flow of every UE (crn mode).
+     */
+    void AssignTrafficStreams();
+
+    /// Receive callback of the UE devices in radio-only mode: the packet ends there
+    static bool UeDeviceRx(NrGamingScenario* scenario,
+                           uint32_t ue,
+                           Ptr<NetDevice> device,
+                           Ptr<const Packet> packet,
+                           uint16_t protocol,
+                           const Address& from);
+
+    NrGamingScenarioParams m_params;              //!< Parameters, with the deployed node counts
+    HexagonalGridScenarioHelper m_hexGrid;        //!< Layout of the sites and the UEs
+    NodeContainer m_ueNodes;                      //!< UE nodes
+    NodeContainer m_gnbNodes;                     //!< gNB nodes
+    Ptr<NrPointToPointEpcHelper> m_epcHelper;     //!< EPC helper
+    Ptr<NrHelper> m_nrHelper;                     //!< NR helper
+    OperationBandInfo m_band;                     //!< Operation band, holding the channel
+    NetDeviceContainer m_gnbDevices;              //!< gNB NR devices
+    NetDeviceContainer m_ueDevices;               //!< UE NR devices
+    Ptr<Node> m_remoteHost;                       //!< Source of the gaming traffic
+    Ipv4InterfaceContainer m_ueIpIfaces;          //!< UE IP interfaces
+    ApplicationContainer m_clientApps;            //!< Gaming traffic generators or injectors
+    ApplicationContainer m_serverApps;            //!< Receivers (none, the UEs just receive)
+    Ptr<BatchedGamingTraffic> m_batchedTraffic;   //!< All the flows, with batched traffic
+    std::unique_ptr<NodeSpatialIndex> m_gnbIndex; //!< gNB positions, alive during the run
+
+    TracedCallback<uint32_t, Ptr<const Packet>> m_ueRxTrace; //!< Deliveries, radio-only mode
+};
+
+} // namespace ns3
+
+#endif // NR_GAMING_SCENARIO_H
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef NR_LAYER_CLASSIFIER_H
+#define NR_LAYER_CLASSIFIER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * @brief Demangle a C++ symbol or type name.
+ * @param mangled the mangled name
+ * @return the demangled name, or the input if it is not a mangled name
+ */
+inline std::string
+DemangleSymbol(const char* mangled)
+{
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    if (status != 0 || demangled == nullptr)
+    {
+        return mangled;
+    }
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+}
+
+/**
+ * @brief Resolve a code address to the demangled name of the function containing it.
+ *
+ * Relies on the dynamic symbol table, which the ns-3 module libraries export.
+ *
+ * @param address a code address
+ * @return the function name, or an empty string if the address is not in a known function
+ */
+inline std::string
+ResolveCodeAddress(const void* address)
+{
+    Dl_info info{};
+    if (dladdr(address, &info) == 0 || info.dli_sname == nullptr)
+    {
+        return "";
+    }
+    return DemangleSymbol(info.dli_sname);
+}
+
+/**
+ * @brief Strip the parameter list, return type and template arguments of a function name.
+ *
+ * "void ns3::NrGnbPhy::StartSlot(ns3::SfnSf const&)" becomes "ns3::NrGnbPhy::StartSlot".
+ *
+ * @param name a demangled function name
+ * @return the qualified function name
+ */
+inline std::string
+ShortFunctionName(const std::string& name)
+{
+    std::string result;
+    int angle = 0;
+    int paren = 0;
+    for (std::size_t i = 0; i < name.size(); ++i)
+    {
+        const char c = name[i];
+        if (c == '<')
+        {
+            ++angle;
+        }
+        else if (c == '>' && angle > 0)
+        {
+            --angle;
+        }
+        else if (c == '[' && angle == 0)
+        {
+            // Skip ABI tags such as "[abi:cxx11]"
+            std::size_t close = name.find(']', i);
+            i = close == std::string::npos ? name.size() : close;
+        }
+        else if (c == '(' && angle == 0)
+        {
+            // The first top-level parenthesis opens the parameter list, unless it belongs to
+            // a "(anonymous namespace)" component
+            if (name.compare(i, 21, "(anonymous namespace)") != 0)
+            {
+                break;
+            }
+            ++paren;
+            result += c;
+        }
+        else if (c == ')' && paren > 0)
+        {
+            --paren;
+            result += c;
+        }
+        else if (c == ' ' && angle == 0 && paren == 0)
+        {
+            // Drop a leading return type
+            result.clear();
+        }
+        else if (angle == 0)
+        {
+            result += c;
+        }
+    }
+    return result.empty() ? name : result;
+}
+
+/**
+ * @brief Map a demangled class or function name to the NR stack layer it belongs to.
+ *
+ * The result is a ';'-separated path, such as "MAC;Scheduler", suitable as the leading frames
+ * of a collapsed stack. The more specific patterns are tested first.
+ *
+ * @param symbol a demangled class or function name
+ * @return the layer path
+ */
+inline std::string
+ClassifyNrLayer(const std::string& symbol)
+{
+    struct Rule
+    {
+        const char* pattern;
+        const char* layer;
+    };
+
+    static const Rule rules[] = {
+        {"NrPhyRxTrace", "Trace"},
+        {"NrMacRxTrace", "Trace"},
+        {"Trace", "Trace"},
+        {"Stats", "Trace"},
+        {"ThreeGppChannelModel", "Channel;FastFading"},
+        {"NYUChannelModel", "Channel;FastFading"},
+        {"TwoRay", "Channel;FastFading"},
+        {"SpectrumPropagationLoss", "Channel;FastFading"},
+        {"PropagationLoss", "Channel;Pathloss"},
+        {"ChannelCondition", "Channel;Pathloss"},
+        {"SpectrumChannel", "Channel;Propagation"},
+        {"Beamforming", "PHY;Beamforming"},
+        {"Eesm", "PHY;ErrorModel"},
+        {"ErrorModel", "PHY;ErrorModel"},
+        {"NrInterference", "PHY;Interference"},
+        {"NrChunkProcessor", "PHY;Interference"},
+        {"NrSpectrumPhy", "PHY;SpectrumPhy"},
+        {"NrAmc", "MAC;AMC"},
+        {"NrMacScheduler", "MAC;Scheduler"},
+        {"Harq", "MAC;HARQ"},
+        {"NrGnbPhy", "PHY"},
+        {"NrUePhy", "PHY"},
+        {"NrPhy", "PHY"},
+        {"Mac", "MAC"},
+        {"NrRlc", "RLC"},
+        {"NrPdcp", "PDCP"},
+        {"Rrc", "RRC"},
+        {"Epc", "EPC"},
+        {"Gtpu", "EPC"},
+        {"Ipv4", "IP"},
+        {"Udp", "IP"},
+        {"Tcp", "IP"},
+        {"Socket", "IP"},
+        {"PointToPoint", "IP"},
+        {"Queue", "IP"},
+        {"TrafficGenerator", "Application"},
+        {"Application", "Application"},
+        {"Mobility", "Mobility"},
+    };
+
+    for (const auto& rule : rules)
+    {
+        if (symbol.find(rule.pattern) != std::string::npos)
+        {
+            return rule.layer;
+        }
+    }
+    return "Other";
+}
+
+} // namespace ns3
+
+#endif // NR_LAYER_CLASSIFIER_H
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/**
+ * @file
+ * Stand-in link-adaptation agent for the MCS agent channel of the gaming scenario.
+ *
+ * Attaches to the shared region of a scenario run with --mcsAgent and answers every slot with
+ * an outer-loop link adaptation on top of the AMC: each UE keeps an MCS offset that drops by
+ * "step" on every lost TB and rises by step * targetBler / (1 - targetBler) on every decoded
+ * one, which settles the BLER at the target. It is a reference for external agents (the
+ * layout is that of mcs-agent-channel.h) and a way to measure the cost of the loop, e.g.
+ *
+ *     ./ns3 run "scratch/nr-gaming/opt-gsoc-nr-channel-models-error --mcsAgent=/nr-mcs" &
+ *     ./ns3 run "scratch/nr-gaming/nr-mcs-agent --name=/nr-mcs --targetBler=0.1"
+ */
+
+#include "mcs-agent-channel.h"
+
+#include "ns3/command-line.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+int
+main(int argc, char* argv[])
+{
+    std::string name = "/nr-mcs";
+    double targetBler = 0.1;
+    double step = 0.5;
+    double waitSec = 30;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("name", "Shared memory name given to the scenario with --mcsAgent.", name);
+    cmd.AddValue("targetBler", "BLER the outer loop settles at.", targetBler);
+    cmd.AddValue("step", "MCS offset removed for every lost TB.", step);
+    cmd.AddValue("waitSec", "How long to wait for the scenario to create the region.", waitSec);
+    cmd.Parse(argc, argv);
+
+    McsAgentChannel channel;
+    auto giveUp = std::chrono::steady_clock::now() + std::chrono::duration<double>(waitSec);
+    while (!channel.Open(name))
+    {
+        if (std::chrono::steady_clock::now() > giveUp)
+        {
+            fprintf(stderr, "No MCS agent channel %s\n", name.c_str());
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    uint32_t numUes = channel.GetNumUes();
+    printf("Attached to %s: %u UEs\n", name.c_str(), numUes);
+
+    const McsAgentObservation* observations = channel.GetObservations();
+    uint8_t* actions = channel.GetActions();
+    std::vector<double> offsets(numUes, 0.0);
+    double upStep = step * targetBler / (1 - targetBler);
+    uint64_t requests = 0;
+    uint64_t overrides = 0;
+    uint64_t acks = 0;
+    uint64_t nacks = 0;
+    uint32_t seq = channel.GetHeader()->request.load(std::memory_order_acquire);
+    while ((seq = channel.AwaitRequest(seq)) != 0)
+    {
+        for (uint32_t i = 0; i < numUes; ++i)
+        {
+            const McsAgentObservation& obs = observations[i];
+            offsets[i] += obs.acks * upStep - obs.nacks * step;
+            offsets[i] = std::clamp(offsets[i], -10.0, 10.0);
+            acks += obs.acks;
+            nacks += obs.nacks;
+            if (obs.cqi == 0)
+            {
+                // No CQI yet: nothing to adapt
+                actions[i] = McsAgentChannel::NO_OVERRIDE;
+                continue;
+            }
+            long mcs = std::lround(obs.amcMcs + offsets[i]);
+            actions[i] = static_cast<uint8_t>(std::clamp(mcs, 0L, 28L));
+            overrides++;
+        }
+        channel.Respond(seq);
+        requests++;
+    }
+    printf("%lu requests answered, %lu MCS overrides, BLER %.3f over %lu TBs\n",
+           static_cast<unsigned long>(requests),
+           static_cast<unsigned long>(overrides),
+           acks + nacks > 0 ? static_cast<double>(nacks) / (acks + nacks) : 0.0,
+           static_cast<unsigned long>(acks + nacks));
+    return 0;
+}
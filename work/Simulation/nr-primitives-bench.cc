@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/**
+ * @file
+ * Micro-benchmarks of the NR primitives the gaming scenario spends its time in.
+ *
+ * Every benchmark uses the configuration of the default scenario: 100 MHz at 30.5 GHz with
+ * numerology 1 (273 RBs), the NrEesmCcT1 error model, a 4x8 UPA at the gNB and a single
+ * element at the UE. The results are stable ns/op figures to optimize against, e.g.
+ *
+ *     ./ns3 run "scratch/nr-gaming/nr-primitives-bench --filter=Eesm --json=primitives.json"
+ */
+
+#include "micro-bench.h"
+#include "run-record.h"
+#include "trace-cost-accounting.h"
+
+#include "ns3/antenna-module.h"
+#include "ns3/beamforming-vector.h"
+#include "ns3/channel-condition-model.h"
+#include "ns3/command-line.h"
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/nr-amc.h"
+#include "ns3/nr-eesm-cc-t1.h"
+#include "ns3/nr-spectrum-value-helper.h"
+#include "ns3/three-gpp-channel-model.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+
+const double CENTRAL_FREQUENCY = 30.5e9; //!< Carrier of the scenario in Hz
+const uint16_t NUMEROLOGY = 1;           //!< Numerology of the scenario
+const uint32_t NUM_RBS = 273;            //!< RBs of 100 MHz with numerology 1
+
+/**
+ * @param seed stream of the random values
+ * @return a SINR per RB, uniform between -5 and 25 dB
+ */
+SpectrumValue
+MakeSinr(int64_t seed)
+{
+    Ptr<const SpectrumModel> model =
+        NrSpectrumValueHelper::GetSpectrumModel(NUM_RBS,
+                                                CENTRAL_FREQUENCY,
+                                                15e3 * (1 << NUMEROLOGY));
+    Ptr<UniformRandomVariable> sinrDb = CreateObject<UniformRandomVariable>();
+    sinrDb->SetStream(seed);
+    SpectrumValue sinr(model);
+    for (auto it = sinr.ValuesBegin(); it != sinr.ValuesEnd(); ++it)
+    {
+        *it = std::pow(10.0, sinrDb->GetValue(-5, 25) / 10.0);
+    }
+    return sinr;
+}
+
+/**
+ * @return an AMC using the error model of the scenario
+ */
+Ptr<NrAmc>
+MakeAmc()
+{
+    Ptr<NrAmc> amc = CreateObject<NrAmc>();
+    amc->SetAttribute("ErrorModelType", TypeIdValue(NrEesmCcT1::GetTypeId()));
+    amc->SetAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
+    return amc;
+}
+
+/**
+ * @param rows rows of the array
+ * @param cols columns of the array
+ * @return a uniform planar array of isotropic elements
+ */
+Ptr<UniformPlanarArray>
+MakeUpa(uint32_t rows, uint32_t cols)
+{
+    return CreateObjectWithAttributes<UniformPlanarArray>(
+        "NumRows",
+        UintegerValue(rows),
+        "NumColumns",
+        UintegerValue(cols),
+        "AntennaElement",
+        PointerValue(CreateObject<IsotropicAntennaModel>()));
+}
+
+/**
+ * @param position node position
+ * @return the mobility model of a new node at that position
+ */
+Ptr<MobilityModel>
+MakeNode(const Vector& position)
+{
+    Ptr<Node> node = CreateObject<Node>();
+    Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel>();
+    mobility->SetPosition(position);
+    node->AggregateObject(mobility);
+    return mobility;
+}
+
+/// Wideband CQI and MCS of a 273-RB SINR vector, as the UE reports every slot
+void
+BM_AmcMcsFromSinr(MicroBenchState& state)
+{
+    Ptr<NrAmc> amc = MakeAmc();
+    SpectrumValue sinr = MakeSinr(1);
+    for (auto _ : state)
+    {
+        uint8_t mcs = 0;
+        DoNotOptimize(amc->CreateCqiFeedbackSiso(sinr, mcs));
+        DoNotOptimize(mcs);
+    }
+}
+
+MICRO_BENCHMARK(BM_AmcMcsFromSinr);
+
+/// Transport block size for every MCS over a sweep of allocation sizes
+void
+BM_TbSize(MicroBenchState& state)
+{
+    Ptr<NrAmc> amc = MakeAmc();
+    uint32_t nprb = 1;
+    uint8_t mcs = 0;
+    for (auto _ : state)
+    {
+        DoNotOptimize(amc->CalculateTbSize(mcs, 1, nprb));
+        mcs = (mcs + 1) % 28;
+        nprb = nprb % NUM_RBS + 1;
+    }
+}
+
+MICRO_BENCHMARK(BM_TbSize);
+
+/// EESM effective SINR and BLER of a transport block over all the RBs, without HARQ history
+void
+BM_EesmEffectiveSinr(MicroBenchState& state)
+{
+    Ptr<NrEesmCcT1> errorModel = CreateObject<NrEesmCcT1>();
+    SpectrumValue sinr = MakeSinr(2);
+    std::vector<int> map(NUM_RBS);
+    for (uint32_t rb = 0; rb < NUM_RBS; ++rb)
+    {
+        map[rb] = rb;
+    }
+    const uint8_t mcs = 15;
+    uint32_t tbSize = MakeAmc()->CalculateTbSize(mcs, 1, NUM_RBS);
+    NrErrorModel::NrErrorModelHistory history;
+    for (auto _ : state)
+    {
+        Ptr<NrErrorModelOutput> output =
+            errorModel->GetTbDecodificationStats(sinr, map, tbSize, mcs, history);
+        DoNotOptimize(output->m_tbler);
+    }
+    state.SetItemsProcessed(state.GetIterations() * NUM_RBS);
+}
+
+MICRO_BENCHMARK(BM_EesmEffectiveSinr);
+
+/// Generation of a new UMa channel matrix between a 4x8 gNB array and a 1x1 UE
+void
+BM_ThreeGppChannel4x8(MicroBenchState& state)
+{
+    Ptr<MobilityModel> gnb = MakeNode(Vector(0, 0, 25));
+    Ptr<MobilityModel> ue = MakeNode(Vector(60, 30, 1.5));
+    Ptr<UniformPlanarArray> gnbArray = MakeUpa(4, 8);
+    Ptr<UniformPlanarArray> ueArray = MakeUpa(1, 1);
+    int64_t stream = 1;
+    for (auto _ : state)
+    {
+        // The model caches the matrix of a node pair: a fresh model per iteration
+        state.PauseTiming();
+        Ptr<ThreeGppChannelModel> model = CreateObject<ThreeGppChannelModel>();
+        model->SetAttribute("Frequency", DoubleValue(CENTRAL_FREQUENCY));
+        model->SetAttribute("Scenario", StringValue("UMa"));
+        model->SetAttribute("ChannelConditionModel",
+                            PointerValue(CreateObject<AlwaysLosChannelConditionModel>()));
+        stream += model->AssignStreams(stream);
+        state.ResumeTiming();
+        DoNotOptimize(model->GetChannel(gnb, ue, gnbArray, ueArray));
+    }
+    state.SetItemsProcessed(state.GetIterations() * gnbArray->GetNumElems());
+}
+
+MICRO_BENCHMARK(BM_ThreeGppChannel4x8);
+
+/// Beamforming vector of DirectPathBeamforming from a 4x8 gNB array towards moving UEs
+void
+BM_DirectPathBfv4x8(MicroBenchState& state)
+{
+    Ptr<MobilityModel> gnb = MakeNode(Vector(0, 0, 25));
+    std::vector<Ptr<MobilityModel>> ues;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        ues.push_back(MakeNode(Vector(50.0 * (i + 1), 30.0 * (i % 2 == 0 ? 1 : -1), 1.5)));
+    }
+    Ptr<UniformPlanarArray> gnbArray = MakeUpa(4, 8);
+    std::size_t next = 0;
+    for (auto _ : state)
+    {
+        DoNotOptimize(CreateDirectPathBfv(gnb, ues[next], gnbArray));
+        next = (next + 1) % ues.size();
+    }
+}
+
+MICRO_BENCHMARK(BM_DirectPathBfv4x8);
+
+/// One DlDataSinr trace record through the timed sink of the scenario: the formatting of
+/// NrPhyRxTrace and the write of the line to DlDataSinr.txt, in the working directory
+void
+BM_TraceRecordDlDataSinr(MicroBenchState& state)
+{
+    TraceCostAccounting traces;
+    uint16_t rnti = 1;
+    double avgSinr = 123.456;
+    for (auto _ : state)
+    {
+        traces.RecordDlDataSinr(1, rnti, avgSinr, 0);
+        rnti = rnti % 64 + 1;
+    }
+}
+
+MICRO_BENCHMARK(BM_TraceRecordDlDataSinr);
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    std::string filter = "";
+    double minTime = 0.5;
+    uint32_t repetitions = 5;
+    std::string json = "";
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("filter", "Run only the benchmarks whose name contains this string.", filter);
+    cmd.AddValue("minTime", "Minimum duration of one repetition in seconds.", minTime);
+    cmd.AddValue("repetitions",
+                 "Repetitions of every benchmark; the median time per operation is reported.",
+                 repetitions);
+    cmd.AddValue("json", "Write the results to this JSON file.", json);
+    cmd.Parse(argc, argv);
+
+    MicroBenchRunner runner(minTime, repetitions);
+    std::vector<MicroBenchResult> results = runner.RunAll(filter);
+    if (!json.empty())
+    {
+        RunRecord record;
+        record.Set("benchmarks", MicroBenchRunner::ToRecord(results));
+        record.Write(json);
+    }
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,411 @@
+#!/usr/bin/env python3
+"""Vectorized, gym-style environment running many instances of the NR scenario in parallel.
+
+Every environment is one scenario process (its own seed, channel model, UE count, ...) run
+with --mcsAgent in lockstep (--mcsAgentTimeoutUs=0): each slot it publishes the observation of
+every UE in its shared memory region (mcs-agent-channel.h) and waits for the DL MCS of every
+UE. This module maps all the regions and exposes them as batched NumPy arrays: step() writes
+the actions of all the environments, releases them all at once and collects the next
+observations, so the instances simulate their slots concurrently, one per core, and the
+Python side only copies a few kB per environment and step.
+
+A step lasts --slots-per-step slots (the decision epoch), repeating the same actions. An
+environment whose scenario reached its simulated time is done: step() returns its final
+observation in info["final_obs"] and relaunches it with the next run number (autoreset).
+The reward of an environment is the DL data decoded by its UEs over the step, in Mbit.
+
+Run from the ns-3 root folder after building the scenario. Without arguments, the module
+benchmarks itself: the AMC MCS is played back as the action and the steps per second of the
+batch are reported, to check that they scale with --envs up to the number of cores.
+
+Example:
+    ./nr_vec_env.py --envs 8 --ue-num 8 --channel-model ThreeGpp,Friis --steps 2000
+
+    from nr_vec_env import NrVecEnv
+    env = NrVecEnv([{"ueNum": 8, "channelModel": "ThreeGpp"}] * 8, slots_per_step=2)
+    obs = env.reset()
+    obs, reward, done, info = env.step(obs["amcMcs"])
+"""
+
+import argparse
+import ctypes
+import glob
+import mmap
+import os
+import platform
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+from bench_sweep import parse_list, scenario_args
+
+PROGRAM_GLOB = "build/scratch/nr-gaming/ns3*-opt-gsoc-nr-channel-models-error*"
+
+# Layout of the region, see McsAgentChannel
+MAGIC = 0x4741524E
+VERSION = 2
+HEADER_SIZE = 64
+NO_OVERRIDE = 255
+OBSERVATION = np.dtype(
+    [
+        ("ue", "<u4"),
+        ("cellId", "<u2"),
+        ("rnti", "<u2"),
+        ("sinrDb", "<f4", (8,)),
+        ("bufferBytes", "<u4"),
+        ("cqi", "u1"),
+        ("amcMcs", "u1"),
+        ("lastMcs", "u1"),
+        ("lastRv", "u1"),
+        ("acks", "<u2"),
+        ("nacks", "<u2"),
+        ("rxBytes", "<u4"),
+        ("reserved", "<u4", (2,)),
+    ]
+)
+assert OBSERVATION.itemsize == 64
+# Header words, in uint32 units
+MAGIC_WORD, VERSION_WORD, NUM_UES_WORD, OBSERVATION_SIZE_WORD = 0, 1, 2, 3
+REQUEST_WORD, RESPONSE_WORD, AGENTS_WORD, CLOSED_WORD, AGENT_PID_WORD = 8, 9, 10, 11, 12
+
+SYS_FUTEX = {"x86_64": 202, "aarch64": 98}[platform.machine()]
+FUTEX_WAIT, FUTEX_WAKE = 0, 1
+SPIN_ITERATIONS = 200
+_libc = ctypes.CDLL(None, use_errno=True)
+
+# NumPy reads and writes the region with plain loads and stores. x86-64 keeps them in order;
+# elsewhere (aarch64) a fence must separate the actions from the response word, and the
+# request word from the observations. A system call is not a barrier, but membarrier(2) of
+# the process is one on entry and exit.
+if platform.machine() == "x86_64":
+
+    def _fence():
+        pass
+
+else:
+    SYS_MEMBARRIER = {"aarch64": 283}[platform.machine()]
+    MEMBARRIER_CMD_GLOBAL, MEMBARRIER_CMD_PRIVATE_EXPEDITED = 1 << 0, 1 << 3
+    MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED = 1 << 4
+    # The expedited command costs a system call; the global one, kept for kernels before
+    # 4.14, waits for a grace period
+    _MEMBARRIER_CMD = (
+        MEMBARRIER_CMD_PRIVATE_EXPEDITED
+        if _libc.syscall(SYS_MEMBARRIER, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0
+        else MEMBARRIER_CMD_GLOBAL
+    )
+
+    def _fence():
+        if _libc.syscall(SYS_MEMBARRIER, _MEMBARRIER_CMD, 0) != 0:
+            raise OSError(ctypes.get_errno(), "membarrier failed")
+
+
+class _Timespec(ctypes.Structure):
+    _fields_ = [("tv_sec", ctypes.c_long), ("tv_nsec", ctypes.c_long)]
+
+
+_WAIT_CHECK = _Timespec(0, 100_000_000)  # liveness check of the scenario while waiting
+
+
+class Region:
+    """The shared memory region of one scenario, attached as its only agent."""
+
+    def __init__(self, name, alive, timeout=60.0):
+        path = "/dev/shm/" + name.lstrip("/")
+        deadline = time.monotonic() + timeout
+        while True:
+            self._mm = self._try_map(path)
+            if self._mm is not None:
+                break
+            if not alive() or time.monotonic() > deadline:
+                raise RuntimeError(f"no MCS agent channel {name}")
+            time.sleep(0.01)
+        self.words = np.frombuffer(self._mm, np.uint32, count=HEADER_SIZE // 4)
+        self.num_ues = int(self.words[NUM_UES_WORD])
+        self.obs = np.frombuffer(self._mm, OBSERVATION, self.num_ues, HEADER_SIZE)
+        self.actions = np.frombuffer(
+            self._mm, np.uint8, self.num_ues, HEADER_SIZE + self.num_ues * OBSERVATION.itemsize
+        )
+        base = ctypes.addressof(ctypes.c_char.from_buffer(self._mm))
+        self._request = ctypes.c_void_p(base + 4 * REQUEST_WORD)
+        self._response = ctypes.c_void_p(base + 4 * RESPONSE_WORD)
+        # The scenario checks that this process is alive while it waits for it
+        self.words[AGENT_PID_WORD] = os.getpid()
+        self.words[AGENTS_WORD] = 1
+        self.seq = int(self.words[REQUEST_WORD])
+
+    @staticmethod
+    def _try_map(path):
+        """Map the region once the scenario has initialized it, else return None."""
+        try:
+            fd = os.open(path, os.O_RDWR)
+        except FileNotFoundError:
+            return None
+        try:
+            size = os.fstat(fd).st_size
+            if size < HEADER_SIZE:
+                return None
+            mm = mmap.mmap(fd, size)
+        finally:
+            os.close(fd)
+        words = np.frombuffer(mm, np.uint32, count=4)
+        ready = (
+            words[MAGIC_WORD] == MAGIC
+            and words[VERSION_WORD] == VERSION
+            and words[OBSERVATION_SIZE_WORD] == OBSERVATION.itemsize
+        )
+        num_ues = int(words[NUM_UES_WORD])
+        del words
+        if not ready:
+            mm.close()
+            return None
+        # Observations and actions of every UE, as McsAgentChannel::Open checks
+        if size < HEADER_SIZE + num_ues * (OBSERVATION.itemsize + 1):
+            mm.close()
+            raise RuntimeError(f"{path}: {size} bytes, too small for {num_ues} UEs")
+        return mm
+
+    def closed(self):
+        return bool(self.words[CLOSED_WORD])
+
+    def await_request(self, alive):
+        """Wait for the next request; return False once the scenario closed the channel."""
+        for _ in range(SPIN_ITERATIONS):
+            if self.words[REQUEST_WORD] != self.seq:
+                break
+        while self.words[REQUEST_WORD] == self.seq:
+            _libc.syscall(
+                SYS_FUTEX,
+                self._request,
+                FUTEX_WAIT,
+                ctypes.c_uint32(self.seq),
+                ctypes.byref(_WAIT_CHECK),
+                None,
+                0,
+            )
+            if self.words[REQUEST_WORD] == self.seq and not alive():
+                raise RuntimeError("scenario exited without closing its MCS agent channel")
+        self.seq = int(self.words[REQUEST_WORD])
+        _fence()  # Acquire: the observations are read after the request
+        return not self.closed()
+
+    def respond(self):
+        """Publish the actions of the pending request."""
+        _fence()  # Release: the actions are visible before the response
+        self.words[RESPONSE_WORD] = self.seq
+        _libc.syscall(SYS_FUTEX, self._response, FUTEX_WAKE, 0x7FFFFFFF, None, None, 0)
+
+    def close(self):
+        """Detach, so that a scenario still waiting gives up on its request."""
+        self.words[AGENT_PID_WORD] = 0
+        self.words[AGENTS_WORD] = 0
+        _libc.syscall(SYS_FUTEX, self._response, FUTEX_WAKE, 0x7FFFFFFF, None, None, 0)
+        del self.words, self.obs, self.actions
+        self._mm.close()
+
+
+def find_program(ns3_root):
+    """Path of the scenario executable built in an ns-3 tree."""
+    for path in sorted(glob.glob(os.path.join(ns3_root, PROGRAM_GLOB))):
+        if os.access(path, os.X_OK) and not path.endswith(".so"):
+            return path
+    raise FileNotFoundError(
+        "scenario not built: ./ns3 build scratch/nr-gaming/opt-gsoc-nr-channel-models-error"
+    )
+
+
+class NrVecEnv:
+    """N scenario instances stepped together, observations and actions as batched arrays.
+
+    configs: one dict of scenario parameters per environment, as in bench_sweep.py
+    (e.g. {"ueNum": 8, "channelModel": "Friis", "gnbAntenna": "4x8"}).
+    """
+
+    def __init__(
+        self,
+        configs,
+        slots_per_step=1,
+        sim_time="1s",
+        ns3_root=".",
+        program=None,
+        work_dir="vec_env_runs",
+        extra_args=(),
+        first_run=1,
+    ):
+        self.configs = list(configs)
+        self.num_envs = len(self.configs)
+        self.slots_per_step = slots_per_step
+        self.sim_time = sim_time
+        self.program = os.path.abspath(program or find_program(ns3_root))
+        self.work_dir = os.path.abspath(work_dir)
+        self.extra_args = list(extra_args)
+        self.first_run = first_run
+        self.episodes = [0] * self.num_envs
+        self.procs = [None] * self.num_envs
+        self.regions = [None] * self.num_envs
+        self.names = [f"/nr-vec-{os.getpid()}-{i}" for i in range(self.num_envs)]
+        self.obs = None
+        self.ue_mask = None
+
+    def _launch(self, i):
+        """Start environment i for its next episode and attach to its region."""
+        name = self.names[i]
+        run = self.first_run + i + self.num_envs * self.episodes[i]
+        run_dir = os.path.join(self.work_dir, f"env{i}")
+        os.makedirs(run_dir, exist_ok=True)
+        # The configuration and extra arguments come last and win
+        args = (
+            [
+                self.program,
+                "--enableTraces=false",
+                "--logging=false",
+                "--flowKpis=false",
+                "--fingerprint=false",
+                f"--simTime={self.sim_time}",
+                f"--run={run}",
+            ]
+            + scenario_args(self.configs[i])
+            + self.extra_args
+            + [f"--mcsAgent={name}", "--mcsAgentTimeoutUs=0"]
+        )
+        with open(os.path.join(run_dir, f"episode{self.episodes[i]}.log"), "w") as log:
+            proc = subprocess.Popen(args, cwd=run_dir, stdout=log, stderr=subprocess.STDOUT)
+        self.procs[i] = proc
+        self.regions[i] = Region(name, self._alive(i))
+
+    def _alive(self, i):
+        """Liveness check of the current scenario process of environment i."""
+        proc = self.procs[i]
+        return lambda: proc.poll() is None
+
+    def _first_observation(self, i):
+        region = self.regions[i]
+        if not region.await_request(self._alive(i)):
+            raise RuntimeError(f"environment {i} ended before its first slot")
+        self.obs[i, : region.num_ues] = region.obs
+
+    def reset(self):
+        """Start every environment; return the batched observations (envs x UEs)."""
+        self.close()
+        for i in range(self.num_envs):
+            self._launch(i)
+        max_ues = max(region.num_ues for region in self.regions)
+        self.obs = np.zeros((self.num_envs, max_ues), OBSERVATION)
+        self.ue_mask = np.zeros((self.num_envs, max_ues), bool)
+        for i, region in enumerate(self.regions):
+            self.ue_mask[i, : region.num_ues] = True
+            self._first_observation(i)
+        return self.obs
+
+    def step(self, actions):
+        """Apply the DL MCS of every UE (envs x UEs, 255 keeps the AMC) for one decision epoch.
+
+        Return (obs, reward, done, info) with obs envs x UEs, reward and done per environment.
+        """
+        actions = np.asarray(actions, np.uint8)
+        reward = np.zeros(self.num_envs)
+        done = np.zeros(self.num_envs, bool)
+        info = {"final_obs": [None] * self.num_envs}
+        for i, region in enumerate(self.regions):
+            region.actions[:] = actions[i, : region.num_ues]
+        for _ in range(self.slots_per_step):
+            # Release every environment first, so that they simulate the slot in parallel
+            for i, region in enumerate(self.regions):
+                if not done[i]:
+                    region.respond()
+            for i, region in enumerate(self.regions):
+                if done[i]:
+                    continue
+                if region.await_request(self._alive(i)):
+                    reward[i] += region.obs["rxBytes"].sum() * 8 / 1e6
+                    self.obs[i, : region.num_ues] = region.obs
+                else:
+                    done[i] = True
+        for i in np.flatnonzero(done):
+            info["final_obs"][i] = self.obs[i].copy()
+            self._restart(i)
+        return self.obs, reward, done, info
+
+    def _restart(self, i):
+        """Autoreset: replace environment i by a fresh episode with the next run number."""
+        self.regions[i].close()
+        self.procs[i].wait()
+        self.episodes[i] += 1
+        self._launch(i)
+        if self.regions[i].num_ues > self.obs.shape[1]:
+            raise RuntimeError(f"environment {i} changed its number of UEs")
+        self.obs[i] = np.zeros(1, OBSERVATION)
+        self._first_observation(i)
+
+    def close(self):
+        """Detach from and stop every environment."""
+        for i, region in enumerate(self.regions):
+            if region is not None:
+                region.close()
+                self.regions[i] = None
+        for i, proc in enumerate(self.procs):
+            if proc is not None:
+                if proc.poll() is None:
+                    proc.terminate()
+                proc.wait()
+                self.procs[i] = None
+            # A terminated scenario leaves its region behind
+            try:
+                os.unlink("/dev/shm/" + self.names[i].lstrip("/"))
+            except FileNotFoundError:
+                pass
+
+
+def amc_actions(obs):
+    """Play back the AMC MCS, or leave the UE to the AMC until its first CQI."""
+    return np.where(obs["cqi"] > 0, obs["amcMcs"], NO_OVERRIDE).astype(np.uint8)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--envs", type=int, default=os.cpu_count())
+    parser.add_argument("--ue-num", type=lambda t: parse_list(t, int), default=[8])
+    parser.add_argument("--channel-model", type=lambda t: parse_list(t, str), default=["ThreeGpp"])
+    parser.add_argument("--sim-time", default="1s", help="simulated time of every episode")
+    parser.add_argument("--slots-per-step", type=int, default=1, help="decision epoch in slots")
+    parser.add_argument("--steps", type=int, default=1000)
+    parser.add_argument("--ns3-root", default=".")
+    parser.add_argument("--work-dir", default="vec_env_runs")
+    # Unknown options are passed to every scenario, e.g. --fullBuffer=true
+    args, passthrough = parser.parse_known_args()
+
+    # Environments cycle over the combinations of UE counts and channel models
+    combos = [{"ueNum": n, "channelModel": c} for n in args.ue_num for c in args.channel_model]
+    configs = [combos[i % len(combos)] for i in range(args.envs)]
+    env = NrVecEnv(
+        configs,
+        slots_per_step=args.slots_per_step,
+        sim_time=args.sim_time,
+        ns3_root=args.ns3_root,
+        work_dir=args.work_dir,
+        extra_args=passthrough,
+    )
+    try:
+        obs = env.reset()
+        start = time.monotonic()
+        episodes = 0
+        total_reward = 0.0
+        for _ in range(args.steps):
+            obs, reward, done, _ = env.step(amc_actions(obs))
+            total_reward += reward.sum()
+            episodes += int(done.sum())
+        elapsed = time.monotonic() - start
+    finally:
+        env.close()
+    slots = args.steps * args.slots_per_step * args.envs
+    print(
+        f"{args.envs} environments, {args.steps} steps of {args.slots_per_step} slot(s) in "
+        f"{elapsed:.2f} s: {args.steps / elapsed:.0f} batched steps/s, {slots / elapsed:.0f} "
+        f"env-slots/s, {episodes} episodes ended, {total_reward:.1f} Mbit decoded"
+    )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
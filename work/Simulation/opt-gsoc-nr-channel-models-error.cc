@@ -3,32 +3,30 @@
 //
 // SPDX-License-Identifier: GPL-2.0-only
 
-#include "ns3/antenna-module.h"
-#include "ns3/applications-module.h"
+#include "allocation-profiler.h"
+#include "batched-gaming-traffic.h"
+#include "binary-log.h"
+#include "external-mcs-control.h"
+#include "flow-kpi-collector.h"
+#include "hw-perf-counters.h"
+#include "nr-gaming-scenario.h"
+#include "process-stats.h"
+#include "profiling-scheduler.h"
+#include "realtime-slot-monitor.h"
+#include "run-fingerprint.h"
+#include "run-record.h"
+#include "scenario-resource-estimator.h"
+#include "setup-phase-profiler.h"
+#include "slot-arena-scheduler.h"
+#include "timing-wheel-scheduler.h"
+#include "trace-cost-accounting.h"
+
 #include "ns3/command-line.h"
-#include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/core-module.h"
-#include "ns3/internet-apps-module.h"
-#include "ns3/internet-module.h"
-#include "ns3/ipv4-global-routing-helper.h"
-#include "ns3/isotropic-antenna-model.h"
 #include "ns3/log.h"
-#include "ns3/mobility-module.h"
-#include "ns3/multi-model-spectrum-channel.h"
-#include "ns3/nr-helper.h"
-#include "ns3/nr-module.h"
-#include "ns3/nr-point-to-point-epc-helper.h"
-#include "ns3/parabolic-antenna-model.h"
-#include "ns3/point-to-point-helper.h"
-#include "ns3/pointer.h"
-#include "ns3/traffic-generator-helper.h"
-#include "ns3/traffic-generator-ngmn-gaming.h"
-#include "ns3/udp-client-server-helper.h"
 
 using namespace ns3;
 
-NS_LOG_COMPONENT_DEFINE("GsocNrChannelModels");
-
 /**
  * @ingroup examples
  * @file gsoc-nr-channel-models.cc
@@ -76,8 +74,9 @@ NS_LOG_COMPONENT_DEFINE("GsocNrChannelModels");
  *   Each UE runs a UDP server, and the remote host runs UDP clients sending a stream of
  *   packets at a fixed interval.
  * - **Performance Monitoring & Tracing:**
- *     - Employs the FlowMonitor module to collect and report key performance indicators (KPIs)
- *       such as throughput, packet loss, delay, and jitter for each data flow. These
+ *     - Collects key performance indicators (KPIs) such as throughput, packet loss, delay,
+ *       and jitter for each data flow with a FlowKpiCollector, hooked on the gaming sources
+ *       and on the UEs (FlowMonitor's per-packet tagging is too costly at scale). These
  *       statistics are written to "channels-example-flows.txt".
  *     - Enables detailed NR trace generation, including pathloss (`Pathloss.txt`),
  *       uplink SINR (`UlCtrlSinr.txt`, `UlDataSinr.txt`), downlink SINR (`DlCtrlSinr.txt`,
@@ -85,8 +84,9 @@ NS_LOG_COMPONENT_DEFINE("GsocNrChannelModels");
  *       *(Note: The `nrHelper->EnableTraces()` call in the current code primarily enables
  *       UL SINR traces; specific DL SINR/CQI traces would require `EnableDlSinrTraces()`
  *       and `EnableDlCqiTraces()` respectively.)*
- * - **Output & Logging:** Provides console output indicating simulation progress and
- *   parameter settings. Supports optional detailed ns-3 logging.
+ * - **Output & Logging:** Prints the results of the run (runtime, events, fingerprint) and
+ *   records the progress and parameter settings in a structured binary event log
+ *   (`channels-example.blog`, decoded offline by `binlog_decode.py`).
  *
  *
  * @note This example was produced during the Google Summer of Code 2024 program. The main author is
@@ -102,6 +102,7 @@ main(int argc, char* argv[])
     int64_t randomStream = 1;
     uint32_t rngSeed = 1;
     uint32_t rngRun = 1;
+    bool crn = false;
 
     double centralFrequency = 30.5e9;               // 30.5 GHz
     double bandwidth = 100e6;                       // 100 MHz
@@ -112,11 +113,47 @@ main(int argc, char* argv[])
     std::string channelModel = "ThreeGpp";          // 3GPP channel model
     uint32_t numUes = 4;                            // Number of UEs
     uint32_t numGnbs = 1;                           // Number of gNBs
-    bool logging = true;                            // Enable logging
+    bool logging = true;                            // Binary event log
+    std::string logFile = "channels-example.blog";  // File of that log
+    std::string logLevel = "info";                  // Most verbose level logged
     uint16_t numerology = 1;                        // Numerology
     std::string errorModelType = "ns3::NrEesmCcT1"; // Default error model
     std::string amcSelectionModel = "ErrorModel";   // "ErrorModel" or "ShannonModel"
-    printf("Starting GSoC NR Channel Models Example\n");
+    bool largeScale = false;                        // Multi-site, three-sector layout
+    uint32_t numRings = 1;                          // Outer rings of sites (large-scale mode)
+    uint32_t uesPerSector = 10;                     // UE drop density (large-scale mode)
+    double memBudgetMb = 0;                         // Memory budget in MB (0 = unlimited)
+    double timeBudgetSec = 0;                       // Runtime budget in seconds (0 = unlimited)
+    std::string startupProfile = "";                // JSON file for the setup phase costs
+    bool enableTraces = true;                       // NR PHY/MAC/pathloss trace files
+    std::string benchJson = "";                     // JSON file for the benchmark record
+    bool profileEvents = false;                     // Wall time per event target
+    std::string profileOutput = "";                 // Collapsed-stack file of that profile
+    bool hwCounters = false;                        // Hardware performance counters
+    bool allocProfile = false;                      // Allocation sites during the run
+    uint32_t allocSamplePeriod = 1000;              // Sample one allocation stack in N
+    std::string allocTimeline = "";                 // CSV file of live bytes over time
+    bool fingerprint = true;                        // Fingerprint of events, traces and KPIs
+    bool flowKpis = true;                           // Per-UE throughput, loss, delay, jitter
+    bool radioOnly = false;                         // No EPC/IP, traffic injected at the gNBs
+    bool batchedTraffic = false;                    // Gaming arrivals, one event per slot
+    std::string replayTrace = "";                   // Binary traffic trace to replay
+    bool fullBuffer = false;                        // Saturated DL/UL buffers, no applications
+    double rlcBufferMs = 0;                         // RLC UM buffer bound (0 = 1 GB cap)
+    bool pooledRlc = false;                         // gNB RLC UM buffers on a pooled ring
+    std::string rlcDropPolicy = "TailDrop";         // TailDrop or HeadDrop, with pooledRlc
+    std::string scheduler = "Map";                  // Event scheduler of the simulator
+    bool slotArena = false;                         // PHY/MAC allocations from the arena
+    bool realtime = false;                          // Paced by the wall clock
+    double maxLagMs = 5;                            // Slot lag beyond which realtime fails
+    std::string realtimePolicy = "degrade";         // Reaction to a late slot
+    std::string mcsAgent = "";                      // Shared memory of an external MCS agent
+    double mcsAgentTimeoutUs = 500;                 // Longest wait for its decisions
+    // Antenna parameters
+    uint32_t ueNumRows = 1;  // Number of rows for the UE antenna
+    uint32_t ueNumCols = 1;  // Number of columns for the UE antenna
+    uint32_t gnbNumRows = 4; // Number of rows for the gNB antenna
+    uint32_t gnbNumCols = 8; // Number of columns for the gNB antenna
     /**
      * Default channel condition model: This model varies based on the selected scenario.
      * For instance, in the Urban Macro scenario, the default channel condition model is
@@ -128,6 +165,11 @@ main(int argc, char* argv[])
     // cmd.Usage(""); Leave it empty until we decide the final example
     cmd.AddValue("seed", "RNG seed value (default=1)", rngSeed);
     cmd.AddValue("run", "RNG run number (default=1)", rngRun);
+    cmd.AddValue("crn",
+                 "Common random numbers: pin the random streams of the UE mobility, traffic, "
+                 "shadowing, fast fading and TB errors by role instead of installation order, "
+                 "so runs of different models with the same seed and run share them.",
+                 crn);
 
     cmd.AddValue("channelModel",
                  "The channel model for the simulation, which can be 'NYU', "
@@ -140,269 +182,571 @@ main(int argc, char* argv[])
     cmd.AddValue("ueNum", "Number of UEs in the simulation.", numUes);
     cmd.AddValue("gNbNum", "Number of gNBs in the simulation.", numGnbs);
     cmd.AddValue("frequency", "The central carrier frequency in Hz.", centralFrequency);
-    cmd.AddValue("logging", "Enable logging", logging);
+    cmd.AddValue("bandwidth", "The channel bandwidth in Hz.", bandwidth);
+    cmd.AddValue("simTime", "Simulated time.", simTime);
+    cmd.AddValue("gnbNumRows", "Rows of the gNB antenna array.", gnbNumRows);
+    cmd.AddValue("gnbNumCols", "Columns of the gNB antenna array.", gnbNumCols);
+    cmd.AddValue("ueNumRows", "Rows of the UE antenna array.", ueNumRows);
+    cmd.AddValue("ueNumCols", "Columns of the UE antenna array.", ueNumCols);
+    cmd.AddValue("enableTraces", "Write the NR PHY, MAC and pathloss trace files.", enableTraces);
+    cmd.AddValue("logging",
+                 "Write the binary event log (decode it with binlog_decode.py).",
+                 logging);
+    cmd.AddValue("logFile", "File of the binary event log.", logFile);
+    cmd.AddValue("logLevel", "Most verbose level logged: error, warn, info or debug.", logLevel);
+    cmd.AddValue("largeScale",
+                 "Sectorized multi-ring hexagonal layout (three sectors per site). "
+                 "Overrides ueNum and gNbNum.",
+                 largeScale);
+    cmd.AddValue("numRings",
+                 "Outer rings of sites around the central one in large-scale mode "
+                 "(0: 1 site, 1: 7 sites, 2: 19 sites, up to 5).",
+                 numRings);
+    cmd.AddValue("uesPerSector", "UEs dropped per sector in large-scale mode.", uesPerSector);
+    cmd.AddValue("memBudgetMb",
+                 "Refuse the run if the estimated memory exceeds this many MB (0 = no budget).",
+                 memBudgetMb);
+    cmd.AddValue("timeBudgetSec",
+                 "Refuse the run if the estimated runtime exceeds this many seconds "
+                 "(0 = no budget).",
+                 timeBudgetSec);
+    cmd.AddValue("startupProfile",
+                 "Write the wall time, allocations and RSS growth of every setup phase to this "
+                 "JSON file (empty = print only).",
+                 startupProfile);
+    cmd.AddValue("benchJson",
+                 "Write the run parameters and performance metrics to this JSON file "
+                 "(read by bench_sweep.py).",
+                 benchJson);
+    cmd.AddValue("profileEvents",
+                 "Attribute the wall time of the simulation to the callback of every event and "
+                 "print it per NR layer at the end.",
+                 profileEvents);
+    cmd.AddValue("profileOutput",
+                 "Write the event profile in collapsed-stack format to this file, for "
+                 "flamegraph.pl or speedscope (implies profileEvents).",
+                 profileOutput);
+    cmd.AddValue("hwCounters",
+                 "Read cycles, instructions, LLC and branch misses (perf_event_open) around the "
+                 "setup phases, Simulator::Run() and, with profileEvents, every event.",
+                 hwCounters);
+    cmd.AddValue("allocProfile",
+                 "Sample the call stacks of the allocations during the run and report the top "
+                 "allocating sites per NR layer, per simulated second and per slot.",
+                 allocProfile);
+    cmd.AddValue("allocSamplePeriod",
+                 "Sample the call stack of one allocation in this many (allocProfile).",
+                 allocSamplePeriod);
+    cmd.AddValue("radioOnly",
+                 "Skip the EPC, remote host and IP stacks and inject the gaming traffic straight "
+                 "into the gNB of every UE (link-adaptation dataset runs).",
+                 radioOnly);
+    cmd.AddValue("batchedTraffic",
+                 "Generate the gaming traffic of all the UEs from one application, with the "
+                 "arrivals of a slot delivered by a single event.",
+                 batchedTraffic);
+    cmd.AddValue("replayTrace",
+                 "Replay the per-RNTI byte arrivals of this binary traffic trace (written by "
+                 "effnet_to_replay.py) instead of the NGMN gaming traffic; UE i replays the "
+                 "(i mod N)-th RNTI of the trace.",
+                 replayTrace);
+    cmd.AddValue("fullBuffer",
+                 "Keep the RLC buffers of every UE backlogged in DL and UL (RLC saturation "
+                 "mode) instead of running gaming traffic, to benchmark the worst-case "
+                 "scheduling, AMC and PHY cost per slot.",
+                 fullBuffer);
+    cmd.AddValue("rlcBufferMs",
+                 "Bound every RLC UM transmit buffer to this many ms of traffic at the peak "
+                 "rate of the carrier, dropping new SDUs once full (0 keeps the 1 GB cap).",
+                 rlcBufferMs);
+    cmd.AddValue("pooledRlc",
+                 "Hold the RLC UM transmit buffers of the gNBs in a ring of pooled SDU slots, "
+                 "with O(1) segmentation of the head, under the same bound "
+                 "(see pooled-rlc-um.h).",
+                 pooledRlc);
+    cmd.AddValue("rlcDropPolicy",
+                 "What a full pooled RLC buffer drops: TailDrop (the new SDU) or HeadDrop (the "
+                 "oldest SDUs not yet started).",
+                 rlcDropPolicy);
+    cmd.AddValue("scheduler",
+                 "Event scheduler: Map, Heap, Calendar, List, PriorityQueue or TimingWheel "
+                 "(buckets of one OFDM symbol, see timing-wheel-scheduler.h).",
+                 scheduler);
+    cmd.AddValue("slotArena",
+                 "Serve the small allocations of the PHY and channel events from a per-slot "
+                 "bump arena, and those of the MAC events from HARQ-lifetime pools.",
+                 slotArena);
+    cmd.AddValue("realtime",
+                 "Pace the simulation by the wall clock (RealtimeSimulatorImpl) and track the "
+                 "lag and CPU load of every slot.",
+                 realtime);
+    cmd.AddValue("maxLagMs",
+                 "Lag of a slot behind the wall clock, in ms, beyond which realtime mode "
+                 "applies realtimePolicy.",
+                 maxLagMs);
+    cmd.AddValue("realtimePolicy",
+                 "Reaction to a late slot in realtime mode: report, stop, or degrade (mute the "
+                 "traces, then switch to a pathloss-only channel, then stop).",
+                 realtimePolicy);
+    cmd.AddValue("mcsAgent",
+                 "Publish per-UE observations every slot to an external link-adaptation agent "
+                 "over this POSIX shared memory (e.g. /nr-mcs, see nr-mcs-agent) and apply "
+                 "the DL MCS it answers with.",
+                 mcsAgent);
+    cmd.AddValue("mcsAgentTimeoutUs",
+                 "Longest wait for the agent's MCS decisions of a slot, in us; the slot keeps "
+                 "the AMC MCS without them. 0 runs in lockstep with the agent, e.g. to train "
+                 "it with nr_vec_env.py.",
+                 mcsAgentTimeoutUs);
+    cmd.AddValue("flowKpis",
+                 "Collect the throughput, loss, delay and jitter of every gaming flow and write "
+                 "them to channels-example-flows.txt.",
+                 flowKpis);
+    cmd.AddValue("fingerprint",
+                 "Compute a 128-bit fingerprint of the executed events, trace records and final "
+                 "KPIs, to check that two runs produced bit-identical results.",
+                 fingerprint);
+    cmd.AddValue("allocTimeline",
+                 "Write the live bytes and allocation counts every 10 ms of simulated time to "
+                 "this CSV file.",
+                 allocTimeline);
     cmd.Parse(argc, argv);
-    printf("Channel model: %s\n", channelModel.c_str());
-    printf("Channel condition model: %s\n", channelConditionModel.c_str());
-    printf("Number of UEs: %u\n", numUes);
-    printf("Number of gNBs: %u\n", numGnbs);
-    printf("Central frequency: %.2f GHz\n", centralFrequency / 1e9);
+    BinaryLog::Level level;
+    NS_ABORT_MSG_UNLESS(BinaryLog::ParseLevel(logLevel, level), "Unknown logLevel " << logLevel);
+    if (logging && !BinaryLog::Get().Open(logFile, level))
+    {
+        printf("Cannot open the event log %s, logging disabled\n", logFile.c_str());
+    }
+    BINLOG_INFO("Starting GSoC NR Channel Models Example");
+    BINLOG_INFO("Channel model: %s", channelModel);
+    BINLOG_INFO("Channel condition model: %s", channelConditionModel);
+    BINLOG_INFO("Number of UEs: %u", numUes);
+    BINLOG_INFO("Number of gNBs: %u", numGnbs);
+    BINLOG_INFO("Central frequency: %.2f GHz", centralFrequency / 1e9);
     cmd.AddValue("errorModelType",
                  "NR Error Model Type (e.g., ns3::NrEesmCcT1, ns3::NrLteMiErrorModel)",
                  errorModelType);
     cmd.AddValue("amcSelectionModel",
                  "AMC selection logic: ErrorModel or ShannonModel",
                  amcSelectionModel);
-    if (logging)
+    RealtimeSlotMonitor::Policy policy;
+    NS_ABORT_MSG_UNLESS(RealtimeSlotMonitor::ParsePolicy(realtimePolicy, policy),
+                        "Unknown realtimePolicy " << realtimePolicy);
+    if (realtime)
     {
-        LogComponentEnable("GsocNrChannelModels", LOG_LEVEL_INFO);
+        // BestEffort: a late event runs late instead of aborting, the monitor measures it
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::RealtimeSimulatorImpl"));
+        Config::SetDefault("ns3::RealtimeSimulatorImpl::SynchronizationMode",
+                           StringValue("BestEffort"));
     }
-
-    // Create the simulated scenario
-    HexagonalGridScenarioHelper hexGrid;
-    /**
-     * Set the scenario parameters for the simulation, considering the UMa scenario.
-     * Following the TR 38.901 specification - Table 7.4.1-1 pathloss models.
-     * hBS = 25m for UMa scenario.
-     * hUT = 1.5m for UMa scenario.
-     */
-    hexGrid.SetUtHeight(1.5);    // Height of the UE in meters
-    hexGrid.SetBsHeight(25);     // Height of the gNB in meters
-    hexGrid.SetSectorization(1); // Number of sectors
-    hexGrid.m_isd = 200;         // Inter-site distance in meters
-    uint32_t ueTxPower = 23;     // UE transmission power in dBm
-    uint32_t bsTxPower = 41;     // gNB transmission power in dBm
-    double ueSpeed = 30;         // in m/s (3 km/h)
-    // Antenna parameters
-    uint32_t ueNumRows = 1;  // Number of rows for the UE antenna
-    uint32_t ueNumCols = 1;  // Number of columns for the UE antenna
-    uint32_t gnbNumRows = 4; // Number of rows for the gNB antenna
-    uint32_t gnbNumCols = 8; // Number of columns for the gNB antenna
-    // Set the number of UEs and gNBs nodes in the scenario
-    hexGrid.SetUtNumber(numUes);  // Number of UEs
-    hexGrid.SetBsNumber(numGnbs); // Number of gNBs
-    // Create a scenario with mobility
-    hexGrid.CreateScenarioWithMobility(Vector(ueSpeed, 0.0, 0.0),
-                                       0); // move UE with 3 km/h in x-axis
-
-    auto ueNodes = hexGrid.GetUserTerminals();
-    auto gNbNodes = hexGrid.GetBaseStations();
-
-    NS_LOG_INFO("Number of UEs: " << ueNodes.GetN() << ", Number of gNBs: " << gNbNodes.GetN());
-    for (size_t ueIndex = 0; ueIndex < ueNodes.GetN(); ueIndex++)
+    // Set before the setup schedules its first events
+    std::string schedulerType = "ns3::" + scheduler + "Scheduler";
+    Config::SetDefault("ns3::TimingWheelScheduler::Granularity",
+                       TimeValue(MilliSeconds(1) / (14 << numerology)));
+    ObjectFactory schedulerFactory(schedulerType);
+    if (profileEvents || !profileOutput.empty())
     {
-        Vector3D position(10.0, 20.0, 1.5);
-        NS_LOG_INFO("UE [" << ueNodes.Get(ueIndex) << "] at "
-                           << ueNodes.Get(ueIndex)->GetObject<MobilityModel>()->GetPosition());
-
-        if (ueIndex > 0)
-        {
-            position.x = 50.0 * ueIndex;
-            position.y = 30.0 * ((ueIndex % 2 == 0) ? 1 : -1);
-        }
-        Ptr<MobilityModel> mob = ueNodes.Get(ueIndex)->GetObject<MobilityModel>();
-        mob->SetPosition(position);
-        printf("UE [%zu] position set to (%.2f, %.2f, %.2f)\n",
-               ueIndex,
-               position.x,
-               position.y,
-               position.z);
+        schedulerFactory.SetTypeId("ns3::ProfilingScheduler");
+        schedulerFactory.Set("Inner", TypeIdValue(TypeId::LookupByName(schedulerType)));
+        schedulerFactory.Set("OutputFile", StringValue(profileOutput));
+        schedulerFactory.Set("HwCounters", BooleanValue(hwCounters));
     }
-    printf("hex grid setup completed\n");
-    for (size_t ueIndex = 0; ueIndex < ueNodes.GetN(); ueIndex++)
+    if (slotArena)
     {
-        Ptr<ConstantVelocityMobilityModel> mob =
-            ueNodes.Get(ueIndex)->GetObject<ConstantVelocityMobilityModel>();
-
-        double speed = 1.0 + ueIndex * 3.0; // 1 m/s, 4 m/s, 7 m/s, etc.
-        mob->SetVelocity(Vector(speed, (ueIndex % 2 == 0 ? 1 : -1) * speed, 0)); // zigzag movement
+        ObjectFactory innerFactory = schedulerFactory;
+        schedulerFactory = ObjectFactory("ns3::SlotArenaScheduler");
+        schedulerFactory.Set("Inner", ObjectFactoryValue(innerFactory));
+        schedulerFactory.Set("SlotDuration", TimeValue(MilliSeconds(1) / (1 << numerology)));
     }
-    /*
-     * Setup the NR module:
-     * - NrHelper, which takes care of creating and connecting the various
-     * part of the NR stack
-     * - NrChannelHelper, which takes care of the spectrum channel
-     */
-
-    Config::SetDefault("ns3::NrAmc::ErrorModelType",
-                       TypeIdValue(TypeId::LookupByName(errorModelType)));
-    if (amcSelectionModel == "ErrorModel")
-    {
-        Config::SetDefault("ns3::NrAmc::AmcModel", EnumValue(NrAmc::ErrorModel));
-    }
-    else if (amcSelectionModel == "ShannonModel")
+    if (allocProfile || !allocTimeline.empty())
     {
-        Config::SetDefault("ns3::NrAmc::AmcModel", EnumValue(NrAmc::ShannonModel));
+        // Points of the allocation timeline, recorded without events of their own
+        ObjectFactory innerFactory = schedulerFactory;
+        schedulerFactory = ObjectFactory("ns3::AllocationTimelineScheduler");
+        schedulerFactory.Set("Inner", ObjectFactoryValue(innerFactory));
     }
-    else
+    if (fingerprint)
     {
-        NS_FATAL_ERROR("Invalid amcSelectionModel: " << amcSelectionModel);
+        ObjectFactory innerFactory = schedulerFactory;
+        schedulerFactory = ObjectFactory("ns3::FingerprintingScheduler");
+        schedulerFactory.Set("Inner", ObjectFactoryValue(innerFactory));
     }
-    Config::SetDefault("ns3::NrRlcUm::MaxTxBufferSize", UintegerValue(999999999)); // Good to have
+    Simulator::SetScheduler(schedulerFactory);
 
-    Ptr<NrPointToPointEpcHelper> epcHelper = CreateObject<NrPointToPointEpcHelper>();
-    Ptr<NrHelper> nrHelper = CreateObject<NrHelper>();
-    Ptr<NrChannelHelper> channelHelper = CreateObject<NrChannelHelper>();
-    nrHelper->SetEpcHelper(epcHelper);
-
-    uint8_t numCc = 1; // Number of component carriers
-    CcBwpCreator ccBwpCreator;
-    auto band = ccBwpCreator.CreateOperationBandContiguousCc({centralFrequency, bandwidth, numCc});
-
-    if (channelModel == "ThreeGpp" || channelModel == "NYU" || channelModel == "TwoRay")
+    // Cost of every setup phase, reported before the simulation starts
+    SetupPhaseProfiler startupProfiler;
+    std::unique_ptr<HwPerfCounters> hwPerf;
+    if (hwCounters)
     {
-        // Create the ideal beamforming helper in case of a non-phased array model
-        Ptr<IdealBeamformingHelper> idealBeamformingHelper = CreateObject<IdealBeamformingHelper>();
-        nrHelper->SetBeamformingHelper(idealBeamformingHelper);
-        // First configure the channel helper object factories
-        channelHelper->ConfigureFactories(scenario, channelConditionModel, channelModel);
-        // Enable slow fading (shadowing)
-        channelHelper->SetPathlossAttribute("ShadowingEnabled", BooleanValue(true));
-        // Optional: exaggerate it
-        // channelHelper->SetPathlossAttribute("ShadowSigma", DoubleValue(10.0));
-        // Set channel condition attributes
-        if (channelConditionModel == "Default" || channelConditionModel == "Buildings")
+        hwPerf = std::make_unique<HwPerfCounters>();
+        if (hwPerf->IsAvailable())
         {
-            channelHelper->SetChannelConditionModelAttribute("UpdatePeriod",
-                                                             TimeValue(MilliSeconds(100)));
+            startupProfiler.SetHwCounters(hwPerf.get());
         }
-        // Beamforming method
-        idealBeamformingHelper->SetAttribute("BeamformingMethod",
-                                             TypeIdValue(DirectPathBeamforming::GetTypeId()));
-
-        // Antennas for all the UEs
-        nrHelper->SetUeAntennaAttribute("NumRows", UintegerValue(ueNumRows));
-        nrHelper->SetUeAntennaAttribute("NumColumns", UintegerValue(ueNumCols));
-        nrHelper->SetUeAntennaAttribute("AntennaElement",
-                                        PointerValue(CreateObject<IsotropicAntennaModel>()));
+        else
+        {
+            BINLOG_WARN("Hardware counters unavailable (%s)", hwPerf->GetError());
+            hwPerf.reset();
+        }
+    }
 
-        // Antennas for all the gNbs
-        nrHelper->SetGnbAntennaAttribute("NumRows", UintegerValue(gnbNumRows));
-        nrHelper->SetGnbAntennaAttribute("NumColumns", UintegerValue(gnbNumCols));
-        nrHelper->SetGnbAntennaAttribute("AntennaElement",
-                                         PointerValue(CreateObject<IsotropicAntennaModel>()));
+    // Create the simulated scenario
+    startupProfiler.Begin("scenario");
+    NrGamingScenarioParams params;
+    params.randomStream = randomStream;
+    params.centralFrequency = centralFrequency;
+    params.bandwidth = bandwidth;
+    params.simTime = simTime;
+    params.udpTime = udpTime;
+    params.scenario = scenario;
+    params.channelModel = channelModel;
+    params.channelConditionModel = channelConditionModel;
+    params.numUes = numUes;
+    params.numGnbs = numGnbs;
+    params.numerology = numerology;
+    params.errorModelType = errorModelType;
+    params.amcSelectionModel = amcSelectionModel;
+    params.largeScale = largeScale;
+    params.numRings = numRings;
+    params.uesPerSector = uesPerSector;
+    params.ueNumRows = ueNumRows;
+    params.ueNumCols = ueNumCols;
+    params.gnbNumRows = gnbNumRows;
+    params.gnbNumCols = gnbNumCols;
+    params.radioOnly = radioOnly;
+    params.batchedTraffic = batchedTraffic;
+    params.replayTrace = replayTrace;
+    params.fullBuffer = fullBuffer;
+    params.rlcBufferMs = rlcBufferMs;
+    params.pooledRlc = pooledRlc;
+    params.rlcDropPolicy = rlcDropPolicy;
+    params.crn = crn;
+    if (!mcsAgent.empty())
+    {
+        params.macScheduler = "ns3::NrMacSchedulerTdmaRrExternal";
     }
-    else if (channelModel == "Friis")
+    NrGamingScenario nrScenario(params);
+    numUes = nrScenario.GetParams().numUes;
+    numGnbs = nrScenario.GetParams().numGnbs;
+
+    // Pre-flight estimate of memory and runtime, before anything heavy is built
+    ResourceEstimate estimate = EstimateResources(nrScenario.GetFootprint());
+    printf("Pre-flight estimate: %u RBs, %.0f channel pairs, %.0f MB, %.1f s runtime\n",
+           estimate.resourceBlocks,
+           estimate.channelPairs,
+           estimate.memoryBytes / 1e6,
+           estimate.wallSeconds);
+    if ((memBudgetMb > 0 && estimate.memoryBytes / 1e6 > memBudgetMb) ||
+        (timeBudgetSec > 0 && estimate.wallSeconds > timeBudgetSec))
     {
-        // Override the default antenna model with ParabolicAntennaModel
-        nrHelper->SetUeAntennaTypeId(ParabolicAntennaModel::GetTypeId().GetName());
-        nrHelper->SetGnbAntennaTypeId(ParabolicAntennaModel::GetTypeId().GetName());
-        // Configure Friis propagation loss model before assign it to band
-        channelHelper->ConfigurePropagationFactory(FriisPropagationLossModel::GetTypeId());
+        printf("Run refused: estimate exceeds the budget (memBudgetMb=%.0f, timeBudgetSec=%.0f)\n",
+               memBudgetMb,
+               timeBudgetSec);
+        return 1;
     }
-    else
+    // The scenario phase ends when the channel phase begins
+    nrScenario.Build(
+        [&startupProfiler](const std::string& phase) { startupProfiler.Begin(phase); });
+    NodeContainer ueNodes = nrScenario.GetUeNodes();
+    startupProfiler.Begin("traces");
+    nrScenario.StartApplications();
+    FlowKpiCollector flowKpiCollector(numUes);
+    if (flowKpis)
     {
-        NS_FATAL_ERROR("Invalid channel model: "
-                       << channelModel << ". Choose among 'ThreeGpp', 'NYU', 'TwoRay', 'Friis'.");
+        nrScenario.ConnectFlowTraces(MakeCallback(&FlowKpiCollector::RecordTx, &flowKpiCollector),
+                                     MakeCallback(&FlowKpiCollector::RecordRx, &flowKpiCollector));
     }
-
-    // After configuring the factories, create and assign the spectrum channels to the bands
-    channelHelper->AssignChannelsToBands({band});
-    printf("Spectrum channel created and assigned to the band\n");
-
-    // Get all the BWPs
-    auto allBwps = CcBwpCreator::GetAllBwps({band});
-    // Set the numerology and transmission powers attributes to all the gNBs and UEs
-    nrHelper->SetGnbPhyAttribute("TxPower", DoubleValue(bsTxPower));
-    nrHelper->SetGnbPhyAttribute("Numerology", UintegerValue(numerology));
-    nrHelper->SetUePhyAttribute("TxPower", DoubleValue(ueTxPower));
-    printf("Attributes set for gNBs and UEs\n");
-    // Scheduler: Ensure AMC is active, not fixed MCS
-    nrHelper->SetSchedulerAttribute("FixedMcsDl", BooleanValue(false));
-    nrHelper->SetSchedulerAttribute("FixedMcsUl", BooleanValue(false));
-
-    // Error Model: Apply to UEs and gNBs
-    nrHelper->SetUlErrorModel(errorModelType);
-    nrHelper->SetDlErrorModel(errorModelType);
-
-    // AMC Model: Ensure gNB uses the chosen AMC logic for DL and UL scheduling
-    if (amcSelectionModel == "ErrorModel")
+    // Check pathloss traces. Same files as the NrHelper Enable*Traces() methods, through sinks
+    // that account the records, bytes, formatting and I/O time of every trace family
+    TraceCostAccounting traceCosts;
+    if (enableTraces)
     {
-        nrHelper->SetGnbDlAmcAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
-        nrHelper->SetGnbUlAmcAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
-        // UEs will also use this for CQI reporting by default matching NrAmc global default
+        traceCosts.EnableDlDataPhyTraces();
+        traceCosts.EnableDlMacSchedTraces();
+        traceCosts.EnableGnbMacCtrlMsgsTraces();
+        traceCosts.EnablePathlossTraces();
     }
-    else if (amcSelectionModel == "ShannonModel")
+    RunFingerprint traceFingerprint;
+    DeliveredTrafficCounter deliveredTraffic;
+    if (fingerprint)
     {
-        nrHelper->SetGnbDlAmcAttribute("AmcModel", EnumValue(NrAmc::ShannonModel));
-        nrHelper->SetGnbUlAmcAttribute("AmcModel", EnumValue(NrAmc::ShannonModel));
+        traceCosts.SetFingerprint(&traceFingerprint);
+        if (radioOnly)
+        {
+            nrScenario.ConnectUeRx(deliveredTraffic.MakeSink(ueNodes.GetN()));
+        }
+        else
+        {
+            deliveredTraffic.Install(ueNodes);
+        }
     }
-    // Install and get the pointers to the NetDevices
-    NetDeviceContainer gNbNetDev = nrHelper->InstallGnbDevice(gNbNodes, allBwps);
-    NetDeviceContainer ueNetDev = nrHelper->InstallUeDevice(ueNodes, allBwps);
-
-    randomStream += nrHelper->AssignStreams(gNbNetDev, randomStream);
-    randomStream += nrHelper->AssignStreams(ueNetDev, randomStream);
-    printf("NetDevices installed and streams assigned\n");
-    // create the internet and install the IP stack on the UEs
-    // get SGW/PGW and create a single RemoteHost
-    Ptr<Node> pgw = epcHelper->GetPgwNode();
-    Ptr<Node> remoteHost = CreateObject<Node>();
-    InternetStackHelper internet;
-    internet.Install(remoteHost);
-    printf("Internet stack installed on remote host\n");
-    // connect a remoteHost to pgw. Setup routing too
-    PointToPointHelper p2ph;
-    p2ph.SetDeviceAttribute("DataRate", DataRateValue(DataRate("100Gb/s")));
-    p2ph.SetDeviceAttribute("Mtu", UintegerValue(2500));
-    p2ph.SetChannelAttribute("Delay", TimeValue(Seconds(0.010)));
-    NetDeviceContainer internetDevices = p2ph.Install(pgw, remoteHost);
-
-    Ipv4AddressHelper ipv4h;
-    ipv4h.SetBase("1.0.0.0", "255.0.0.0");
-    Ipv4InterfaceContainer internetIpIfaces = ipv4h.Assign(internetDevices);
-    Ipv4StaticRoutingHelper ipv4RoutingHelper;
+    startupProfiler.End();
 
-    Ptr<Ipv4StaticRouting> remoteHostStaticRouting =
-        ipv4RoutingHelper.GetStaticRouting(remoteHost->GetObject<Ipv4>());
-    remoteHostStaticRouting->AddNetworkRouteTo(Ipv4Address("7.0.0.0"), Ipv4Mask("255.0.0.0"), 1);
-    internet.Install(ueNodes);
-
-    Ipv4InterfaceContainer ueIpIface;
-    ueIpIface = epcHelper->AssignUeIpv4Address(NetDeviceContainer(ueNetDev));
-    printf("IPv4 addresses assigned to UEs\n");
-    // assign IP address to UEs, and install UDP downlink applications
-    uint16_t dlPort = 1234;
-    ApplicationContainer clientApps;
-    ApplicationContainer serverApps;
-    for (size_t i = 0; i < ueNodes.GetN(); i++)
+    startupProfiler.Print();
+    if (!startupProfile.empty())
     {
-        TrafficGeneratorHelper trafficHelper("ns3::UdpSocketFactory", // or "ns3::TcpSocketFactory"
-                                             InetSocketAddress(ueIpIface.GetAddress(i), dlPort),
-                                             TrafficGeneratorNgmnGaming::GetTypeId());
-
-        clientApps.Add(trafficHelper.Install(remoteHost));
+        std::ofstream profileFile(startupProfile);
+        profileFile << "{\"ueNum\": " << numUes << ", \"gNbNum\": " << numGnbs
+                    << ", \"channelModel\": \"" << channelModel << "\", \"phases\": ";
+        startupProfiler.WriteJsonPhases(profileFile);
+        profileFile << "}" << std::endl;
     }
-    // attach UEs to the closest eNB
-    nrHelper->AttachToClosestGnb(ueNetDev, gNbNetDev);
-    // start UDP server and client apps
-    serverApps.Start(udpTime);
-    clientApps.Start(udpTime);
-    serverApps.Stop(simTime);
-    clientApps.Stop(simTime);
-    printf("Gaming applications started\n");
-    // Check pathloss traces
-    nrHelper->EnableDlDataPhyTraces();
-    nrHelper->EnableDlMacSchedTraces();
-    nrHelper->EnableGnbMacCtrlMsgsTraces();
-    nrHelper->EnablePathlossTraces();
 
     Simulator::Stop(simTime);
     RngSeedManager::SetSeed(rngSeed); // Changes the base seed
     RngSeedManager::SetRun(rngRun);   // Changes the run number
 
+    AllocationProfiler allocProfiler;
+    if (allocProfile || !allocTimeline.empty())
+    {
+        allocProfiler.Start(MilliSeconds(10), allocProfile ? allocSamplePeriod : 0);
+    }
+    uint64_t runAllocStart = GetAllocationCount();
+    uint64_t runArenaStart = SlotArena::Get().GetAllocations();
+    RealtimeSlotMonitor realtimeMonitor;
+    if (realtime)
+    {
+        realtimeMonitor.AddDegradation("mute-traces",
+                                       [&traceCosts]() { traceCosts.SetMuted(true); });
+        realtimeMonitor.AddDegradation("abstract-channel",
+                                       [&nrScenario]() { nrScenario.UseAbstractChannel(); });
+        realtimeMonitor.Start(MilliSeconds(1) / (1 << numerology), Seconds(maxLagMs / 1e3), policy);
+    }
+    ExternalMcsControl mcsControl;
+    if (!mcsAgent.empty())
+    {
+        NS_ABORT_MSG_UNLESS(mcsControl.Open(mcsAgent,
+                                            nrScenario.GetUeDevices(),
+                                            Seconds(mcsAgentTimeoutUs / 1e6)),
+                            "Cannot create the MCS agent channel " << mcsAgent);
+        mcsControl.Start(MilliSeconds(1) / (1 << numerology));
+    }
+
     // Measure simulation runtime
+    HwCounterValues runHwStart = hwPerf ? hwPerf->Read() : HwCounterValues();
     auto simStart = std::chrono::high_resolution_clock::now();
     Simulator::Run();
     auto simEnd = std::chrono::high_resolution_clock::now();
+    HwCounterValues runHw = hwPerf ? runHwStart.Until(hwPerf->Read()) : HwCounterValues();
+    uint64_t runAllocations = GetAllocationCount() - runAllocStart;
+    uint64_t runArenaAllocations = SlotArena::Get().GetAllocations() - runArenaStart;
     auto simDuration =
         std::chrono::duration_cast<std::chrono::milliseconds>(simEnd - simStart).count();
 
     std::cout << "\n🕒 Simulation runtime: " << simDuration << " ms (" << simDuration / 1000.0
               << " seconds)" << std::endl;
+    uint64_t eventCount = Simulator::GetEventCount();
+    double eventsPerSec = simDuration > 0 ? eventCount * 1000.0 / simDuration : 0.0;
+    std::cout << "Peak RSS: " << GetPeakRssBytes() / 1e6 << " MB, events executed: " << eventCount
+              << " (" << eventsPerSec << " events/s)" << std::endl;
+    uint32_t handoverCandidates = nrScenario.CountHandoverCandidates();
+    std::cout << "UEs closer to another site than to their serving gNB: " << handoverCandidates
+              << " of " << numUes << std::endl;
+    // Events, trace records and final KPIs, combined into the fingerprint of the run
+    const RunFingerprint& eventFingerprint = FingerprintingScheduler::GetEventFingerprint();
+    RunFingerprint kpiFingerprint;
+    RunFingerprint runFingerprint;
+    if (fingerprint)
+    {
+        kpiFingerprint.Add(eventCount);
+        kpiFingerprint.Add(Simulator::Now().GetTimeStep());
+        deliveredTraffic.AddTo(kpiFingerprint);
+        runFingerprint.Add(eventFingerprint);
+        runFingerprint.Add(traceFingerprint);
+        runFingerprint.Add(kpiFingerprint);
+        printf("Run fingerprint: %s (events %s, traces %s over %lu fields, KPIs %s, %.0f bytes "
+               "delivered)\n",
+               runFingerprint.ToHex().c_str(),
+               eventFingerprint.ToHex().c_str(),
+               traceFingerprint.ToHex().c_str(),
+               static_cast<unsigned long>(traceFingerprint.GetCount()),
+               kpiFingerprint.ToHex().c_str(),
+               static_cast<double>(deliveredTraffic.GetTotalBytes()));
+    }
+    // Events the batched traffic saved against one event per arrival
+    uint64_t trafficArrivals = 0;
+    uint64_t trafficEventsSaved = 0;
+    if (Ptr<BatchedGamingTraffic> batched = nrScenario.GetBatchedTraffic())
+    {
+        trafficArrivals = batched->GetArrivals();
+        trafficEventsSaved = trafficArrivals - batched->GetDeliveryEvents();
+        printf("Batched traffic: %lu arrivals in %lu events (%lu events saved, %.1f%% of the "
+               "run)\n",
+               static_cast<unsigned long>(trafficArrivals),
+               static_cast<unsigned long>(batched->GetDeliveryEvents()),
+               static_cast<unsigned long>(trafficEventsSaved),
+               eventCount > 0 ? 100.0 * trafficEventsSaved / (eventCount + trafficEventsSaved)
+                              : 0.0);
+    }
+    // Slots of simulated time, to compare runs of different lengths and numerologies
+    double simSlots = Simulator::Now().GetSeconds() * 1000.0 * (1 << numerology);
+    if (slotArena)
+    {
+        // Objects still in a chunk 16 slots after its slot ended outlived the HARQ window
+        const SlotArena& arena = SlotArena::Get();
+        SlotArena::Retention retention = arena.GetRetention(16);
+        printf("Slot arena: %lu of %lu allocations (%.1f%%) without malloc, %.0f per slot "
+               "(%lu slot, %lu HARQ), %.1f MB of chunks, %lu chunks (%.1f MB) pinned by %lu "
+               "long-lived blocks\n",
+               static_cast<unsigned long>(runArenaAllocations),
+               static_cast<unsigned long>(runAllocations),
+               runAllocations > 0 ? 100.0 * runArenaAllocations / runAllocations : 0.0,
+               simSlots > 0 ? runArenaAllocations / simSlots : 0.0,
+               static_cast<unsigned long>(arena.GetStats().slotAllocations),
+               static_cast<unsigned long>(arena.GetStats().harqAllocations),
+               arena.GetChunkBytes() / 1e6,
+               static_cast<unsigned long>(retention.chunks),
+               retention.chunks * SlotArena::CHUNK_SIZE / 1e6,
+               static_cast<unsigned long>(retention.blocks));
+    }
+    if (realtime)
+    {
+        realtimeMonitor.Print();
+    }
+    if (!mcsAgent.empty())
+    {
+        mcsControl.Print();
+    }
+    if (runHw.Any())
+    {
+        printf("Hardware counters (Simulator::Run): %.2f IPC", runHw.Ipc());
+        for (int c = 0; c < HwCounterValues::NUM_COUNTERS; ++c)
+        {
+            if (runHw.valid[c] && simSlots > 0)
+            {
+                printf(", %.0f %s/slot", runHw.value[c] / simSlots, HwCounterValues::Name(c));
+            }
+        }
+        printf("\n");
+    }
+    if (enableTraces)
+    {
+        traceCosts.Print();
+    }
+    if (flowKpis)
+    {
+        flowKpiCollector.Print();
+        flowKpiCollector.Write("channels-example-flows.txt");
+    }
+    if (allocProfile || !allocTimeline.empty())
+    {
+        allocProfiler.Stop();
+        allocProfiler.Print(simSlots);
+        if (!allocTimeline.empty())
+        {
+            allocProfiler.WriteTimeline(allocTimeline);
+        }
+    }
+
+    if (!benchJson.empty())
+    {
+        RunRecord params;
+        params.Set("ueNum", numUes);
+        params.Set("gNbNum", numGnbs);
+        params.Set("channelModel", channelModel);
+        params.Set("channelConditionModel", channelConditionModel);
+        params.Set("bandwidth", bandwidth);
+        params.Set("gnbAntenna", std::to_string(gnbNumRows) + "x" + std::to_string(gnbNumCols));
+        params.Set("ueAntenna", std::to_string(ueNumRows) + "x" + std::to_string(ueNumCols));
+        params.Set("enableTraces", enableTraces);
+        params.Set("largeScale", largeScale);
+        params.Set("radioOnly", radioOnly);
+        params.Set("batchedTraffic", batchedTraffic);
+        params.Set("replayTrace", replayTrace);
+        params.Set("fullBuffer", fullBuffer);
+        params.Set("rlcBufferMs", rlcBufferMs);
+        params.Set("pooledRlc", pooledRlc);
+        params.Set("rlcDropPolicy", rlcDropPolicy);
+        params.Set("scheduler", scheduler);
+        params.Set("slotArena", slotArena);
+        params.Set("fingerprint", fingerprint);
+        params.Set("flowKpis", flowKpis);
+        params.Set("realtime", realtime);
+        if (realtime)
+        {
+            params.Set("maxLagMs", maxLagMs);
+            params.Set("realtimePolicy", realtimePolicy);
+        }
+        params.Set("mcsAgent", !mcsAgent.empty());
+        params.Set("simTime", simTime.GetSeconds());
+        params.Set("seed", rngSeed);
+        params.Set("run", rngRun);
+        params.Set("crn", crn);
+
+        RunRecord metrics;
+        metrics.Set("wallMs", simDuration);
+        metrics.Set("simWallRatio",
+                    simDuration > 0 ? Simulator::Now().GetSeconds() * 1000.0 / simDuration : 0.0);
+        metrics.Set("events", eventCount);
+        metrics.Set("wallUsPerSlot", simSlots > 0 ? simDuration * 1000.0 / simSlots : 0.0);
+        metrics.Set("eventsPerSec", eventsPerSec);
+        metrics.Set("peakRssBytes", GetPeakRssBytes());
+        metrics.Set("handoverCandidates", handoverCandidates);
+        metrics.Set("allocations", GetAllocationCount());
+        metrics.Set("allocationsPerSlot", simSlots > 0 ? runAllocations / simSlots : 0.0);
+        metrics.Set("mallocCallsPerSlot",
+                    simSlots > 0 ? (runAllocations - runArenaAllocations) / simSlots : 0.0);
+        if (slotArena)
+        {
+            metrics.Set("arenaAllocations", runArenaAllocations);
+            metrics.Set("arenaChunkBytes", SlotArena::Get().GetChunkBytes());
+            metrics.Set("arenaPinnedBytes",
+                        SlotArena::Get().GetRetention(16).chunks * SlotArena::CHUNK_SIZE);
+        }
+        metrics.Set("traceSinkMs", traceCosts.GetTotalSinkMs());
+        if (batchedTraffic)
+        {
+            metrics.Set("trafficArrivals", trafficArrivals);
+            metrics.Set("trafficEventsSaved", trafficEventsSaved);
+        }
+        if (runHw.Any())
+        {
+            metrics.Set("ipc", runHw.Ipc());
+            for (int c = 0; c < HwCounterValues::NUM_COUNTERS; ++c)
+            {
+                if (runHw.valid[c] && simSlots > 0)
+                {
+                    metrics.Set(std::string(HwCounterValues::Name(c)) + "PerSlot",
+                                runHw.value[c] / simSlots);
+                }
+            }
+        }
+
+        std::ostringstream startup;
+        startupProfiler.WriteJsonPhases(startup);
+
+        RunRecord record;
+        record.Set("params", params);
+        record.Set("metrics", metrics);
+        record.SetRaw("startup", startup.str());
+        record.Set("traces", traceCosts.ToRecord());
+        if (flowKpis)
+        {
+            record.Set("kpis", flowKpiCollector.ToRecord());
+        }
+        if (realtime)
+        {
+            record.Set("realtime", realtimeMonitor.ToRecord());
+        }
+        if (!mcsAgent.empty())
+        {
+            record.Set("mcsAgent", mcsControl.ToRecord());
+        }
+        if (fingerprint)
+        {
+            RunRecord fingerprints;
+            fingerprints.Set("run", runFingerprint.ToHex());
+            fingerprints.Set("events", eventFingerprint.ToHex());
+            fingerprints.Set("traces", traceFingerprint.ToHex());
+            fingerprints.Set("kpis", kpiFingerprint.ToHex());
+            record.Set("fingerprint", fingerprints);
+        }
+        record.Write(benchJson);
+    }
 
     Simulator::Destroy();
-    printf("Simulation completed\n");
+    BINLOG_INFO("Simulation completed");
+    BinaryLog::Get().Close();
 
     return 0;
 }
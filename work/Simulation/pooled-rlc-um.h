@@ -0,0 +1,380 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef POOLED_RLC_UM_H
+#define POOLED_RLC_UM_H
+
+#include "ns3/abort.h"
+#include "ns3/enum.h"
+#include "ns3/event-id.h"
+#include "ns3/nr-gnb-component-carrier-manager.h"
+#include "ns3/nr-gnb-net-device.h"
+#include "ns3/nr-gnb-rrc.h"
+#include "ns3/nr-mac-sap.h"
+#include "ns3/nr-radio-bearer-info.h"
+#include "ns3/nr-rlc-header.h"
+#include "ns3/nr-rlc-tag.h"
+#include "ns3/nr-rlc-um.h"
+#include "ns3/object-factory.h"
+#include "ns3/object-map.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief RLC UM entity whose transmit buffer is a bounded ring of pooled SDU slots.
+ *
+ * The stock NrRlcUm keeps its SDUs in a vector: every transmit opportunity erases the head,
+ * copies it, and inserts back in front what did not fit, so segmenting the head moves the
+ * whole backlog, and the buffer is bounded by its byte cap only. Here the SDUs sit in a ring
+ * of slots that doubles when full and is then reused, so a steady backlog allocates nothing
+ * per SDU. The head SDU is never copied or cut: a segment is a fragment of it at the offset
+ * already sent, so segmenting it is O(1) whatever the backlog. The buffer counts the bytes
+ * still to send, to the byte, against "MaxBytes". When an SDU does not fit, "DropPolicy"
+ * chooses what to drop:
+ *
+ * - TailDrop: the new SDU, as the stock entity does;
+ * - HeadDrop: the oldest SDUs not yet started, until the new one fits (or the new one if even
+ *   that is not enough), which keeps the freshest packets of a real-time flow. An SDU with a
+ *   segment already sent is never dropped, since the peer could not reassemble it.
+ *
+ * Drops go to the TxDrop trace. The PDUs carry the same header, framing and sequence numbers
+ * as those of NrRlcUm, and the receiving side is that of NrRlcUm.
+ *
+ * The RRC of the gNB only creates the RLC types of its EpsBearerToRlcMapping: Install() puts
+ * the entity in place of the NrRlcUm of every data bearer a gNB creates.
+ */
+class PooledRlcUm : public NrRlcUm
+{
+  public:
+    /// What to drop when a new SDU does not fit in the buffer
+    enum DropPolicy
+    {
+        TAIL_DROP, //!< The new SDU
+        HEAD_DROP, //!< The oldest SDUs not yet started
+    };
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::PooledRlcUm")
+                .SetParent<NrRlcUm>()
+                .SetGroupName("Nr")
+                .AddConstructor<PooledRlcUm>()
+                .AddAttribute("MaxBytes",
+                              "Bound of the bytes waiting for transmission.",
+                              UintegerValue(999999999),
+                              MakeUintegerAccessor(&PooledRlcUm::m_maxBytes),
+                              MakeUintegerChecker<uint64_t>(1))
+                .AddAttribute("DropPolicy",
+                              "What to drop when a new SDU does not fit in the buffer.",
+                              EnumValue(TAIL_DROP),
+                              MakeEnumAccessor<DropPolicy>(&PooledRlcUm::m_dropPolicy),
+                              MakeEnumChecker(TAIL_DROP, "TailDrop", HEAD_DROP, "HeadDrop"));
+        return tid;
+    }
+
+    PooledRlcUm()
+        : m_ring(INITIAL_SLOTS)
+    {
+    }
+
+    void DoTransmitPdcpPdu(Ptr<Packet> p) override
+    {
+        uint32_t size = p->GetSize();
+        if (m_dropPolicy == HEAD_DROP)
+        {
+            while (m_bytes + size > m_maxBytes && m_count > (m_ring[m_head].sent > 0 ? 1 : 0))
+            {
+                DropOldestWaiting();
+            }
+        }
+        if (m_bytes + size > m_maxBytes)
+        {
+            m_txDropTrace(p);
+        }
+        else
+        {
+            if (m_count == m_ring.size())
+            {
+                Grow();
+            }
+            m_ring[(m_head + m_count) & (m_ring.size() - 1)] = {p, 0, Simulator::Now()};
+            m_count++;
+            m_bytes += size;
+        }
+        ReportBufferStatus();
+        m_rbsTimer.Cancel();
+    }
+
+    void DoNotifyTxOpportunity(NrMacSapUser::TxOpportunityParameters txOpParams) override
+    {
+        // Two bytes of fixed header, as NrRlcUm
+        if (txOpParams.bytes <= 2 || m_count == 0)
+        {
+            return;
+        }
+        NrRlcHeader header;
+        // As NrRlcUm, the PDU is its first data field with the others appended: the receiver
+        // cuts the SDUs out of it, so the first one keeps the UID of the sender
+        Ptr<Packet> pdu;
+        auto append = [&pdu](Ptr<Packet> field) {
+            if (pdu)
+            {
+                pdu->AddAtEnd(field);
+            }
+            else
+            {
+                pdu = field;
+            }
+        };
+        uint32_t room = txOpParams.bytes - 2;
+        uint32_t field = 1;
+        uint8_t framing = m_ring[m_head].sent == 0 ? NrRlcHeader::FIRST_BYTE
+                                                   : NrRlcHeader::NO_FIRST_BYTE;
+        bool lastByte = false;
+        // Same data fields as NrRlcUm: whole SDUs with a length indicator each while more
+        // follow, then the head cut to the room left; a field above 2047 bytes, beyond the
+        // length indicator, ends the PDU
+        while (m_count > 0)
+        {
+            Sdu& sdu = m_ring[m_head];
+            uint32_t left = sdu.packet->GetSize() - sdu.sent;
+            if (left > room || left > 2047)
+            {
+                uint32_t take = std::min(left, room);
+                append(sdu.packet->CreateFragment(sdu.sent, take));
+                header.PushExtensionBit(NrRlcHeader::DATA_FIELD_FOLLOWS);
+                sdu.sent += take;
+                m_bytes -= take;
+                lastByte = take == left;
+                if (lastByte)
+                {
+                    PopHead();
+                }
+                break;
+            }
+            append(sdu.sent == 0 ? sdu.packet->Copy() : sdu.packet->CreateFragment(sdu.sent, left));
+            m_bytes -= left;
+            if (room - left <= 2 || m_count == 1)
+            {
+                header.PushExtensionBit(NrRlcHeader::DATA_FIELD_FOLLOWS);
+                PopHead();
+                lastByte = true;
+                break;
+            }
+            header.PushExtensionBit(NrRlcHeader::E_LI_FIELDS_FOLLOWS);
+            header.PushLengthIndicator(left);
+            room -= (field % 2 ? 2 : 1) + left;
+            field++;
+            PopHead();
+        }
+        framing |= lastByte ? NrRlcHeader::LAST_BYTE : NrRlcHeader::NO_LAST_BYTE;
+        header.SetFramingInfo(framing);
+        header.SetSequenceNumber(m_sequenceNumber++);
+        pdu->AddHeader(header);
+        NrRlcTag rlcTag(Simulator::Now());
+        pdu->AddByteTag(rlcTag, 1, header.GetSerializedSize());
+        m_txPdu(m_rnti, m_lcid, pdu->GetSize());
+
+        NrMacSapProvider::TransmitPduParameters params;
+        params.pdu = pdu;
+        params.rnti = m_rnti;
+        params.lcid = m_lcid;
+        params.layer = txOpParams.layer;
+        params.harqProcessId = txOpParams.harqId;
+        params.componentCarrierId = txOpParams.componentCarrierId;
+        m_macSapProvider->TransmitPdu(params);
+
+        if (m_count > 0)
+        {
+            m_rbsTimer.Cancel();
+            m_rbsTimer =
+                Simulator::Schedule(MilliSeconds(10), &PooledRlcUm::ReportBufferStatus, this);
+        }
+    }
+
+    /**
+     * @return the bytes waiting for transmission
+     */
+    uint64_t GetBufferedBytes() const
+    {
+        return m_bytes;
+    }
+
+    /**
+     * @brief Use PooledRlcUm for the data bearers of a gNB.
+     *
+     * Every time the RRC of the gNB creates a data bearer, the NrRlcUm it made is replaced
+     * right after the setup, before any packet reaches it: the PDCP of the bearer and the
+     * component carrier manager, which forwards the transmit opportunities of the MAC, are
+     * pointed to the new entity. Bearers of another RLC type are left alone.
+     *
+     * @param gnb the gNB, before its UEs attach
+     * @param factory factory of the entities, with their bound and drop policy
+     */
+    static void Install(Ptr<NrGnbNetDevice> gnb, const ObjectFactory& factory)
+    {
+        bool connected = gnb->GetRrc()->TraceConnectWithoutContext(
+            "DrbCreated",
+            MakeBoundCallback(&PooledRlcUm::DrbCreated, gnb, factory));
+        NS_ABORT_MSG_IF(!connected, "gNB RRC without a DrbCreated trace");
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_rbsTimer.Cancel();
+        m_ring.clear();
+        NrRlcUm::DoDispose();
+    }
+
+  private:
+    /// Sequence number of the RLC UM header
+    using SequenceNumber = decltype(std::declval<NrRlcHeader>().GetSequenceNumber());
+
+    /// Slots of a new ring; a power of two, as every capacity of the ring
+    static constexpr size_t INITIAL_SLOTS = 16;
+
+    /// Slot of the ring
+    struct Sdu
+    {
+        Ptr<Packet> packet; //!< The SDU, left whole until its last byte is sent
+        uint32_t sent;      //!< Bytes sent in earlier PDUs
+        Time arrival;       //!< Arrival in the buffer
+    };
+
+    /// Double the slots, keeping the SDUs in order
+    void Grow()
+    {
+        std::vector<Sdu> ring(m_ring.size() * 2);
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            ring[i] = std::move(m_ring[(m_head + i) & (m_ring.size() - 1)]);
+        }
+        m_ring = std::move(ring);
+        m_head = 0;
+    }
+
+    /// Release the head slot
+    void PopHead()
+    {
+        m_ring[m_head] = Sdu();
+        m_head = (m_head + 1) & (m_ring.size() - 1);
+        m_count--;
+    }
+
+    /// Drop the oldest SDU not yet started: the head, or the next one if the head was started
+    void DropOldestWaiting()
+    {
+        size_t victim = m_head;
+        if (m_ring[m_head].sent > 0)
+        {
+            victim = (m_head + 1) & (m_ring.size() - 1);
+        }
+        Ptr<Packet> dropped = m_ring[victim].packet;
+        if (victim != m_head)
+        {
+            // The started head moves up into the slot of the dropped SDU
+            m_ring[victim] = std::move(m_ring[m_head]);
+        }
+        m_bytes -= dropped->GetSize();
+        PopHead();
+        m_txDropTrace(dropped);
+    }
+
+    /// Report the backlog to the MAC, with the header estimate of NrRlcUm
+    void ReportBufferStatus()
+    {
+        NrMacSapProvider::ReportBufferStatusParameters r;
+        r.rnti = m_rnti;
+        r.lcid = m_lcid;
+        r.txQueueSize = m_count > 0 ? m_bytes + 2 * m_count : 0;
+        r.txQueueHolDelay =
+            m_count > 0 ? (Simulator::Now() - m_ring[m_head].arrival).GetMilliSeconds() : 0;
+        r.retxQueueSize = 0;
+        r.retxQueueHolDelay = 0;
+        r.statusPduSize = 0;
+        m_macSapProvider->ReportBufferStatus(r);
+    }
+
+    /// DrbCreated trace sink of the RRC of a gNB; the RRC finishes the setup first
+    static void DrbCreated(Ptr<NrGnbNetDevice> gnb,
+                           ObjectFactory factory,
+                           uint64_t imsi,
+                           uint16_t cellId,
+                           uint16_t rnti,
+                           uint8_t lcid)
+    {
+        Simulator::ScheduleNow(&PooledRlcUm::Replace, gnb, factory, rnti, lcid);
+    }
+
+    /// Put a new entity in place of the NrRlcUm of a data bearer
+    static void Replace(Ptr<NrGnbNetDevice> gnb,
+                        ObjectFactory factory,
+                        uint16_t rnti,
+                        uint8_t lcid)
+    {
+        ObjectMapValue drbs;
+        gnb->GetRrc()->GetUeManager(rnti)->GetAttribute("DataRadioBearerMap", drbs);
+        for (auto it = drbs.Begin(); it != drbs.End(); ++it)
+        {
+            Ptr<NrDataRadioBearerInfo> drb = DynamicCast<NrDataRadioBearerInfo>(it->second);
+            if (drb->m_logicalChannelIdentity != lcid || !DynamicCast<NrRlcUm>(drb->m_rlc) ||
+                DynamicCast<PooledRlcUm>(drb->m_rlc))
+            {
+                continue;
+            }
+            PointerValue manager;
+            gnb->GetAttribute("NrGnbComponentCarrierManager", manager);
+            Ptr<NrGnbComponentCarrierManager> ccm = manager.Get<NrGnbComponentCarrierManager>();
+
+            Ptr<PooledRlcUm> rlc = factory.Create<PooledRlcUm>();
+            rlc->SetNrMacSapProvider(ccm->GetNrMacSapProvider());
+            rlc->SetRnti(rnti);
+            rlc->SetLcId(lcid);
+            rlc->SetPacketDelayBudgetMs(drb->m_epsBearer.GetPacketDelayBudgetMs());
+            rlc->SetNrRlcSapUser(drb->m_pdcp->GetNrRlcSapUser());
+            drb->m_pdcp->SetNrRlcSapProvider(rlc->GetNrRlcSapProvider());
+            // The MAC keeps its logical channel; the manager forwards it to the new entity
+            NrCcmRrcSapProvider* ccmSap = ccm->GetNrCcmRrcSapProvider();
+            ccmSap->ReleaseDataRadioBearer(rnti, lcid);
+            ccmSap->SetupDataRadioBearer(drb->m_epsBearer,
+                                         drb->m_epsBearerIdentity,
+                                         rnti,
+                                         lcid,
+                                         drb->m_logicalChannelConfig.logicalChannelGroup,
+                                         rlc->GetNrMacSapUser());
+            drb->m_rlc->Dispose();
+            drb->m_rlc = rlc;
+            rlc->Initialize();
+        }
+    }
+
+    std::vector<Sdu> m_ring;            //!< Slots, a power of two
+    size_t m_head{0};                   //!< Slot of the oldest SDU
+    size_t m_count{0};                  //!< SDUs in the ring
+    uint64_t m_bytes{0};                //!< Bytes of the SDUs still to send
+    uint64_t m_maxBytes;                //!< Bound of m_bytes
+    DropPolicy m_dropPolicy;            //!< What to drop when an SDU does not fit
+    SequenceNumber m_sequenceNumber{0}; //!< Sequence number of the next PDU
+    EventId m_rbsTimer;                 //!< Periodic buffer status report while not empty
+};
+
+NS_OBJECT_ENSURE_REGISTERED(PooledRlcUm);
+
+} // namespace ns3
+
+#endif // POOLED_RLC_UM_H
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef PROCESS_STATS_H
+#define PROCESS_STATS_H
+
+#include <cstdint>
+#include <fstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+/**
+ * @brief Peak resident set size of the current process.
+ *
+ * On Linux `ru_maxrss` is reported in KiB.
+ *
+ * @return the high-water mark of the resident set, in bytes
+ */
+inline uint64_t
+GetPeakRssBytes()
+{
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+/**
+ * @brief Current resident set size of the current process.
+ *
+ * Read from the second field of /proc/self/statm; returns 0 where procfs is not available.
+ *
+ * @return the resident set, in bytes
+ */
+inline uint64_t
+GetCurrentRssBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t sizePages = 0;
+    uint64_t residentPages = 0;
+    if (!(statm >> sizePages >> residentPages))
+    {
+        return 0;
+    }
+    return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+} // namespace ns3
+
+#endif // PROCESS_STATS_H
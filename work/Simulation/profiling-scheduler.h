@@ -0,0 +1,422 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef PROFILING_SCHEDULER_H
+#define PROFILING_SCHEDULER_H
+
+#include "binary-log.h"
+#include "hw-perf-counters.h"
+#include "nr-layer-classifier.h"
+
+#include "ns3/boolean.h"
+#include "ns3/event-impl.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/object-factory.h"
+#include "ns3/scheduler.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/type-id.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Scheduler wrapper attributing the wall time of every executed event to its callback.
+ *
+ * Events are forwarded to an inner scheduler, selected with the "Inner" attribute. The
+ * simulator loop calls RemoveNext() right before invoking an event and IsEmpty() right after,
+ * so the time between the two is the cost of the event.
+ *
+ * An event is identified by the dynamic type of its EventImpl only, which is read through
+ * typeid and never by looking into the event. MakeEvent() makes one type per signature of
+ * the scheduled function, so a member event is reported by its class and parameter list,
+ * e.g. "ns3::NrGnbPhy::*(ns3::SfnSf const&)", and methods of one class sharing a signature
+ * are counted together. Cancelled events, which the simulator skips, have a row of their own.
+ *
+ * At Simulator::Destroy() the profile is printed per NR layer and, if "OutputFile" is set,
+ * written as collapsed stacks ("Simulator::Run;MAC;Scheduler;ns3::Class;Method <ns>"), the
+ * input format of flamegraph.pl and speedscope. Event counts go to the same file name with
+ * a ".counts" suffix.
+ *
+ * With "HwCounters", the cycles, instructions, LLC misses and branch misses of every event are
+ * recorded too, and the profile reports IPC and misses per layer. Reading the counters costs a
+ * few system calls per event, which inflates the wall time but not the user-space counts.
+ *
+ * Enable it before the first event is scheduled:
+ * @code
+ * ObjectFactory factory("ns3::ProfilingScheduler");
+ * factory.Set("OutputFile", StringValue("events.folded"));
+ * Simulator::SetScheduler(factory);
+ * @endcode
+ */
+class ProfilingScheduler : public Scheduler
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::ProfilingScheduler")
+                .SetParent<Scheduler>()
+                .SetGroupName("Core")
+                .AddConstructor<ProfilingScheduler>()
+                .AddAttribute("Inner",
+                              "The scheduler holding the events.",
+                              TypeIdValue(MapScheduler::GetTypeId()),
+                              MakeTypeIdAccessor(&ProfilingScheduler::m_innerType),
+                              MakeTypeIdChecker())
+                .AddAttribute("OutputFile",
+                              "Collapsed-stack file of the wall time per event target "
+                              "(empty = print the summary only).",
+                              StringValue(""),
+                              MakeStringAccessor(&ProfilingScheduler::m_outputFile),
+                              MakeStringChecker())
+                .AddAttribute("HwCounters",
+                              "Also record hardware performance counters per event target.",
+                              BooleanValue(false),
+                              MakeBooleanAccessor(&ProfilingScheduler::m_hwEnabled),
+                              MakeBooleanChecker());
+        return tid;
+    }
+
+    void Insert(const Event& ev) override
+    {
+        if (!m_exportScheduled)
+        {
+            // Insert() runs inside the simulator, which is therefore already created
+            m_exportScheduled = true;
+            Simulator::ScheduleDestroy(&ProfilingScheduler::Export,
+                                       Ptr<ProfilingScheduler>(this));
+        }
+        m_inner->Insert(ev);
+    }
+
+    bool IsEmpty() const override
+    {
+        CloseEvent();
+        return m_inner->IsEmpty();
+    }
+
+    Event PeekNext() const override
+    {
+        return m_inner->PeekNext();
+    }
+
+    Event RemoveNext() override
+    {
+        CloseEvent();
+        Event ev = m_inner->RemoveNext();
+        m_current = &Lookup(ev.impl);
+        m_current->count++;
+        if (m_hw)
+        {
+            m_startHw = m_hw->Read();
+        }
+        m_start = std::chrono::steady_clock::now();
+        return ev;
+    }
+
+    void Remove(const Event& ev) override
+    {
+        m_inner->Remove(ev);
+    }
+
+    /**
+     * @brief Print the per-layer profile and write the collapsed-stack files.
+     *
+     * Called automatically at Simulator::Destroy().
+     */
+    void Export()
+    {
+        CloseEvent();
+
+        struct Row
+        {
+            std::string layer;
+            uint64_t count{0};
+            uint64_t ns{0};
+            HwCounterValues hw;
+        };
+
+        // Several event types may share a label, e.g. methods of one class scheduled with
+        // arguments of different types
+        std::map<std::string, Row> rows;
+        for (const auto& [type, stats] : m_stats)
+        {
+            std::string label = EventLabel(type);
+            Row& row = rows[label];
+            // The class of a member event, not the types of its parameters
+            row.layer = ClassifyNrLayer(label.compare(0, 3, "(*)") == 0
+                                            ? label
+                                            : label.substr(0, label.find('(')));
+            row.count += stats.count;
+            row.ns += stats.ns;
+            row.hw += stats.hw;
+        }
+
+        if (!m_outputFile.empty())
+        {
+            std::ofstream times(m_outputFile);
+            std::ofstream counts(m_outputFile + ".counts");
+            std::ofstream hwFiles[HwCounterValues::NUM_COUNTERS];
+            for (int c = 0; m_hw && c < HwCounterValues::NUM_COUNTERS; ++c)
+            {
+                hwFiles[c].open(m_outputFile + "." + HwCounterValues::Name(c));
+            }
+            for (const auto& [label, row] : rows)
+            {
+                std::string stack = "Simulator::Run;" + row.layer + ";" + StackFrames(label);
+                times << stack << " " << row.ns << "\n";
+                counts << stack << " " << row.count << "\n";
+                for (int c = 0; c < HwCounterValues::NUM_COUNTERS; ++c)
+                {
+                    if (row.hw.valid[c])
+                    {
+                        hwFiles[c] << stack << " " << row.hw.value[c] << "\n";
+                    }
+                }
+            }
+        }
+
+        std::map<std::string, Row> layers;
+        uint64_t totalNs = 0;
+        uint64_t totalCount = 0;
+        for (const auto& [label, row] : rows)
+        {
+            std::string top = row.layer.substr(0, row.layer.find(';'));
+            layers[top].count += row.count;
+            layers[top].ns += row.ns;
+            layers[top].hw += row.hw;
+            totalNs += row.ns;
+            totalCount += row.count;
+        }
+
+        printf("Event profile (%lu events, %.1f ms in event handlers):\n",
+               static_cast<unsigned long>(totalCount),
+               totalNs / 1e6);
+        for (const auto& [layer, row] : layers)
+        {
+            printf("  %-14s %12lu events %10.1f ms %5.1f%%",
+                   layer.c_str(),
+                   static_cast<unsigned long>(row.count),
+                   row.ns / 1e6,
+                   totalNs > 0 ? 100.0 * row.ns / totalNs : 0.0);
+            if (row.hw.Any() && row.count > 0)
+            {
+                printf(" %5.2f IPC %9.2f LLC misses/event %9.2f branch misses/event",
+                       row.hw.Ipc(),
+                       static_cast<double>(row.hw.value[HwCounterValues::LLC_MISSES]) / row.count,
+                       static_cast<double>(row.hw.value[HwCounterValues::BRANCH_MISSES]) /
+                           row.count);
+            }
+            printf("\n");
+        }
+
+        std::vector<std::pair<std::string, Row>> top(rows.begin(), rows.end());
+        std::sort(top.begin(), top.end(), [](const auto& a, const auto& b) {
+            return a.second.ns > b.second.ns;
+        });
+        top.resize(std::min<std::size_t>(top.size(), 10));
+        printf("  Most expensive event targets:\n");
+        for (const auto& [label, row] : top)
+        {
+            printf("    %10.1f ms %12lu  %s\n",
+                   row.ns / 1e6,
+                   static_cast<unsigned long>(row.count),
+                   label.c_str());
+        }
+        if (!m_outputFile.empty())
+        {
+            printf("  Collapsed stacks written to %s\n", m_outputFile.c_str());
+        }
+    }
+
+  protected:
+    void NotifyConstructionCompleted() override
+    {
+        ObjectFactory factory;
+        factory.SetTypeId(m_innerType);
+        m_inner = factory.Create<Scheduler>();
+        if (m_hwEnabled)
+        {
+            m_hw = std::make_unique<HwPerfCounters>();
+            if (!m_hw->IsAvailable())
+            {
+                BINLOG_WARN("Hardware counters unavailable (%s)", m_hw->GetError());
+                m_hw.reset();
+            }
+        }
+        Scheduler::NotifyConstructionCompleted();
+    }
+
+    void DoDispose() override
+    {
+        m_inner = nullptr;
+        Scheduler::DoDispose();
+    }
+
+  private:
+    /// Accumulated cost of one event target
+    struct TargetStats
+    {
+        uint64_t count{0};  //!< Executed events
+        uint64_t ns{0};     //!< Wall time in ns
+        HwCounterValues hw; //!< Hardware counters, if enabled
+    };
+
+    /// Type standing for the cancelled events, which the simulator skips
+    struct CancelledEvent
+    {
+    };
+
+    /**
+     * @brief Add the time elapsed since RemoveNext() to the event in progress, if any.
+     */
+    void CloseEvent() const
+    {
+        if (m_current != nullptr)
+        {
+            auto elapsed = std::chrono::steady_clock::now() - m_start;
+            m_current->ns +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            if (m_hw)
+            {
+                m_current->hw += m_startHw.Until(m_hw->Read());
+            }
+            m_current = nullptr;
+        }
+    }
+
+    /**
+     * @brief Find the statistics of the target of an event.
+     * @param impl the event about to be executed
+     * @return the statistics of its type
+     */
+    TargetStats& Lookup(EventImpl* impl)
+    {
+        if (impl->IsCancelled())
+        {
+            return m_stats[&typeid(CancelledEvent)];
+        }
+        return m_stats[&typeid(*impl)];
+    }
+
+    /**
+     * @param name a type name
+     * @param open position of an opening parenthesis in it
+     * @return the parenthesized list starting there, or an empty string
+     */
+    static std::string ParameterList(const std::string& name, std::size_t open)
+    {
+        if (open >= name.size() || name[open] != '(')
+        {
+            return "";
+        }
+        int depth = 0;
+        for (std::size_t i = open; i < name.size(); ++i)
+        {
+            depth += name[i] == '(' ? 1 : name[i] == ')' ? -1 : 0;
+            if (depth == 0)
+            {
+                return name.substr(open, i - open + 1);
+            }
+        }
+        return "";
+    }
+
+    /**
+     * @param type an EventImpl type
+     * @return a readable name of what the events of the type run, such as
+     *         "ns3::NrGnbPhy::*(ns3::SfnSf const&)" for a member function of NrGnbPhy
+     */
+    static std::string EventLabel(const std::type_info* type)
+    {
+        if (type == &typeid(CancelledEvent))
+        {
+            return "(cancelled events)";
+        }
+        // Local classes of MakeEvent(), e.g.
+        // "ns3::MakeEvent<void (ns3::NrGnbPhy::*)(), ...>(...)::EventMemberImpl0"
+        std::string typeName = DemangleSymbol(type->name());
+        std::size_t member = typeName.find("::*)");
+        if (member != std::string::npos)
+        {
+            std::size_t open = typeName.rfind('(', member);
+            return typeName.substr(open + 1, member - open - 1) + "::*" +
+                   ParameterList(typeName, member + 4);
+        }
+        std::size_t function = typeName.find("(*)");
+        if (function != std::string::npos)
+        {
+            return "(*)" + ParameterList(typeName, function + 3);
+        }
+        return CallableName(typeName);
+    }
+
+    /**
+     * @brief Name the code run by a function or a lambda.
+     * @param name a demangled function name, or the type name of a lambda
+     * @return the qualified function name
+     */
+    static std::string CallableName(const std::string& name)
+    {
+        std::string result = ShortFunctionName(name);
+        if (name.find("{lambda") != std::string::npos)
+        {
+            result += "::{lambda}";
+        }
+        return result;
+    }
+
+    /**
+     * @param label a qualified function name
+     * @return its class and function as two collapsed-stack frames
+     */
+    static std::string StackFrames(const std::string& label)
+    {
+        // The parameter list of a member event is part of its last frame
+        std::size_t sep = label.rfind("::", label.find('('));
+        if (label.size() > 10 && label.compare(label.size() - 10, 10, "::{lambda}") == 0)
+        {
+            sep = label.rfind("::", label.size() - 11);
+        }
+        if (sep == std::string::npos || sep == 0)
+        {
+            return label;
+        }
+        return label.substr(0, sep) + ";" + label.substr(sep + 2);
+    }
+
+    TypeId m_innerType;                   //!< Type of the inner scheduler
+    Ptr<Scheduler> m_inner;               //!< Scheduler holding the events
+    std::string m_outputFile;             //!< Collapsed-stack output file
+    bool m_exportScheduled{false};        //!< Whether Export() is scheduled at Simulator::Destroy()
+    bool m_hwEnabled{false};              //!< Whether to record hardware counters
+    std::unique_ptr<HwPerfCounters> m_hw; //!< Hardware counters, if enabled and available
+
+    /// Cost per event type
+    std::unordered_map<const std::type_info*, TargetStats> m_stats;
+    mutable TargetStats* m_current{nullptr};               //!< Event in progress, if any
+    mutable std::chrono::steady_clock::time_point m_start; //!< Start of that event
+    mutable HwCounterValues m_startHw;                     //!< Counters at that start
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ProfilingScheduler);
+
+} // namespace ns3
+
+#endif // PROFILING_SCHEDULER_H
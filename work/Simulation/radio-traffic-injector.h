@@ -0,0 +1,365 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef RADIO_TRAFFIC_INJECTOR_H
+#define RADIO_TRAFFIC_INJECTOR_H
+
+#include "ns3/application.h"
+#include "ns3/double.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/nr-eps-bearer-tag.h"
+#include "ns3/nr-gnb-net-device.h"
+#include "ns3/nr-ue-net-device.h"
+#include "ns3/nr-ue-rrc.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/traced-callback.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace ns3
+{
+
+/**
+ * @brief Packet arrival process of a radio-only traffic source.
+ *
+ * Subclasses draw the initial delay, the inter-arrival times and the sizes of the application
+ * packets; RadioTrafficInjector turns them into packets for one UE. Each packet draws its
+ * size, then the time until the next one; a finite source (a replayed trace) reports with
+ * HasNextPacket() when the initial delay or an inter-arrival time led to no packet.
+ */
+class RadioTrafficSource : public Object
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::RadioTrafficSource").SetParent<Object>().SetGroupName("Applications");
+        return tid;
+    }
+
+    /**
+     * @return the delay of the first packet after the source starts
+     */
+    virtual Time GetInitialDelay() = 0;
+
+    /**
+     * @return the time until the next packet
+     */
+    virtual Time GetNextInterArrival() = 0;
+
+    /**
+     * @return the application payload of the next packet in bytes
+     */
+    virtual uint32_t GetNextPacketSize() = 0;
+
+    /**
+     * @return false if the last initial delay or inter-arrival time drawn led to no packet
+     */
+    virtual bool HasNextPacket() const
+    {
+        return true;
+    }
+
+    /**
+     * @brief Assign fixed random variable streams.
+     * @param stream first stream index to use
+     * @return the number of streams assigned
+     */
+    virtual int64_t AssignStreams(int64_t stream) = 0;
+};
+
+/**
+ * @brief NGMN gaming downlink arrivals, as TrafficGeneratorNgmnGaming draws them.
+ *
+ * Sizes and inter-arrival times follow largest extreme value distributions (NGMN radio access
+ * performance evaluation methodology, gaming model), the first packet is uniform over the
+ * initial window. The defaults are those of TrafficGeneratorNgmnGaming in downlink.
+ */
+class NgmnGamingDlSource : public RadioTrafficSource
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::NgmnGamingDlSource")
+                .SetParent<RadioTrafficSource>()
+                .SetGroupName("Applications")
+                .AddConstructor<NgmnGamingDlSource>()
+                .AddAttribute("aParamPacketSize",
+                              "Location of the packet size distribution in bytes.",
+                              DoubleValue(120),
+                              MakeDoubleAccessor(&NgmnGamingDlSource::m_aPacketSize),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("bParamPacketSize",
+                              "Scale of the packet size distribution in bytes.",
+                              DoubleValue(36),
+                              MakeDoubleAccessor(&NgmnGamingDlSource::m_bPacketSize),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("aParamPacketArrival",
+                              "Location of the inter-arrival time distribution in ms.",
+                              DoubleValue(55),
+                              MakeDoubleAccessor(&NgmnGamingDlSource::m_aArrival),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("bParamPacketArrival",
+                              "Scale of the inter-arrival time distribution in ms.",
+                              DoubleValue(6),
+                              MakeDoubleAccessor(&NgmnGamingDlSource::m_bArrival),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("InitialPacketArrivalMax",
+                              "End of the window of the first packet in ms.",
+                              DoubleValue(40),
+                              MakeDoubleAccessor(&NgmnGamingDlSource::m_initialMax),
+                              MakeDoubleChecker<double>(0));
+        return tid;
+    }
+
+    NgmnGamingDlSource()
+        : m_uniform(CreateObject<UniformRandomVariable>())
+    {
+    }
+
+    Time GetInitialDelay() override
+    {
+        return MilliSeconds(m_uniform->GetValue(0, m_initialMax));
+    }
+
+    Time GetNextInterArrival() override
+    {
+        return MilliSeconds(std::max(0.0, LargestExtremeValue(m_aArrival, m_bArrival)));
+    }
+
+    uint32_t GetNextPacketSize() override
+    {
+        return static_cast<uint32_t>(
+            std::max(1.0, std::ceil(LargestExtremeValue(m_aPacketSize, m_bPacketSize))));
+    }
+
+    int64_t AssignStreams(int64_t stream) override
+    {
+        m_uniform->SetStream(stream);
+        return 1;
+    }
+
+  private:
+    /**
+     * @param a location
+     * @param b scale
+     * @return a draw of the largest extreme value distribution, by inversion
+     */
+    double LargestExtremeValue(double a, double b)
+    {
+        // Open interval, so that neither logarithm diverges
+        double y = m_uniform->GetValue(1e-12, 1.0 - 1e-12);
+        return a - b * std::log(-std::log(y));
+    }
+
+    Ptr<UniformRandomVariable> m_uniform; //!< Source of all the draws
+    double m_aPacketSize{120};            //!< Location of the size distribution, bytes
+    double m_bPacketSize{36};             //!< Scale of the size distribution, bytes
+    double m_aArrival{55};                //!< Location of the inter-arrival distribution, ms
+    double m_bArrival{6};                 //!< Scale of the inter-arrival distribution, ms
+    double m_initialMax{40};              //!< Window of the first packet, ms
+};
+
+/// UDP port of the gaming flows of the scenario
+constexpr uint16_t GAMING_UDP_PORT = 1234;
+
+/**
+ * @brief Build a gaming downlink packet as the PGW hands it to the gNB.
+ * @param payload application bytes
+ * @return a packet with an IPv4 and a UDP header in front of the payload
+ */
+inline Ptr<Packet>
+MakeGamingIpPacket(uint32_t payload)
+{
+    Ptr<Packet> packet = Create<Packet>(payload);
+    UdpHeader udp;
+    udp.SetSourcePort(GAMING_UDP_PORT);
+    udp.SetDestinationPort(GAMING_UDP_PORT);
+    packet->AddHeader(udp);
+    Ipv4Header ip;
+    ip.SetProtocol(UdpL4Protocol::PROT_NUMBER);
+    ip.SetPayloadSize(packet->GetSize());
+    ip.SetTtl(64);
+    packet->AddHeader(ip);
+    return packet;
+}
+
+/**
+ * @param ueDevice a UE device
+ * @return true if the UE is connected to its gNB and can receive data
+ */
+inline bool
+IsUeConnected(const Ptr<NrUeNetDevice>& ueDevice)
+{
+    return ueDevice->GetRrc()->GetState() == NrUeRrc::CONNECTED_NORMALLY;
+}
+
+/**
+ * @brief Hand a downlink IP packet to the gNB of a connected UE, as the EPC does.
+ * @param ueDevice the UE
+ * @param bearerId EPS bearer of the UE carrying the packet
+ * @param packet the packet, with its IP header
+ */
+inline void
+InjectDownlinkPacket(const Ptr<NrUeNetDevice>& ueDevice, uint8_t bearerId, Ptr<Packet> packet)
+{
+    packet->AddPacketTag(NrEpsBearerTag(ueDevice->GetRrc()->GetRnti(), bearerId));
+    ueDevice->GetTargetGnb()->Send(packet, Address(), Ipv4L3Protocol::PROT_NUMBER);
+}
+
+/**
+ * @brief Downlink traffic of one UE, handed straight to the RRC of its gNB.
+ *
+ * Radio-only scenarios have no EPC, remote host or IP stacks: this application, installed
+ * on the UE node, draws the arrivals of a RadioTrafficSource and passes every packet to
+ * NrGnbNetDevice::Send() with the EPS bearer tag of the UE, which is how the EPC delivers
+ * downlink packets to the gNB. Packets carry an IPv4 and a UDP header, so the RLC and MAC
+ * see the same sizes as with the EPC and the UE device accepts them as IPv4. Packets
+ * arriving before the UE is connected are dropped, as the EPC would.
+ */
+class RadioTrafficInjector : public Application
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::RadioTrafficInjector")
+                .SetParent<Application>()
+                .SetGroupName("Applications")
+                .AddConstructor<RadioTrafficInjector>()
+                .AddAttribute("Source",
+                              "Arrival process of the packets.",
+                              PointerValue(),
+                              MakePointerAccessor(&RadioTrafficInjector::m_source),
+                              MakePointerChecker<RadioTrafficSource>())
+                .AddAttribute("BearerId",
+                              "EPS bearer of the UE carrying the packets.",
+                              UintegerValue(1),
+                              MakeUintegerAccessor(&RadioTrafficInjector::m_bearerId),
+                              MakeUintegerChecker<uint8_t>(1, 15))
+                .AddTraceSource("Tx",
+                                "A packet has been handed to the gNB.",
+                                MakeTraceSourceAccessor(&RadioTrafficInjector::m_txTrace),
+                                "ns3::Packet::TracedCallback");
+        return tid;
+    }
+
+    /**
+     * @brief Set the UE the traffic is for.
+     * @param ueDevice the UE device, attached to its gNB before the application starts
+     */
+    void SetUeDevice(Ptr<NrUeNetDevice> ueDevice)
+    {
+        m_ueDevice = ueDevice;
+    }
+
+    /**
+     * @return packets handed to the gNB
+     */
+    uint64_t GetSent() const
+    {
+        return m_sent;
+    }
+
+    /**
+     * @return packets dropped because the UE was not connected
+     */
+    uint64_t GetDropped() const
+    {
+        return m_dropped;
+    }
+
+    /**
+     * @brief Assign fixed random variable streams to the source.
+     * @param stream first stream index to use
+     * @return the number of streams assigned
+     */
+    int64_t AssignStreams(int64_t stream)
+    {
+        return m_source->AssignStreams(stream);
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_event.Cancel();
+        m_source = nullptr;
+        m_ueDevice = nullptr;
+        Application::DoDispose();
+    }
+
+  private:
+    void StartApplication() override
+    {
+        NS_ABORT_MSG_IF(!m_source || !m_ueDevice, "RadioTrafficInjector needs a source and a UE");
+        Time delay = m_source->GetInitialDelay();
+        if (m_source->HasNextPacket())
+        {
+            m_event = Simulator::Schedule(delay, &RadioTrafficInjector::Send, this);
+        }
+    }
+
+    void StopApplication() override
+    {
+        m_event.Cancel();
+    }
+
+    /// Hand one packet to the gNB and schedule the next
+    void Send()
+    {
+        uint32_t payload = m_source->GetNextPacketSize();
+        if (IsUeConnected(m_ueDevice))
+        {
+            Ptr<Packet> packet = MakeGamingIpPacket(payload);
+            m_txTrace(packet);
+            InjectDownlinkPacket(m_ueDevice, m_bearerId, packet);
+            m_sent++;
+        }
+        else
+        {
+            m_dropped++;
+        }
+        Time interArrival = m_source->GetNextInterArrival();
+        if (m_source->HasNextPacket())
+        {
+            m_event = Simulator::Schedule(interArrival, &RadioTrafficInjector::Send, this);
+        }
+    }
+
+    Ptr<RadioTrafficSource> m_source;            //!< Arrival process
+    Ptr<NrUeNetDevice> m_ueDevice;               //!< Destination UE
+    uint8_t m_bearerId{1};                       //!< EPS bearer of the packets
+    EventId m_event;                             //!< Next arrival
+    uint64_t m_sent{0};                          //!< Packets handed to the gNB
+    uint64_t m_dropped{0};                       //!< Packets dropped before connection
+    TracedCallback<Ptr<const Packet>> m_txTrace; //!< Tx trace source
+};
+
+NS_OBJECT_ENSURE_REGISTERED(NgmnGamingDlSource);
+NS_OBJECT_ENSURE_REGISTERED(RadioTrafficInjector);
+
+} // namespace ns3
+
+#endif // RADIO_TRAFFIC_INJECTOR_H
@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef REALTIME_SLOT_MONITOR_H
+#define REALTIME_SLOT_MONITOR_H
+
+#include "binary-log.h"
+#include "run-record.h"
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Slot deadlines of a run under the realtime simulator, and what to do when it lags.
+ *
+ * An event at every slot boundary compares the wall clock with the deadline of the slot (the
+ * wall time at the start of the run plus the simulated time) and reads the CPU time the
+ * simulator thread used since the previous boundary. The realtime simulator sleeps until the
+ * next event is due, so that CPU time over the slot duration is the load of the slot, and its
+ * inverse the headroom: how many times faster than realtime the slot ran.
+ *
+ * When the lag exceeds "maxLag", the monitor either only counts it, stops the simulation, or
+ * degrades it one step at a time (e.g. mute the traces, then switch to an abstract channel),
+ * leaving a hundred slots after each step for the lag to recover; with every step used up,
+ * it stops.
+ */
+class RealtimeSlotMonitor
+{
+  public:
+    /// Reaction to a slot behind its deadline by more than the maximum lag
+    enum Policy
+    {
+        REPORT,  //!< Only count the late slots
+        STOP,    //!< Stop the simulation
+        DEGRADE, //!< Apply the next degradation step, stop when there is none left
+    };
+
+    /**
+     * @brief Parse a policy name.
+     * @param name report, stop or degrade
+     * @param policy the policy, if the name is known
+     * @return whether the name is known
+     */
+    static bool ParsePolicy(const std::string& name, Policy& policy)
+    {
+        static const char* const names[] = {"report", "stop", "degrade"};
+        for (int i = REPORT; i <= DEGRADE; ++i)
+        {
+            if (name == names[i])
+            {
+                policy = static_cast<Policy>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Add a degradation step, applied after those added before it.
+     * @param name short name, reported with the slot it was applied at
+     * @param apply the step
+     */
+    void AddDegradation(const std::string& name, std::function<void()> apply)
+    {
+        m_steps.push_back({name, std::move(apply), 0});
+    }
+
+    /**
+     * @brief Schedule the slot boundary events, from the current simulated time.
+     * @param slot slot duration
+     * @param maxLag lag beyond which the policy applies
+     * @param policy reaction to a late slot
+     */
+    void Start(Time slot, Time maxLag, Policy policy)
+    {
+        m_slot = slot;
+        m_maxLag = maxLag;
+        m_policy = policy;
+        m_event = Simulator::ScheduleNow(&RealtimeSlotMonitor::Anchor, this);
+    }
+
+    /**
+     * @return slots whose deadline was checked
+     */
+    uint64_t GetSlots() const
+    {
+        return m_lagsNs.size();
+    }
+
+    /**
+     * @return slots that started later than the maximum lag
+     */
+    uint64_t GetLateSlots() const
+    {
+        return m_lateSlots;
+    }
+
+    /**
+     * @return whether no slot went beyond the maximum lag
+     */
+    bool IsSustained() const
+    {
+        return m_lateSlots == 0 && !m_lagsNs.empty();
+    }
+
+    /**
+     * @brief Print the lag and load distribution, and the degradation steps applied.
+     */
+    void Print() const
+    {
+        printf("Realtime: %lu slots, %lu late (lag > %.2f ms), lag p50 %.3f p99 %.3f max %.3f "
+               "ms, load p50 %.2f p99 %.2f, headroom %.2fx%s\n",
+               static_cast<unsigned long>(GetSlots()),
+               static_cast<unsigned long>(m_lateSlots),
+               m_maxLag.GetSeconds() * 1e3,
+               Percentile(m_lagsNs, 0.5) / 1e6,
+               Percentile(m_lagsNs, 0.99) / 1e6,
+               Percentile(m_lagsNs, 1.0) / 1e6,
+               Percentile(m_loads, 0.5),
+               Percentile(m_loads, 0.99),
+               GetHeadroom(),
+               IsSustained() ? ", sustained" : "");
+        for (const Step& step : m_steps)
+        {
+            if (step.appliedSlot > 0)
+            {
+                printf("  degraded at slot %lu: %s\n",
+                       static_cast<unsigned long>(step.appliedSlot),
+                       step.name.c_str());
+            }
+        }
+    }
+
+    /**
+     * @return mean slot duration over mean CPU time per slot, > 1 when faster than realtime
+     */
+    double GetHeadroom() const
+    {
+        double load = 0;
+        for (double l : m_loads)
+        {
+            load += l;
+        }
+        return load > 0 ? m_loads.size() / load : 0.0;
+    }
+
+    /**
+     * @return the deadlines, loads and degradations, as a record for the benchmark JSON
+     */
+    RunRecord ToRecord() const
+    {
+        RunRecord record;
+        record.Set("slots", GetSlots());
+        record.Set("lateSlots", m_lateSlots);
+        record.Set("sustained", IsSustained());
+        record.Set("lagP50Ms", Percentile(m_lagsNs, 0.5) / 1e6);
+        record.Set("lagP99Ms", Percentile(m_lagsNs, 0.99) / 1e6);
+        record.Set("lagMaxMs", Percentile(m_lagsNs, 1.0) / 1e6);
+        record.Set("loadP50", Percentile(m_loads, 0.5));
+        record.Set("loadP99", Percentile(m_loads, 0.99));
+        record.Set("headroom", GetHeadroom());
+        RunRecord degradations;
+        for (const Step& step : m_steps)
+        {
+            if (step.appliedSlot > 0)
+            {
+                degradations.Set(step.name, step.appliedSlot);
+            }
+        }
+        record.Set("degradedAtSlot", degradations);
+        return record;
+    }
+
+  private:
+    /// A degradation step
+    struct Step
+    {
+        std::string name;         //!< Short name
+        std::function<void()> fn; //!< The step
+        uint64_t appliedSlot;     //!< Slot it was applied at, 0 if not applied
+    };
+
+    /// Slots to wait after a degradation step before applying the next one
+    static constexpr uint64_t RECOVERY_SLOTS = 100;
+
+    /**
+     * @return CPU time of the calling thread, in ns
+     */
+    static uint64_t ThreadCpuNs()
+    {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /**
+     * @param values samples
+     * @param q quantile, 1 for the maximum
+     * @return the quantile of the samples, 0 if there are none
+     */
+    template <typename T>
+    static double Percentile(std::vector<T> values, double q)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        std::size_t k = std::min(values.size() - 1, static_cast<std::size_t>(q * values.size()));
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return static_cast<double>(values[k]);
+    }
+
+    /// First event of the run: the realtime simulator aligns the wall clock on it
+    void Anchor()
+    {
+        m_wallStart = std::chrono::steady_clock::now() -
+                      std::chrono::nanoseconds(Simulator::Now().GetNanoSeconds());
+        m_cpuLast = ThreadCpuNs();
+        m_event = Simulator::Schedule(m_slot, &RealtimeSlotMonitor::OnSlot, this);
+    }
+
+    /// Slot boundary: record the lag and load of the slot, react to a late one
+    void OnSlot()
+    {
+        auto deadline = m_wallStart + std::chrono::nanoseconds(Simulator::Now().GetNanoSeconds());
+        int64_t lagNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - deadline)
+                            .count();
+        uint64_t cpu = ThreadCpuNs();
+        m_lagsNs.push_back(std::max<int64_t>(lagNs, 0));
+        m_loads.push_back(static_cast<double>(cpu - m_cpuLast) / m_slot.GetNanoSeconds());
+        m_cpuLast = cpu;
+        uint64_t slot = m_lagsNs.size();
+
+        if (lagNs > m_maxLag.GetNanoSeconds())
+        {
+            m_lateSlots++;
+            if (m_policy == STOP)
+            {
+                Stop(slot, lagNs);
+                return;
+            }
+            if (m_policy == DEGRADE &&
+                (m_lastStepSlot == 0 || slot >= m_lastStepSlot + RECOVERY_SLOTS))
+            {
+                auto next = std::find_if(m_steps.begin(), m_steps.end(), [](const Step& step) {
+                    return step.appliedSlot == 0;
+                });
+                if (next == m_steps.end())
+                {
+                    Stop(slot, lagNs);
+                    return;
+                }
+                BINLOG_WARN("Slot %lu late by %.3f ms: %s", slot, lagNs / 1e6, next->name);
+                next->fn();
+                next->appliedSlot = slot;
+                m_lastStepSlot = slot;
+            }
+        }
+        m_event = Simulator::Schedule(m_slot, &RealtimeSlotMonitor::OnSlot, this);
+    }
+
+    /**
+     * @brief Stop the simulation at a late slot.
+     * @param slot the slot
+     * @param lagNs its lag
+     */
+    void Stop(uint64_t slot, int64_t lagNs)
+    {
+        BINLOG_ERROR("Slot %lu late by %.3f ms: stopping", slot, lagNs / 1e6);
+        printf("Realtime: slot %lu late by %.3f ms, simulation stopped at %.3f s\n",
+               static_cast<unsigned long>(slot),
+               lagNs / 1e6,
+               Simulator::Now().GetSeconds());
+        Simulator::Stop();
+    }
+
+    Time m_slot;                                       //!< Slot duration
+    Time m_maxLag;                                     //!< Lag beyond which a slot is late
+    Policy m_policy{REPORT};                           //!< Reaction to a late slot
+    std::chrono::steady_clock::time_point m_wallStart; //!< Wall time of simulated time 0
+    uint64_t m_cpuLast{0};                             //!< Thread CPU time at the last slot
+    std::vector<int64_t> m_lagsNs;                     //!< Lag of every slot
+    std::vector<double> m_loads;                       //!< CPU time over duration, per slot
+    uint64_t m_lateSlots{0};                           //!< Slots beyond the maximum lag
+    uint64_t m_lastStepSlot{0};                        //!< Slot of the last degradation
+    std::vector<Step> m_steps;                         //!< Degradation steps, in order
+    EventId m_event;                                   //!< Next slot boundary
+};
+
+} // namespace ns3
+
+#endif // REALTIME_SLOT_MONITOR_H
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Find the largest number of UEs the NR scenario sustains in realtime.
+
+Run from the ns-3 root folder, like bench_sweep.py. Every probe is a short --realtime=true run
+that stops at the first slot later than --max-lag-ms; a UE count is sustained if no slot was
+late. The UE count doubles until a probe fails, then a binary search narrows the interval
+down to --resolution UEs. The verdict of every probe and the headroom (slot duration over CPU
+time per slot) of the last sustained one are printed and written to --output.
+
+Example:
+    ./realtime_capacity.py --gnb-num 1 --channel-model ThreeGpp --sim-time 2s
+    ./realtime_capacity.py --traces off --max-lag-ms 1 --fullBuffer=true
+"""
+
+import argparse
+import json
+import sys
+
+from bench_sweep import build, parse_bool, run_one
+
+
+def probe(args, ue_num, passthrough):
+    """Run the scenario with ue_num UEs; return (sustained, realtime record)."""
+    params = {
+        "ueNum": ue_num,
+        "gNbNum": args.gnb_num,
+        "channelModel": args.channel_model,
+        "enableTraces": args.traces,
+    }
+    extra = [
+        f"--simTime={args.sim_time}",
+        "--realtime=true",
+        f"--maxLagMs={args.max_lag_ms}",
+        "--realtimePolicy=stop",
+    ] + passthrough
+    record = run_one(args.ns3, params, args.work_dir, extra, args.timeout, "realtime")
+    realtime = record.get("realtime", {})
+    sustained = "error" not in record and bool(realtime.get("sustained"))
+    verdict = "sustained" if sustained else record.get("error", "late")
+    print(
+        f"{ue_num} UEs: {verdict}, headroom {realtime.get('headroom', 0):.2f}x, "
+        f"lag p99 {realtime.get('lagP99Ms', 0):.3f} ms",
+        flush=True,
+    )
+    return sustained, realtime
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--ns3", default="./ns3", help="ns3 driver script (default ./ns3)")
+    parser.add_argument("-o", "--output", default="realtime-capacity.json")
+    parser.add_argument("--work-dir", default="realtime_runs")
+    parser.add_argument("--gnb-num", type=int, default=1)
+    parser.add_argument("--channel-model", default="ThreeGpp")
+    parser.add_argument("--traces", type=parse_bool, default=False, help="on or off")
+    parser.add_argument("--sim-time", default="1s", help="simulated time of every probe")
+    parser.add_argument("--max-lag-ms", type=float, default=5.0)
+    parser.add_argument("--start", type=int, default=4, help="first UE count probed")
+    parser.add_argument("--max-ue", type=int, default=4096, help="largest UE count probed")
+    parser.add_argument("--resolution", type=int, default=1, help="UEs, stop the search below")
+    parser.add_argument("--timeout", type=float, default=None, help="per-probe timeout in s")
+    parser.add_argument("--no-build", action="store_true")
+    # Unknown options are passed to the scenario, e.g. --fullBuffer=true
+    args, passthrough = parser.parse_known_args()
+
+    if not args.no_build:
+        build(args.ns3)
+
+    probes = {}
+    # Double until a probe fails: [good, bad) then holds the capacity
+    good, bad = 0, None
+    ue_num = args.start
+    while ue_num <= args.max_ue:
+        probes[ue_num] = probe(args, ue_num, passthrough)
+        if not probes[ue_num][0]:
+            bad = ue_num
+            break
+        good = ue_num
+        ue_num *= 2
+    if bad is not None:
+        while bad - good > args.resolution:
+            ue_num = (good + bad) // 2
+            probes[ue_num] = probe(args, ue_num, passthrough)
+            if probes[ue_num][0]:
+                good = ue_num
+            else:
+                bad = ue_num
+
+    if good == 0:
+        print(f"Not even {args.start} UEs sustain realtime")
+    else:
+        bound = "" if bad is not None else f" (search capped at {args.max_ue})"
+        print(
+            f"Realtime capacity: {good} UEs{bound}, "
+            f"headroom {probes[good][1].get('headroom', 0):.2f}x"
+        )
+    with open(args.output, "w") as f:
+        json.dump(
+            {
+                "maxUes": good,
+                "capped": bad is None,
+                "probes": [
+                    {"ueNum": n, "sustained": ok, "realtime": rt}
+                    for n, (ok, rt) in sorted(probes.items())
+                ],
+            },
+            f,
+            indent=1,
+        )
+    return 0 if good > 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef RUN_FINGERPRINT_H
+#define RUN_FINGERPRINT_H
+
+#include "ns3/callback.h"
+#include "ns3/config.h"
+#include "ns3/ipv4.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/node-container.h"
+#include "ns3/object-factory.h"
+#include "ns3/packet.h"
+#include "ns3/scheduler.h"
+#include "ns3/type-id.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Rolling 128-bit fingerprint of a sequence of values.
+ *
+ * FNV-1a with the 128-bit prime, applied to mixed 64-bit words instead of bytes to keep it
+ * cheap enough for every event and trace record. It is order-sensitive and not cryptographic: two
+ * runs with the same fingerprint produced the same sequence, bit for bit, with overwhelming
+ * probability.
+ */
+class RunFingerprint
+{
+  public:
+    /**
+     * @brief Add a value to the fingerprint.
+     * @param value an integer, floating point or enum value, hashed by its bit pattern
+     */
+    template <typename T>
+    void Add(T value)
+    {
+        static_assert((std::is_arithmetic_v<T> || std::is_enum_v<T>) && sizeof(T) <= 8,
+                      "hash fields one by one");
+        uint64_t word = 0;
+        std::memcpy(&word, &value, sizeof(T));
+        AddWord(word);
+    }
+
+    /**
+     * @brief Add a string to the fingerprint.
+     * @param s the string
+     */
+    void Add(const std::string& s)
+    {
+        AddWord(s.size());
+        for (std::size_t i = 0; i < s.size(); i += 8)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, s.data() + i, std::min<std::size_t>(8, s.size() - i));
+            AddWord(word);
+        }
+    }
+
+    /**
+     * @brief Add a 64-bit word to the fingerprint.
+     * @param word the word
+     */
+    void AddWord(uint64_t word)
+    {
+        // Spread every input bit over the word first (splitmix64 finalizer), since one
+        // multiplication by the FNV prime mostly moves low bits upwards
+        word ^= word >> 30;
+        word *= 0xbf58476d1ce4e5b9ULL;
+        word ^= word >> 27;
+        word *= 0x94d049bb133111ebULL;
+        word ^= word >> 31;
+        // 2^88 + 2^8 + 0x3b
+        static const unsigned __int128 prime =
+            (static_cast<unsigned __int128>(1) << 88) + (1 << 8) + 0x3b;
+        m_hash = (m_hash ^ word) * prime;
+        m_count++;
+    }
+
+    /**
+     * @brief Add another fingerprint, e.g. to combine the fingerprints of several sequences.
+     * @param other the fingerprint to add
+     */
+    void Add(const RunFingerprint& other)
+    {
+        AddWord(static_cast<uint64_t>(other.m_hash >> 64));
+        AddWord(static_cast<uint64_t>(other.m_hash));
+    }
+
+    /**
+     * @return the number of words added
+     */
+    uint64_t GetCount() const
+    {
+        return m_count;
+    }
+
+    /**
+     * @return the fingerprint as 32 hexadecimal digits
+     */
+    std::string ToHex() const
+    {
+        char buf[33];
+        snprintf(buf,
+                 sizeof(buf),
+                 "%016llx%016llx",
+                 static_cast<unsigned long long>(m_hash >> 64),
+                 static_cast<unsigned long long>(m_hash));
+        return buf;
+    }
+
+  private:
+    /// FNV-1a 128-bit offset basis
+    unsigned __int128 m_hash{(static_cast<unsigned __int128>(0x6c62272e07bb0142ULL) << 64) |
+                             0x62b821756295c58dULL};
+    uint64_t m_count{0}; //!< Words added
+};
+
+/**
+ * @brief Scheduler wrapper adding the key of every executed event to a fingerprint.
+ *
+ * The key is the timestamp, the unique id (which reflects the order the events were scheduled
+ * in) and the context of the event, so any change in the order or timing of the events
+ * changes the fingerprint. The inner scheduler is built with the "Inner" factory, which may
+ * itself be another wrapper such as ProfilingScheduler.
+ */
+class FingerprintingScheduler : public Scheduler
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::FingerprintingScheduler")
+                .SetParent<Scheduler>()
+                .SetGroupName("Core")
+                .AddConstructor<FingerprintingScheduler>()
+                .AddAttribute("Inner",
+                              "Factory of the scheduler holding the events.",
+                              ObjectFactoryValue(ObjectFactory("ns3::MapScheduler")),
+                              MakeObjectFactoryAccessor(&FingerprintingScheduler::m_innerFactory),
+                              MakeObjectFactoryChecker());
+        return tid;
+    }
+
+    /**
+     * @return the fingerprint of the events executed so far in this process
+     */
+    static RunFingerprint& GetEventFingerprint()
+    {
+        static RunFingerprint fingerprint;
+        return fingerprint;
+    }
+
+    void Insert(const Event& ev) override
+    {
+        m_inner->Insert(ev);
+    }
+
+    bool IsEmpty() const override
+    {
+        return m_inner->IsEmpty();
+    }
+
+    Event PeekNext() const override
+    {
+        return m_inner->PeekNext();
+    }
+
+    Event RemoveNext() override
+    {
+        Event ev = m_inner->RemoveNext();
+        RunFingerprint& fingerprint = GetEventFingerprint();
+        fingerprint.AddWord(ev.key.m_ts);
+        fingerprint.AddWord((static_cast<uint64_t>(ev.key.m_context) << 32) | ev.key.m_uid);
+        return ev;
+    }
+
+    void Remove(const Event& ev) override
+    {
+        m_inner->Remove(ev);
+    }
+
+  protected:
+    void NotifyConstructionCompleted() override
+    {
+        m_inner = m_innerFactory.Create<Scheduler>();
+        Scheduler::NotifyConstructionCompleted();
+    }
+
+    void DoDispose() override
+    {
+        m_inner = nullptr;
+        Scheduler::DoDispose();
+    }
+
+  private:
+    ObjectFactory m_innerFactory; //!< Factory of the inner scheduler
+    Ptr<Scheduler> m_inner;       //!< Scheduler holding the events
+};
+
+NS_OBJECT_ENSURE_REGISTERED(FingerprintingScheduler);
+
+/**
+ * @brief Packets and bytes delivered to the IP layer of every UE, the final KPI of a run.
+ *
+ * The counts include the IP header, whether they come from the IPv4 stack or, in radio-only
+ * scenarios, from the packets the devices deliver (see MakeSink()), so both modes give the
+ * same figures for the same traffic.
+ */
+class DeliveredTrafficCounter
+{
+  public:
+    /**
+     * @brief Count the packets received by the IPv4 stack of some nodes.
+     * @param nodes the nodes, with the internet stack installed; must outlive the run
+     */
+    void Install(const NodeContainer& nodes)
+    {
+        m_counts.resize(nodes.GetN());
+        for (uint32_t i = 0; i < nodes.GetN(); ++i)
+        {
+            Config::ConnectWithoutContext("/NodeList/" + std::to_string(nodes.Get(i)->GetId()) +
+                                              "/$ns3::Ipv4L3Protocol/Rx",
+                                          MakeBoundCallback(&DeliveredTrafficCounter::Rx,
+                                                            &m_counts[i]));
+        }
+    }
+
+    /**
+     * @brief Count packets reported through a callback, for nodes without an IP stack.
+     * @param numNodes number of nodes, indexed from 0
+     * @return the callback to call with the node index and every packet it receives; the
+     *         counter must outlive the run
+     */
+    Callback<void, uint32_t, Ptr<const Packet>> MakeSink(uint32_t numNodes)
+    {
+        m_counts.resize(numNodes);
+        return MakeCallback(&DeliveredTrafficCounter::Deliver, this);
+    }
+
+    /**
+     * @brief Add the packets and bytes of every node, in installation order, to a fingerprint.
+     * @param fingerprint the fingerprint
+     */
+    void AddTo(RunFingerprint& fingerprint) const
+    {
+        for (const Count& count : m_counts)
+        {
+            fingerprint.Add(count.packets);
+            fingerprint.Add(count.bytes);
+        }
+    }
+
+    /**
+     * @return the bytes received by all the nodes
+     */
+    uint64_t GetTotalBytes() const
+    {
+        uint64_t total = 0;
+        for (const Count& count : m_counts)
+        {
+            total += count.bytes;
+        }
+        return total;
+    }
+
+  private:
+    /// Traffic received by one node
+    struct Count
+    {
+        uint64_t packets{0}; //!< Packets received
+        uint64_t bytes{0};   //!< Bytes received
+    };
+
+    /// Ipv4L3Protocol Rx sink
+    static void Rx(Count* count, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+    {
+        count->packets++;
+        count->bytes += packet->GetSize();
+    }
+
+    /// MakeSink() callback
+    void Deliver(uint32_t node, Ptr<const Packet> packet)
+    {
+        m_counts[node].packets++;
+        m_counts[node].bytes += packet->GetSize();
+    }
+
+    std::vector<Count> m_counts; //!< Per node, in installation order
+};
+
+} // namespace ns3
+
+#endif // RUN_FINGERPRINT_H
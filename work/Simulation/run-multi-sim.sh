@@ -25,7 +25,7 @@ for (( SEED=$START_SEED; SEED<$END_SEED; SEED++ )); do
     echo ">>> Running SEED=$SEED, RUN=$RUN"
 
     # Run simulation
-    $NS3_BIN run "scratch/opt-gsoc-nr-channel-models-error \
+    $NS3_BIN run "scratch/nr-gaming/opt-gsoc-nr-channel-models-error \
       --channelModel=$CHANNEL_MODEL \
       --channelConditionModel=$CHANNEL_CONDITION \
       --seed=$SEED \
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef RUN_RECORD_H
+#define RUN_RECORD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Flat JSON object describing one run, written at the end of the simulation.
+ *
+ * Keys keep their insertion order. The benchmark tools (bench_sweep.py, bench_compare.py)
+ * read the "params" and "metrics" objects of this record.
+ */
+class RunRecord
+{
+  public:
+    /**
+     * @brief Set a numeric field.
+     * @param key field name
+     * @param value field value
+     */
+    template <typename T>
+    void Set(const std::string& key, T value)
+    {
+        std::ostringstream os;
+        os.precision(12);
+        os << value;
+        SetRaw(key, os.str());
+    }
+
+    /**
+     * @brief Set a string field.
+     * @param key field name
+     * @param value field value, escaped on output
+     */
+    void Set(const std::string& key, const std::string& value)
+    {
+        SetRaw(key, Quote(value));
+    }
+
+    /**
+     * @brief Set a string field.
+     * @param key field name
+     * @param value field value, escaped on output
+     */
+    void Set(const std::string& key, const char* value)
+    {
+        Set(key, std::string(value));
+    }
+
+    /**
+     * @brief Set a boolean field.
+     * @param key field name
+     * @param value field value
+     */
+    void Set(const std::string& key, bool value)
+    {
+        SetRaw(key, value ? "true" : "false");
+    }
+
+    /**
+     * @brief Set a nested record.
+     * @param key field name
+     * @param value the nested record
+     */
+    void Set(const std::string& key, const RunRecord& value)
+    {
+        SetRaw(key, value.ToJson());
+    }
+
+    /**
+     * @brief Set a field to an already serialized JSON value.
+     * @param key field name
+     * @param json the JSON text of the value
+     */
+    void SetRaw(const std::string& key, const std::string& json)
+    {
+        for (auto& field : m_fields)
+        {
+            if (field.first == key)
+            {
+                field.second = json;
+                return;
+            }
+        }
+        m_fields.emplace_back(key, json);
+    }
+
+    /**
+     * @return the record as a JSON object
+     */
+    std::string ToJson() const
+    {
+        std::string json = "{";
+        for (std::size_t i = 0; i < m_fields.size(); ++i)
+        {
+            json += (i ? ", " : "") + Quote(m_fields[i].first) + ": " + m_fields[i].second;
+        }
+        return json + "}";
+    }
+
+    /**
+     * @brief Write the record to a file.
+     * @param path the file name
+     * @return true on success
+     */
+    bool Write(const std::string& path) const
+    {
+        std::ofstream out(path);
+        out << ToJson() << std::endl;
+        return out.good();
+    }
+
+    /**
+     * @param s a string
+     * @return s as a quoted JSON string
+     */
+    static std::string Quote(const std::string& s)
+    {
+        std::string quoted = "\"";
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+                quoted += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                quoted += buf;
+            }
+            else
+            {
+                quoted += c;
+            }
+        }
+        return quoted + "\"";
+    }
+
+  private:
+    std::vector<std::pair<std::string, std::string>> m_fields; //!< Keys and JSON values
+};
+
+} // namespace ns3
+
+#endif // RUN_RECORD_H
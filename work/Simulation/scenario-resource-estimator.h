@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef SCENARIO_RESOURCE_ESTIMATOR_H
+#define SCENARIO_RESOURCE_ESTIMATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace ns3
+{
+
+/**
+ * @brief Size of a scenario as seen by the pre-flight estimator.
+ */
+struct ScenarioFootprint
+{
+    uint32_t sites{1};               //!< Number of gNB sites
+    uint32_t sectors{1};             //!< Number of sectors (cells) over all sites
+    uint32_t ues{1};                 //!< Number of UEs
+    double bandwidth{100e6};         //!< Channel bandwidth in Hz
+    uint16_t numerology{1};          //!< NR numerology
+    uint32_t gnbAntennaElements{32}; //!< Elements of the gNB array (rows x columns)
+    uint32_t ueAntennaElements{1};   //!< Elements of the UE array (rows x columns)
+    bool spatialChannel{true};       //!< True for the ThreeGpp/NYU/TwoRay (phased array) models
+    double simTimeSeconds{10.0};     //!< Simulated time in seconds
+    uint64_t rlcTxBufferBytes{0};    //!< Bound of every RLC transmit buffer (0: unbounded)
+};
+
+/**
+ * @brief Coefficients of the pre-flight cost model.
+ *
+ * The defaults are deliberately conservative figures for a Release build on a recent x86
+ * desktop; recalibrate them from the measured peak RSS and runtime that the scenario prints
+ * at the end of every run.
+ */
+struct ResourceCostCoefficients
+{
+    double baseMemoryBytes{96e6};           //!< ns-3/NR static footprint
+    double perUeBytes{256e3};               //!< Node, NR/IP stacks, RLC/PDCP entities, apps
+    double perSectorBytes{6e6};             //!< gNB PHY/MAC/scheduler, per-BWP state
+    double channelPairBytes{16e3};          //!< Per node pair: 3GPP cluster/ray parameters
+    double channelPairBytesPerElement{320}; //!< Per node pair and element pair: H matrix
+    double slotCostSeconds{15e-6};          //!< Per sector and slot: PHY/MAC/scheduler
+    double linkCostSecondsPerRb{4e-9};      //!< Per tx/rx pair, RB and slot: spectrum fan-out
+    double spatialCostPerElement{0.05};     //!< Extra link cost per element pair (beamforming)
+};
+
+/**
+ * @brief Peak bytes one carrier can deliver to a single UE in one slot.
+ *
+ * All the RBs of the bandwidth at the highest spectral efficiency of the default MCS table
+ * (64-QAM, 5.55 bit per resource element), over the 12 of the 14 symbols of a slot left by
+ * the control and DM-RS symbols, single layer.
+ *
+ * @param bandwidth channel bandwidth in Hz
+ * @param numerology NR numerology
+ * @return the bytes
+ */
+inline double
+PeakBytesPerSlot(double bandwidth, uint16_t numerology)
+{
+    const double scs = 15e3 * std::pow(2.0, numerology);
+    const double resourceBlocks = std::floor(bandwidth / (12 * scs));
+    return resourceBlocks * 12 * 12 * 5.55 / 8;
+}
+
+/**
+ * @brief Size of the RLC transmit buffers holding a given time at the peak rate.
+ * @param bandwidth channel bandwidth in Hz
+ * @param numerology NR numerology
+ * @param budgetMs milliseconds of traffic at the peak rate of the carrier
+ * @return the bytes, at least one slot at the peak rate
+ */
+inline uint64_t
+RlcTxBufferBytes(double bandwidth, uint16_t numerology, double budgetMs)
+{
+    const double slots = std::max(1.0, budgetMs * std::pow(2.0, numerology));
+    return static_cast<uint64_t>(std::ceil(slots * PeakBytesPerSlot(bandwidth, numerology)));
+}
+
+/**
+ * @brief Result of the pre-flight estimation.
+ */
+struct ResourceEstimate
+{
+    uint32_t resourceBlocks{0}; //!< RBs in the configured bandwidth
+    double channelPairs{0};     //!< Node pairs holding channel state
+    double memoryBytes{0};      //!< Predicted peak resident memory
+    double wallSeconds{0};      //!< Predicted wall-clock duration of Simulator::Run()
+};
+
+/**
+ * @brief Predict memory and runtime of a scenario before building it.
+ *
+ * Memory is dominated, for spatial channel models, by the channel matrices cached for every
+ * pair of nodes sharing the spectrum channel; the estimate conservatively counts all pairs.
+ * Runtime is dominated by the per-slot fan-out of every transmission to all receivers of the
+ * channel, which scales with the number of resource blocks and, for phased arrays, with the
+ * number of antenna element pairs.
+ *
+ * @param fp the scenario footprint
+ * @param c the cost model coefficients
+ * @return the estimate
+ */
+inline ResourceEstimate
+EstimateResources(const ScenarioFootprint& fp,
+                  const ResourceCostCoefficients& c = ResourceCostCoefficients())
+{
+    ResourceEstimate est;
+
+    const double scs = 15e3 * std::pow(2.0, fp.numerology);
+    est.resourceBlocks = static_cast<uint32_t>(fp.bandwidth / (12 * scs));
+
+    const double nodes = static_cast<double>(fp.ues) + fp.sectors;
+    const double elementPairs =
+        static_cast<double>(fp.gnbAntennaElements) * static_cast<double>(fp.ueAntennaElements);
+
+    est.memoryBytes = c.baseMemoryBytes + fp.ues * c.perUeBytes + fp.sectors * c.perSectorBytes;
+    // Bounded RLC buffers: worst case of a full buffer at both ends of every UE bearer
+    est.memoryBytes += 2.0 * fp.ues * fp.rlcTxBufferBytes;
+    if (fp.spatialChannel)
+    {
+        est.channelPairs = nodes * (nodes - 1) / 2;
+        est.memoryBytes +=
+            est.channelPairs * (c.channelPairBytes + elementPairs * c.channelPairBytesPerElement);
+    }
+
+    // Every sector transmits every slot (data or control) and every receiver on the channel
+    // processes the signal; the UL adds a comparable load from the scheduled UEs.
+    const double slots = fp.simTimeSeconds * 1000.0 * std::pow(2.0, fp.numerology);
+    const double linksPerSlot = 2.0 * fp.sectors * nodes;
+    double linkCost = c.linkCostSecondsPerRb * est.resourceBlocks;
+    if (fp.spatialChannel)
+    {
+        linkCost *= 1.0 + c.spatialCostPerElement * elementPairs;
+    }
+    est.wallSeconds = slots * (fp.sectors * c.slotCostSeconds + linksPerSlot * linkCost);
+
+    return est;
+}
+
+} // namespace ns3
+
+#endif // SCENARIO_RESOURCE_ESTIMATOR_H
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef SETUP_PHASE_PROFILER_H
+#define SETUP_PHASE_PROFILER_H
+
+#include "alloc-tracker.h"
+#include "hw-perf-counters.h"
+#include "process-stats.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Cost of one setup phase.
+ */
+struct SetupPhaseRecord
+{
+    std::string name;        //!< Phase name
+    double wallMs{0};        //!< Wall-clock duration in ms
+    uint64_t allocations{0}; //!< operator new calls during the phase
+    uint64_t allocBytes{0};  //!< Bytes requested from operator new during the phase
+    int64_t rssDelta{0};     //!< Change of the resident set in bytes
+    HwCounterValues hw;      //!< Hardware counters, if enabled
+};
+
+/**
+ * @brief Records wall time, allocations and RSS growth of consecutive setup phases.
+ *
+ * Begin() closes the phase in progress, if any, and opens a new one; End() closes the last.
+ * Hardware counters are recorded too once SetHwCounters() is called.
+ */
+class SetupPhaseProfiler
+{
+  public:
+    /**
+     * @brief Record hardware counters for the next phases.
+     * @param counters the counters, which must outlive the profiler; nullptr to stop
+     */
+    void SetHwCounters(const HwPerfCounters* counters)
+    {
+        m_hw = counters;
+    }
+
+    /**
+     * @brief Start a phase, closing the previous one.
+     * @param name phase name, used as key in the profile
+     */
+    void Begin(const std::string& name)
+    {
+        End();
+        m_open = true;
+        m_current = SetupPhaseRecord();
+        m_current.name = name;
+        m_startAllocations = GetAllocationCount();
+        m_startAllocBytes = GetAllocatedBytes();
+        m_startRss = GetCurrentRssBytes();
+        m_startHw = m_hw ? m_hw->Read() : HwCounterValues();
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * @brief Close the phase in progress, if any.
+     */
+    void End()
+    {
+        if (!m_open)
+        {
+            return;
+        }
+        auto end = std::chrono::steady_clock::now();
+        if (m_hw)
+        {
+            m_current.hw = m_startHw.Until(m_hw->Read());
+        }
+        m_current.wallMs = std::chrono::duration<double, std::milli>(end - m_start).count();
+        m_current.allocations = GetAllocationCount() - m_startAllocations;
+        m_current.allocBytes = GetAllocatedBytes() - m_startAllocBytes;
+        m_current.rssDelta = static_cast<int64_t>(GetCurrentRssBytes()) - m_startRss;
+        m_phases.push_back(m_current);
+        m_open = false;
+    }
+
+    /**
+     * @return the closed phases, in order
+     */
+    const std::vector<SetupPhaseRecord>& GetPhases() const
+    {
+        return m_phases;
+    }
+
+    /**
+     * @brief Print one line per phase and the total.
+     */
+    void Print() const
+    {
+        double totalMs = 0;
+        printf("Startup profile:\n");
+        for (const auto& phase : m_phases)
+        {
+            printf("  %-14s %10.1f ms %12lu allocs %10.1f MB alloc'd %+9.1f MB RSS",
+                   phase.name.c_str(),
+                   phase.wallMs,
+                   static_cast<unsigned long>(phase.allocations),
+                   phase.allocBytes / 1e6,
+                   phase.rssDelta / 1e6);
+            if (phase.hw.Any())
+            {
+                printf(" %5.2f IPC %10.3f M LLC misses",
+                       phase.hw.Ipc(),
+                       phase.hw.value[HwCounterValues::LLC_MISSES] / 1e6);
+            }
+            printf("\n");
+            totalMs += phase.wallMs;
+        }
+        printf("  %-14s %10.1f ms\n", "total", totalMs);
+    }
+
+    /**
+     * @brief Write the phases as a JSON array of objects.
+     * @param os the output stream
+     */
+    void WriteJsonPhases(std::ostream& os) const
+    {
+        os << "[";
+        for (std::size_t i = 0; i < m_phases.size(); ++i)
+        {
+            const auto& phase = m_phases[i];
+            os << (i ? ", " : "") << "{\"name\": \"" << phase.name
+               << "\", \"wallMs\": " << phase.wallMs << ", \"allocations\": " << phase.allocations
+               << ", \"allocBytes\": " << phase.allocBytes << ", \"rssDelta\": " << phase.rssDelta;
+            for (int c = 0; c < HwCounterValues::NUM_COUNTERS; ++c)
+            {
+                if (phase.hw.valid[c])
+                {
+                    os << ", \"" << HwCounterValues::Name(c) << "\": " << phase.hw.value[c];
+                }
+            }
+            os << "}";
+        }
+        os << "]";
+    }
+
+  private:
+    std::vector<SetupPhaseRecord> m_phases;        //!< Closed phases
+    SetupPhaseRecord m_current;                    //!< Phase in progress
+    bool m_open{false};                            //!< Whether a phase is in progress
+    std::chrono::steady_clock::time_point m_start; //!< Start of the phase in progress
+    uint64_t m_startAllocations{0};                //!< Allocation count at its start
+    uint64_t m_startAllocBytes{0};                 //!< Allocated bytes at its start
+    int64_t m_startRss{0};                         //!< RSS at its start
+    const HwPerfCounters* m_hw{nullptr};           //!< Hardware counters, if enabled
+    HwCounterValues m_startHw;                     //!< Their values at its start
+};
+
+} // namespace ns3
+
+#endif // SETUP_PHASE_PROFILER_H
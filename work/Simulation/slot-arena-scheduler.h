@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef SLOT_ARENA_SCHEDULER_H
+#define SLOT_ARENA_SCHEDULER_H
+
+#include "nr-layer-classifier.h"
+#include "slot-arena.h"
+
+#include "ns3/event-impl.h"
+#include "ns3/nstime.h"
+#include "ns3/object-factory.h"
+#include "ns3/scheduler.h"
+#include "ns3/type-id.h"
+
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace ns3
+{
+
+/**
+ * @brief Scheduler wrapper routing the allocations of the PHY and MAC events to the SlotArena.
+ *
+ * Every event is classified once per EventImpl type with ClassifyNrLayer(): while a PHY or
+ * channel event runs, the allocations of the simulator thread go to the slot tier of the
+ * arena, while a MAC event runs to its HARQ tier, and otherwise to malloc(). The NR code is
+ * unchanged: the replaced operator new of alloc-tracker.h follows the tier. Crossing a slot
+ * boundary ("SlotDuration") ends the slot of the arena, without scheduling any event, so the
+ * event sequence of a run is unchanged.
+ *
+ * Insertions into the inner scheduler are never routed, since its nodes live as long as the
+ * events they hold.
+ */
+class SlotArenaScheduler : public Scheduler
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::SlotArenaScheduler")
+                .SetParent<Scheduler>()
+                .SetGroupName("Core")
+                .AddConstructor<SlotArenaScheduler>()
+                .AddAttribute("Inner",
+                              "Factory of the scheduler holding the events.",
+                              ObjectFactoryValue(ObjectFactory("ns3::MapScheduler")),
+                              MakeObjectFactoryAccessor(&SlotArenaScheduler::m_innerFactory),
+                              MakeObjectFactoryChecker())
+                .AddAttribute("SlotDuration",
+                              "The arena ends a slot whenever the events cross this boundary.",
+                              TimeValue(MilliSeconds(0.5)),
+                              MakeTimeAccessor(&SlotArenaScheduler::m_slotDuration),
+                              MakeTimeChecker(NanoSeconds(1)));
+        return tid;
+    }
+
+    void Insert(const Event& ev) override
+    {
+        SlotArena::Tier tier = SlotArena::GetTier();
+        SlotArena::SetTier(SlotArena::NONE);
+        m_inner->Insert(ev);
+        SlotArena::SetTier(tier);
+    }
+
+    bool IsEmpty() const override
+    {
+        // Called right after every event
+        SlotArena::SetTier(SlotArena::NONE);
+        return m_inner->IsEmpty();
+    }
+
+    Event PeekNext() const override
+    {
+        return m_inner->PeekNext();
+    }
+
+    Event RemoveNext() override
+    {
+        SlotArena::SetTier(SlotArena::NONE);
+        Event ev = m_inner->RemoveNext();
+        uint64_t slot = ev.key.m_ts / m_slotSteps;
+        if (slot != m_slot)
+        {
+            m_arena.EndSlot(m_slot);
+            m_slot = slot;
+        }
+        SlotArena::SetTier(TierOf(ev.impl));
+        return ev;
+    }
+
+    void Remove(const Event& ev) override
+    {
+        SlotArena::Tier tier = SlotArena::GetTier();
+        SlotArena::SetTier(SlotArena::NONE);
+        m_inner->Remove(ev);
+        SlotArena::SetTier(tier);
+    }
+
+  protected:
+    void NotifyConstructionCompleted() override
+    {
+        m_inner = m_innerFactory.Create<Scheduler>();
+        m_slotSteps = m_slotDuration.GetTimeStep();
+        m_arena.Enable();
+        Scheduler::NotifyConstructionCompleted();
+    }
+
+    void DoDispose() override
+    {
+        SlotArena::SetTier(SlotArena::NONE);
+        m_inner = nullptr;
+        Scheduler::DoDispose();
+    }
+
+  private:
+    /**
+     * @param impl an event about to run
+     * @return the tier of the allocations of its layer
+     */
+    SlotArena::Tier TierOf(const EventImpl* impl)
+    {
+        const std::type_info* type = &typeid(*impl);
+        auto it = m_tiers.find(type);
+        if (it != m_tiers.end())
+        {
+            return it->second;
+        }
+        // Member events carry their class in the type name, e.g.
+        // "ns3::MakeEvent<void (ns3::NrGnbPhy::*)(), ...>(...)::EventMemberImpl"
+        std::string layer = ClassifyNrLayer(DemangleSymbol(type->name()));
+        SlotArena::Tier tier = SlotArena::NONE;
+        if (layer.compare(0, 3, "PHY") == 0 || layer.compare(0, 7, "Channel") == 0)
+        {
+            tier = SlotArena::SLOT;
+        }
+        else if (layer.compare(0, 3, "MAC") == 0)
+        {
+            tier = SlotArena::HARQ;
+        }
+        m_tiers.emplace(type, tier);
+        return tier;
+    }
+
+    ObjectFactory m_innerFactory;                 //!< Factory of the inner scheduler
+    Ptr<Scheduler> m_inner;                       //!< Scheduler holding the events
+    Time m_slotDuration{MilliSeconds(0.5)};       //!< Slot duration
+    uint64_t m_slotSteps{1};                      //!< Slot duration in time steps
+    uint64_t m_slot{0};                           //!< Slot of the last event
+    SlotArena& m_arena{SlotArena::Get()};         //!< The arena of the process
+    /// Tier of the events of every EventImpl type seen so far
+    std::unordered_map<const std::type_info*, SlotArena::Tier> m_tiers;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SlotArenaScheduler);
+
+} // namespace ns3
+
+#endif // SLOT_ARENA_SCHEDULER_H
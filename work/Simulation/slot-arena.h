@@ -0,0 +1,389 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef SLOT_ARENA_H
+#define SLOT_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+
+namespace ns3
+{
+
+/**
+ * @brief Arena for the short-lived objects of the NR PHY and MAC, in two tiers.
+ *
+ * The slot tier is a bump-pointer arena: allocating moves a pointer, freeing decrements the
+ * count of live blocks of the chunk, and at the end of every slot the chunk starts over if all
+ * its blocks are gone (SpectrumValues, interference chunks, TB descriptors usually are). A
+ * chunk still holding blocks is set aside until they are freed, then reused as a whole.
+ *
+ * The HARQ tier serves objects that outlive a few slots (DCIs and other control messages,
+ * HARQ process state): blocks of 16-byte size classes, recycled one by one through a free
+ * list per class, so a survivor never holds a whole chunk.
+ *
+ * Chunks are carved from a single reserved address range, so a pointer is recognized as an
+ * arena block with two compares. Allocations go to the tier of the calling thread
+ * (SetTier()), set by SlotArenaScheduler around the events of the PHY and MAC; the replaced
+ * operator new of alloc-tracker.h asks the arena first and falls back to malloc(). The arena
+ * is not thread-safe: only the simulator thread sets a tier.
+ *
+ * The tier follows the event that allocates, not the lifetime of the object: an object made
+ * by a PHY event and kept far beyond the slot (an EventImpl scheduled seconds ahead, a packet
+ * queued in the RLC, a cache entry) keeps its whole 64 KB chunk out of use until it is freed.
+ * GetRetention() measures these chunks at the end of a run; blocks are never moved.
+ */
+class SlotArena
+{
+  public:
+    /// Where the allocations of the calling thread go
+    enum Tier : uint8_t
+    {
+        NONE, //!< malloc()
+        SLOT, //!< Bump-pointer chunk, reset at the end of the slot
+        HARQ, //!< Size-class free lists
+    };
+
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;          //!< Bytes per chunk
+    static constexpr std::size_t MAX_BLOCK = 1024;                //!< Larger ones use malloc()
+    static constexpr std::size_t ALIGNMENT = 16;                  //!< Alignment of every block
+    static constexpr std::size_t RESERVED = std::size_t{8} << 30; //!< Address range reserved
+
+    /// Counters of the arena
+    struct Stats
+    {
+        uint64_t slotAllocations{0}; //!< Blocks served by the slot tier
+        uint64_t harqAllocations{0}; //!< Blocks served by the HARQ tier
+        uint64_t fallbacks{0};       //!< Requests of a tier left to malloc() (size, space)
+        uint64_t slots{0};           //!< Slot ends seen
+        uint64_t resets{0};          //!< Slot ends that rewound the current chunk in place
+        uint64_t retired{0};         //!< Slot ends that set aside a chunk with live blocks
+        uint64_t chunks{0};          //!< Chunks carved from the reserved range
+    };
+
+    /**
+     * @return the arena of the process
+     */
+    static SlotArena& Get()
+    {
+        static SlotArena arena;
+        return arena;
+    }
+
+    /**
+     * @brief Reserve the address range; until then every request goes to malloc().
+     * @return whether the range could be reserved
+     */
+    bool Enable()
+    {
+        if (m_base == nullptr)
+        {
+            void* base = mmap(nullptr,
+                              RESERVED,
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                              -1,
+                              0);
+            if (base == MAP_FAILED)
+            {
+                return false;
+            }
+            // Chunks are aligned on their size, so a block finds its chunk by masking
+            auto start = reinterpret_cast<uintptr_t>(base);
+            auto aligned = (start + CHUNK_SIZE - 1) & ~(CHUNK_SIZE - 1);
+            m_base = reinterpret_cast<char*>(aligned);
+            m_end = static_cast<char*>(base) + RESERVED;
+            m_next = m_base;
+            g_arenaBegin = reinterpret_cast<uintptr_t>(m_base);
+            g_arenaEnd = reinterpret_cast<uintptr_t>(m_end);
+        }
+        return true;
+    }
+
+    /**
+     * @return the tier of the calling thread
+     */
+    static Tier GetTier()
+    {
+        return t_tier;
+    }
+
+    /**
+     * @brief Route the next allocations of the calling thread.
+     * @param tier the tier
+     */
+    static void SetTier(Tier tier)
+    {
+        t_tier = tier;
+    }
+
+    /**
+     * @param p a block
+     * @return whether the block belongs to the arena
+     */
+    static bool Owns(const void* p)
+    {
+        auto address = reinterpret_cast<uintptr_t>(p);
+        return address >= g_arenaBegin && address < g_arenaEnd;
+    }
+
+    /**
+     * @brief Allocate a block in a tier.
+     * @param size requested bytes
+     * @param tier SLOT or HARQ
+     * @return the block, or nullptr if the request is left to malloc()
+     */
+    void* Allocate(std::size_t size, Tier tier)
+    {
+        std::size_t rounded = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (rounded == 0 || rounded > MAX_BLOCK || m_base == nullptr)
+        {
+            m_stats.fallbacks++;
+            return nullptr;
+        }
+        return tier == SLOT ? AllocateSlot(rounded) : AllocateHarq(rounded);
+    }
+
+    /**
+     * @brief Release a block of the arena.
+     * @param p the block, Owns(p) must be true
+     */
+    void Free(void* p)
+    {
+        Chunk* chunk = ChunkOf(p);
+        if (chunk->sizeClass != 0)
+        {
+            // HARQ tier: back to the free list of its class
+            auto* block = static_cast<FreeBlock*>(p);
+            block->next = m_freeBlocks[chunk->sizeClass];
+            m_freeBlocks[chunk->sizeClass] = block;
+            return;
+        }
+        if (--chunk->live == 0 && chunk != m_current)
+        {
+            // Every block of a set-aside chunk is gone: reuse it whole
+            ReleaseChunk(chunk);
+        }
+    }
+
+    /**
+     * @brief End of a slot: rewind the current slot chunk if all its blocks are gone.
+     * @param slot index of the slot that ends
+     */
+    void EndSlot(uint64_t slot)
+    {
+        m_stats.slots++;
+        m_slot = slot;
+        if (m_current == nullptr)
+        {
+            return;
+        }
+        if (m_current->live == 0)
+        {
+            m_current->used = sizeof(Chunk);
+            m_stats.resets++;
+            return;
+        }
+        m_current->retiredSlot = slot;
+        m_current = nullptr;
+        m_stats.retired++;
+    }
+
+    /**
+     * @return the counters
+     */
+    const Stats& GetStats() const
+    {
+        return m_stats;
+    }
+
+    /**
+     * @return blocks served by either tier
+     */
+    uint64_t GetAllocations() const
+    {
+        return m_stats.slotAllocations + m_stats.harqAllocations;
+    }
+
+    /**
+     * @return bytes of the chunks carved so far, the memory the arena holds at most
+     */
+    uint64_t GetChunkBytes() const
+    {
+        return m_stats.chunks * CHUNK_SIZE;
+    }
+
+    /// Slot chunks kept by objects that outlived the HARQ window
+    struct Retention
+    {
+        uint64_t chunks{0}; //!< Chunks pinned
+        uint64_t blocks{0}; //!< Live blocks pinning them
+    };
+
+    /**
+     * @param ageSlots slots after which a set-aside chunk counts as pinned
+     * @return chunks set aside more than ageSlots ago that still hold a block, and the blocks
+     *         holding them: chunks * CHUNK_SIZE bytes are kept for the few bytes of the blocks
+     */
+    Retention GetRetention(uint64_t ageSlots) const
+    {
+        Retention retention;
+        for (char* p = m_base; p < m_next; p += CHUNK_SIZE)
+        {
+            const auto* chunk = reinterpret_cast<const Chunk*>(p);
+            if (chunk->sizeClass == 0 && chunk->live > 0 && chunk != m_current &&
+                chunk->retiredSlot + ageSlots < m_slot)
+            {
+                retention.chunks++;
+                retention.blocks += chunk->live;
+            }
+        }
+        return retention;
+    }
+
+  private:
+    /// Header at the start of every chunk
+    struct alignas(ALIGNMENT) Chunk
+    {
+        uint32_t used;        //!< Bytes used, header included (slot tier)
+        uint32_t live;        //!< Blocks not freed yet (slot tier)
+        uint32_t sizeClass;   //!< Block size over ALIGNMENT (HARQ tier), 0 for the slot tier
+        uint64_t retiredSlot; //!< Slot at the end of which the chunk was set aside
+        Chunk* nextFree;      //!< Next chunk of the free list
+    };
+
+    /// A free block of the HARQ tier
+    struct FreeBlock
+    {
+        FreeBlock* next; //!< Next free block of the same class
+    };
+
+    static constexpr std::size_t NUM_CLASSES = MAX_BLOCK / ALIGNMENT + 1; //!< HARQ size classes
+
+    SlotArena() = default;
+
+    /**
+     * @param p a block
+     * @return the chunk holding it
+     */
+    static Chunk* ChunkOf(void* p)
+    {
+        return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(p) & ~(CHUNK_SIZE - 1));
+    }
+
+    /**
+     * @return a free chunk, or nullptr if the reserved range is exhausted
+     */
+    Chunk* AcquireChunk()
+    {
+        Chunk* chunk = m_freeChunks;
+        if (chunk != nullptr)
+        {
+            m_freeChunks = chunk->nextFree;
+        }
+        else if (m_next + CHUNK_SIZE <= m_end)
+        {
+            chunk = reinterpret_cast<Chunk*>(m_next);
+            m_next += CHUNK_SIZE;
+            m_stats.chunks++;
+        }
+        else
+        {
+            return nullptr;
+        }
+        std::memset(chunk, 0, sizeof(Chunk));
+        chunk->used = sizeof(Chunk);
+        return chunk;
+    }
+
+    /**
+     * @brief Put a chunk back on the free list.
+     * @param chunk the chunk, without live blocks
+     */
+    void ReleaseChunk(Chunk* chunk)
+    {
+        chunk->nextFree = m_freeChunks;
+        m_freeChunks = chunk;
+    }
+
+    /**
+     * @param size bytes, rounded to the alignment
+     * @return a block of the current slot chunk, or nullptr
+     */
+    void* AllocateSlot(std::size_t size)
+    {
+        if (m_current == nullptr || m_current->used + size > CHUNK_SIZE)
+        {
+            if (m_current != nullptr)
+            {
+                // Full: set aside, or reuse right away if its blocks are all gone
+                m_current->retiredSlot = m_slot;
+                if (m_current->live == 0)
+                {
+                    ReleaseChunk(m_current);
+                }
+            }
+            m_current = AcquireChunk();
+            if (m_current == nullptr)
+            {
+                m_stats.fallbacks++;
+                return nullptr;
+            }
+        }
+        char* block = reinterpret_cast<char*>(m_current) + m_current->used;
+        m_current->used += size;
+        m_current->live++;
+        m_stats.slotAllocations++;
+        return block;
+    }
+
+    /**
+     * @param size bytes, rounded to the alignment
+     * @return a block of the size class, or nullptr
+     */
+    void* AllocateHarq(std::size_t size)
+    {
+        std::size_t sizeClass = size / ALIGNMENT;
+        FreeBlock* block = m_freeBlocks[sizeClass];
+        if (block == nullptr)
+        {
+            // Carve a new chunk into blocks of the class
+            Chunk* chunk = AcquireChunk();
+            if (chunk == nullptr)
+            {
+                m_stats.fallbacks++;
+                return nullptr;
+            }
+            chunk->sizeClass = sizeClass;
+            char* first = reinterpret_cast<char*>(chunk) + sizeof(Chunk);
+            char* end = reinterpret_cast<char*>(chunk) + CHUNK_SIZE;
+            for (char* p = end - size; p >= first; p -= size)
+            {
+                auto* freeBlock = reinterpret_cast<FreeBlock*>(p);
+                freeBlock->next = block;
+                block = freeBlock;
+            }
+        }
+        m_freeBlocks[sizeClass] = block->next;
+        m_stats.harqAllocations++;
+        return block;
+    }
+
+    static inline thread_local Tier t_tier = NONE; //!< Tier of the calling thread
+    static inline uintptr_t g_arenaBegin = 0;      //!< Start of the chunks
+    static inline uintptr_t g_arenaEnd = 0;        //!< End of the reserved range
+
+    char* m_base{nullptr};                  //!< First chunk
+    char* m_end{nullptr};                   //!< End of the reserved range
+    char* m_next{nullptr};                  //!< Next chunk never used yet
+    Chunk* m_current{nullptr};              //!< Chunk of the slot tier being filled
+    Chunk* m_freeChunks{nullptr};           //!< Chunks without live blocks
+    FreeBlock* m_freeBlocks[NUM_CLASSES]{}; //!< Free blocks of the HARQ tier, per class
+    uint64_t m_slot{0};                     //!< Last slot that ended
+    Stats m_stats;                          //!< Counters
+};
+
+} // namespace ns3
+
+#endif // SLOT_ARENA_H
@@ -0,0 +1,282 @@
+"""Cost model and job packing of the benchmark sweeps.
+
+The runs of a sweep differ in cost by orders of magnitude (4 vs 1024 UEs, Friis vs ThreeGpp,
+100 vs 400 MHz). CostModel predicts the process wall time and peak RSS of a run from its
+settings: a port of the pre-flight estimator (scenario-resource-estimator.h) gives the shape
+of the cost, and a ridge regression of log(measured / estimated) on the settings, fitted on
+the benchmark records of completed runs, corrects it for the host and for what the estimator
+ignores (traces, traffic mode, event scheduler). Without records the estimator is used as is.
+
+pack() runs the jobs on a number of parallel slots under a memory cap, longest expected run
+first, so the giant runs start early instead of trailing alone at the end. When the longest
+pending job does not fit in the memory left, it gets a reservation at the time the running
+jobs are expected to have freed enough memory, and smaller jobs backfill the gap if they end
+before it or fit beside it. The model is refitted and the queue re-sorted after every
+completed job. On a single slot the order does not change the sweep time: the model is not
+fitted, and numpy is not needed.
+"""
+
+import concurrent.futures
+import math
+import re
+import statistics
+import time
+
+# Settings the cost depends on, with the defaults of the scenario
+FEATURE_DEFAULTS = {
+    "ueNum": 4,
+    "gNbNum": 1,
+    "channelModel": "ThreeGpp",
+    "bandwidth": 100e6,
+    "numerology": 1,
+    "gnbAntenna": "4x8",
+    "ueAntenna": "1x1",
+    "simTime": 10.0,
+    "enableTraces": True,
+    "largeScale": False,
+    "radioOnly": False,
+    "batchedTraffic": False,
+    "fullBuffer": False,
+    "scheduler": "Map",
+    "slotArena": False,
+    "fingerprint": True,
+    "flowKpis": True,
+}
+
+# ResourceCostCoefficients of scenario-resource-estimator.h
+BASE_MEMORY_BYTES = 96e6
+PER_UE_BYTES = 256e3
+PER_SECTOR_BYTES = 6e6
+CHANNEL_PAIR_BYTES = 16e3
+CHANNEL_PAIR_BYTES_PER_ELEMENT = 320
+SLOT_COST_SECONDS = 15e-6
+LINK_COST_SECONDS_PER_RB = 4e-9
+SPATIAL_COST_PER_ELEMENT = 0.05
+# Process start and scenario setup, which the estimator leaves out of the runtime
+SETUP_SECONDS = 1.0
+
+# Ridge penalty of the corrections; the host factor (intercept) is barely penalized
+RIDGE = 1.0
+RIDGE_INTERCEPT = 1e-3
+
+
+def parse_time(text):
+    """ns-3 time string ("1s", "500ms") or number of seconds -> seconds."""
+    if isinstance(text, (int, float)):
+        return float(text)
+    match = re.fullmatch(r"([0-9.eE+-]+)\s*(ns|us|ms|s|min|h)?", str(text).strip())
+    if not match:
+        raise ValueError(f"not a time: {text!r}")
+    scale = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1, "min": 60, "h": 3600}
+    return float(match.group(1)) * scale[match.group(2) or "s"]
+
+
+def settings(params, extra_args):
+    """Cost-relevant settings of a run from its sweep parameters and extra arguments."""
+    result = dict(FEATURE_DEFAULTS)
+    result.update({k: v for k, v in params.items() if k in FEATURE_DEFAULTS})
+    for arg in extra_args:
+        key, _, value = arg.lstrip("-").partition("=")
+        if key not in FEATURE_DEFAULTS:
+            continue
+        default = FEATURE_DEFAULTS[key]
+        if key == "simTime":
+            result[key] = parse_time(value)
+        elif isinstance(default, bool):
+            result[key] = value.lower() in ("1", "true", "on", "yes")
+        elif isinstance(default, (int, float)):
+            result[key] = float(value)
+        else:
+            result[key] = value
+    return result
+
+
+def record_settings(record):
+    """Cost-relevant settings of a benchmark record."""
+    result = dict(FEATURE_DEFAULTS)
+    result.update({k: v for k, v in record["params"].items() if k in FEATURE_DEFAULTS})
+    result["simTime"] = parse_time(result["simTime"])
+    return result
+
+
+def elements(antenna):
+    rows, cols = str(antenna).split("x")
+    return int(rows) * int(cols)
+
+
+def estimate(s):
+    """Port of EstimateResources: (wall seconds, peak RSS bytes) of a run."""
+    sectors = s["gNbNum"]
+    ues = s["ueNum"]
+    nodes = ues + sectors
+    element_pairs = elements(s["gnbAntenna"]) * elements(s["ueAntenna"])
+    spatial = s["channelModel"] != "Friis"
+    scs = 15e3 * 2 ** s["numerology"]
+    resource_blocks = math.floor(s["bandwidth"] / (12 * scs))
+
+    memory = BASE_MEMORY_BYTES + ues * PER_UE_BYTES + sectors * PER_SECTOR_BYTES
+    if spatial:
+        pairs = nodes * (nodes - 1) / 2
+        memory += pairs * (CHANNEL_PAIR_BYTES + element_pairs * CHANNEL_PAIR_BYTES_PER_ELEMENT)
+
+    slots = s["simTime"] * 1000 * 2 ** s["numerology"]
+    link_cost = LINK_COST_SECONDS_PER_RB * resource_blocks
+    if spatial:
+        link_cost *= 1 + SPATIAL_COST_PER_ELEMENT * element_pairs
+    wall = slots * (sectors * SLOT_COST_SECONDS + 2 * sectors * nodes * link_cost)
+    return wall + SETUP_SECONDS, memory
+
+
+class CostModel:
+    """Predicts (wall seconds, peak RSS bytes) of runs, learning from benchmark records."""
+
+    def __init__(self):
+        self.names = []
+        self.weights = None  # one column per target: wall, memory
+        self.samples = 0
+
+    def features(self, s):
+        """Feature vector of settings over self.names."""
+        import numpy as np
+
+        values = {"1": 1.0}
+        for key, value in s.items():
+            if isinstance(value, bool):
+                values[key] = float(value)
+            elif isinstance(value, (int, float)):
+                values[key] = math.log(max(float(value), 1e-9))
+            else:
+                values[f"{key}={value}"] = 1.0
+        return np.array([values.get(name, 0.0) for name in self.names])
+
+    def fit(self, records):
+        """Fit the corrections on the successful records; returns the number used."""
+        import numpy as np
+
+        rows = []
+        for record in records:
+            metrics = record.get("metrics", {})
+            wall = metrics.get("processWallSec") or metrics.get("wallMs", 0) / 1e3
+            memory = metrics.get("peakRssBytes")
+            if "error" in record or not wall or not memory:
+                continue
+            s = record_settings(record)
+            prior_wall, prior_memory = estimate(s)
+            rows.append((s, math.log(wall / prior_wall), math.log(memory / prior_memory)))
+        self.samples = len(rows)
+        if not rows:
+            self.weights = None
+            return 0
+        names = {"1"}
+        for s, _, _ in rows:
+            for key, value in s.items():
+                names.add(key if isinstance(value, (bool, int, float)) else f"{key}={value}")
+        self.names = sorted(names)
+        x = np.array([self.features(s) for s, _, _ in rows])
+        y = np.array([[wall, memory] for _, wall, memory in rows])
+        penalty = np.diag([RIDGE_INTERCEPT if name == "1" else RIDGE for name in self.names])
+        self.weights = np.linalg.solve(x.T @ x + penalty, x.T @ y)
+        return self.samples
+
+    def predict(self, s):
+        """(wall seconds, peak RSS bytes) expected for settings."""
+        wall, memory = estimate(s)
+        if self.weights is not None:
+            correction = self.features(s) @ self.weights
+            wall *= math.exp(correction[0])
+            memory *= math.exp(correction[1])
+        return wall, memory
+
+
+def memory_cap():
+    """80 % of the available memory in bytes, or infinity if unknown."""
+    try:
+        with open("/proc/meminfo") as f:
+            for line in f:
+                if line.startswith("MemAvailable:"):
+                    return 0.8 * int(line.split()[1]) * 1024
+    except OSError:
+        pass
+    return math.inf
+
+
+def pack(jobs, run, slots, mem_cap, model, history, margin=1.25):
+    """Run jobs in parallel under a memory cap; yield (job, record) as they complete.
+
+    jobs: dicts with the "settings" of the run; run(job) returns its benchmark record.
+    history: records the model is fitted on; the completed records are appended to it.
+    margin: factor on the predicted memory, against underestimates.
+    """
+    pending = list(jobs)
+    running = {}  # future -> (job, start, wall, memory)
+    refit = True
+    with concurrent.futures.ThreadPoolExecutor(max_workers=slots) as executor:
+        while pending or running:
+            if refit:
+                if slots > 1:
+                    model.fit(history)
+                for job in pending:
+                    job["predicted"] = model.predict(job["settings"])
+                pending.sort(key=lambda job: job["predicted"][0], reverse=True)
+                refit = False
+            while pending and len(running) < slots:
+                job = pick(pending, running, mem_cap, margin)
+                if job is None:
+                    break
+                pending.remove(job)
+                wall, memory = job["predicted"]
+                future = executor.submit(run, job)
+                running[future] = (job, time.monotonic(), wall, memory * margin)
+            done, _ = concurrent.futures.wait(
+                running, return_when=concurrent.futures.FIRST_COMPLETED
+            )
+            for future in done:
+                job = running.pop(future)[0]
+                record = future.result()
+                record["predicted"] = {
+                    "processWallSec": job["predicted"][0],
+                    "peakRssBytes": job["predicted"][1],
+                }
+                history.append(record)
+                refit = True
+                yield job, record
+
+
+def pick(pending, running, mem_cap, margin):
+    """Next job to start: the longest one if it fits, else a backfill around its reservation."""
+    free = mem_cap - sum(memory for _, _, _, memory in running.values())
+    head = pending[0]
+    need = head["predicted"][1] * margin
+    if need <= free or not running:
+        # Alone on the host, a job runs even above the cap
+        return head
+    # Reservation of the head: when the running jobs are expected to have freed its memory
+    now = time.monotonic()
+    shadow, spare = now, free
+    for _, start, wall, memory in sorted(running.values(), key=lambda r: r[1] + r[2]):
+        shadow = max(now, start + wall)
+        spare += memory
+        if spare >= need:
+            break
+    spare -= need
+    for job in pending[1:]:
+        wall, memory = job["predicted"]
+        memory *= margin
+        if memory <= free and (now + wall <= shadow or memory <= spare):
+            return job
+    return None
+
+
+def prediction_error(records):
+    """Median relative error of the wall time and memory predictions, or None."""
+    walls, memories = [], []
+    for record in records:
+        predicted = record.get("predicted")
+        metrics = record.get("metrics", {})
+        if "error" in record or not predicted or not metrics.get("peakRssBytes"):
+            continue
+        walls.append(abs(predicted["processWallSec"] / metrics["processWallSec"] - 1))
+        memories.append(abs(predicted["peakRssBytes"] / metrics["peakRssBytes"] - 1))
+    if not walls:
+        return None
+    return statistics.median(walls), statistics.median(memories)
@@ -0,0 +1,423 @@
+#!/usr/bin/env python3
+"""Run a sweep on several machines sharing only a filesystem, through a directory work queue.
+
+`submit` writes one job file per run into the queue directory, `work` runs on every node
+(from its ns-3 root folder, with its own build) and executes jobs until the queue is drained,
+and `status` reports the progress and collects the records. A job is a seed and run number,
+like run-multi-sim.sh, for every combination of the --param values; its output directory
+lands in the results directory as seedN_runM, under the key of the varying parameters if
+any (ueNum-64/seed100_run1), wherever it ran.
+
+Queue layout; every transition is a rename, atomic on a local or NFS filesystem:
+    pending/<queue>/<rank>-<MB>-<job>.json  waiting; queue is a node name, or "any"
+    claimed/<owner>__<name>                 running; the mtime is the heartbeat of the owner
+    transit/<owner>__<name>                 being finished or requeued by its owner
+    done/<name>, failed/<name>              benchmark record of the run
+
+The rank orders the jobs longest expected first and MB is the expected peak RSS, both from
+the cost model of sweep_packing.py. A node takes jobs from its own queue (--nodes of submit
+balances the expected work over the nodes), then from "any", then steals from the node with
+the most pending jobs. Claims whose heartbeat is older than --lease, those of dead or cut-off
+workers, are requeued by any other worker; a worker that lost its lease drops its result.
+Keep --lease well above the attribute cache time of NFS clients and the clock skew.
+
+Example:
+    ./sweep_queue.py submit /shared/q --seeds 100-109 --runs 3 --results /shared/sim_results \\
+        --channelModel=ThreeGpp --channelConditionModel=NLOS
+    ./sweep_queue.py work /shared/q -j 8            # on every node
+    ./sweep_queue.py status /shared/q --records bench.json
+"""
+
+import argparse
+import concurrent.futures
+import json
+import os
+import shutil
+import socket
+import sys
+import threading
+import time
+
+from bench_sweep import build, parse_list, run_key, run_one
+from sweep_packing import CostModel, memory_cap, settings
+
+STATES = ("pending", "claimed", "transit", "done", "failed")
+ANY = "any"
+SEPARATOR = "__"
+
+
+def parse_range(text):
+    """"100-109" or "100" -> list of ints."""
+    first, _, last = text.partition("-")
+    return list(range(int(first), int(last or first) + 1))
+
+
+def parse_value(text):
+    for cast in (int, float):
+        try:
+            return cast(text)
+        except ValueError:
+            pass
+    return {"true": True, "false": False}.get(text.lower(), text)
+
+
+def parse_param(text):
+    """KEY=V1,V2 -> (key, values)."""
+    key, _, values = text.partition("=")
+    if not key or not values:
+        raise argparse.ArgumentTypeError(f"expected KEY=V1,V2, got {text!r}")
+    return key, parse_list(values, parse_value)
+
+
+def write_json(path, data, owner):
+    """Write a file atomically: readers see the old content or the new one."""
+    tmp = f"{path}.{owner}.tmp"
+    with open(tmp, "w") as f:
+        json.dump(data, f, indent=1)
+    os.replace(tmp, path)
+
+
+def read_json(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+class WorkQueue:
+    """Job files of a shared directory, moved between the state directories by rename."""
+
+    def __init__(self, root):
+        self.root = os.path.abspath(root)
+        for state in STATES:
+            os.makedirs(os.path.join(self.root, state), exist_ok=True)
+        config = os.path.join(self.root, "config.json")
+        self.config = read_json(config) if os.path.exists(config) else {}
+
+    def path(self, *parts):
+        return os.path.join(self.root, *parts)
+
+    def results(self):
+        return os.path.normpath(self.path(self.config.get("results", "results")))
+
+    def jobs(self, state, queue=None):
+        """Names of the job files in a state directory."""
+        directory = self.path(state, queue) if queue else self.path(state)
+        try:
+            return sorted(n for n in os.listdir(directory) if n.endswith(".json"))
+        except FileNotFoundError:
+            return []
+
+    def queues(self):
+        return sorted(os.listdir(self.path("pending")))
+
+    def known(self):
+        """Job identifiers in any state."""
+        names = [n for q in self.queues() for n in self.jobs("pending", q)]
+        for state in STATES[1:]:
+            names += [n.split(SEPARATOR)[-1] for n in self.jobs(state)]
+        return {n.split("-", 2)[2][: -len(".json")] for n in names}
+
+    def add(self, job, queue, owner):
+        directory = self.path("pending", queue)
+        os.makedirs(directory, exist_ok=True)
+        write_json(os.path.join(directory, job["name"]), job, owner)
+
+    def claim(self, owner, node, max_memory):
+        """Claim the next job of the node, or steal one; return (job, stolen) or None."""
+        others = [q for q in self.queues() if q not in (node, ANY)]
+        # Steal from the most loaded node first
+        others.sort(key=lambda q: len(self.jobs("pending", q)), reverse=True)
+        for queue in [node, ANY] + others:
+            for name in self.jobs("pending", queue):
+                if int(name.split("-")[1]) * 1e6 > max_memory:
+                    continue
+                source = self.path("pending", queue, name)
+                target = self.path("claimed", owner + SEPARATOR + name)
+                try:
+                    # Fresh heartbeat before the job shows up as claimed
+                    os.utime(source)
+                    os.rename(source, target)
+                except FileNotFoundError:
+                    continue  # Claimed by another worker in the meantime
+                return read_json(target), queue not in (node, ANY)
+        return None
+
+    def heartbeat(self, owner, name):
+        try:
+            os.utime(self.path("claimed", owner + SEPARATOR + name))
+        except FileNotFoundError:
+            pass
+
+    def begin_transit(self, owner, state, entry):
+        """Take a claimed or transit entry over; returns its transit path or None."""
+        target = self.path("transit", owner + SEPARATOR + entry.split(SEPARATOR, 1)[1])
+        try:
+            os.rename(self.path(state, entry), target)
+        except FileNotFoundError:
+            return None
+        os.utime(target)
+        return target
+
+    def finish(self, owner, job, record, run_dir, retries):
+        """Publish the result of a claimed job; False if the lease was lost meanwhile."""
+        transit = self.begin_transit(owner, "claimed", owner + SEPARATOR + job["name"])
+        if transit is None:
+            return False
+        if "error" in record and job.get("attempts", 0) < retries:
+            job["attempts"] = job.get("attempts", 0) + 1
+            self.add(job, ANY, owner)
+            shutil.rmtree(run_dir, ignore_errors=True)
+        else:
+            final = os.path.join(self.results(), job["path"])
+            if os.path.exists(final):
+                shutil.rmtree(final)
+            os.makedirs(os.path.dirname(final), exist_ok=True)
+            os.rename(run_dir, final)
+            state = "failed" if "error" in record else "done"
+            write_json(self.path(state, job["name"]), record, owner)
+        os.remove(transit)
+        return True
+
+    def expire(self, owner, lease, max_expired):
+        """Requeue the claims whose heartbeat is older than the lease; returns their names."""
+        requeued = []
+        now = time.time()
+        for state in ("claimed", "transit"):
+            for entry in self.jobs(state):
+                try:
+                    age = now - os.path.getmtime(self.path(state, entry))
+                except FileNotFoundError:
+                    continue
+                if age < lease:
+                    continue
+                transit = self.begin_transit(owner, state, entry)
+                if transit is None:
+                    continue
+                job = read_json(transit)
+                job["expired"] = job.get("expired", 0) + 1
+                if job["expired"] > max_expired:
+                    error = f"lease expired {job['expired']} times"
+                    record = {"params": job["params"], "metrics": {}, "error": error}
+                    write_json(self.path("failed", job["name"]), record, owner)
+                else:
+                    self.add(job, ANY, owner)
+                os.remove(transit)
+                requeued.append(job["name"])
+        return requeued
+
+    def drained(self):
+        return not any(self.jobs("pending", q) for q in self.queues()) and not (
+            self.jobs("claimed") or self.jobs("transit")
+        )
+
+
+def submit(args, passthrough):
+    queue = WorkQueue(args.queue)
+    results = os.path.relpath(os.path.abspath(args.results), queue.root)
+    if queue.config.get("results", results) != results:
+        print(f"Queue already writes to {queue.results()}", file=sys.stderr)
+        return 1
+    write_json(queue.path("config.json"), {"results": results}, "submit")
+
+    model = CostModel()
+    history = []
+    for path in args.history:
+        history.extend(read_json(path)["records"])
+    model.fit(history)
+
+    grid = dict(args.param)
+    varying = [k for k, values in grid.items() if len(values) > 1]
+    known = queue.known()
+    extra = [f"--simTime={args.sim_time}"] + passthrough
+    jobs = []
+    for seed in args.seeds:
+        for run in range(1, args.runs + 1):
+            for values in _product(grid):
+                run_dir = f"seed{seed}_run{run}"
+                if varying:
+                    run_dir = run_key({k: values[k] for k in varying}) + "/" + run_dir
+                job_id = run_dir.replace("/", "+")
+                if job_id in known:
+                    continue
+                params = dict(values, seed=seed, run=run)
+                wall, memory = model.predict(settings(params, extra))
+                rank = max(0, 9999999999 - int(wall * 1000))
+                jobs.append(
+                    {
+                        "name": f"{rank:010d}-{int(memory / 1e6):07d}-{job_id}.json",
+                        "path": run_dir,
+                        "params": params,
+                        "args": extra,
+                        "predicted": [wall, memory],
+                    }
+                )
+
+    # Longest processing time first onto the least loaded node
+    nodes = args.nodes or [ANY]
+    load = {node: 0.0 for node in nodes}
+    for job in sorted(jobs, key=lambda j: j["predicted"][0], reverse=True):
+        node = min(nodes, key=lambda n: load[n])
+        load[node] += job["predicted"][0]
+        queue.add(job, node, "submit")
+    print(f"{len(jobs)} jobs queued in {queue.root}, {len(known)} already known")
+    for node in nodes:
+        print(f"    {node}: {load[node] / 3600:.2f} h expected")
+    return 0
+
+
+def _product(grid):
+    combos = [{}]
+    for key, values in grid.items():
+        combos = [dict(c, **{key: v}) for c in combos for v in values]
+    return combos
+
+
+def work(args):
+    queue = WorkQueue(args.queue)
+    owner = f"{args.node}-{os.getpid()}"
+    if not args.no_build:
+        build(args.ns3)
+    mem_cap = args.mem_cap_mb * 1e6 if args.mem_cap_mb else memory_cap()
+    work_dir = os.path.join(queue.results(), ".work", owner)
+    # Claim token (owner and claim number, so that a requeued job claimed again by this
+    # worker is a new claim) -> (job name, predicted memory)
+    held = {}
+    lock = threading.Lock()
+    stop = threading.Event()
+    counts = {"run": 0, "stolen": 0, "lost": 0, "requeued": 0}
+
+    def keep_alive():
+        while not stop.wait(args.heartbeat):
+            with lock:
+                claims = list(held.items())
+            for token, (name, _) in claims:
+                queue.heartbeat(token, name)
+            for name in queue.expire(owner, args.lease, args.max_expired):
+                counts["requeued"] += 1
+                print(f"[{owner}] requeued {name}: lease expired", flush=True)
+
+    def execute(job, token, stolen):
+        claim_dir = os.path.join(work_dir, token)
+        record = run_one(args.ns3, job["params"], claim_dir, job["args"], args.timeout)
+        record["node"] = args.node
+        record["stolen"] = stolen
+        record["path"] = job["path"]
+        run_dir = os.path.join(claim_dir, record["key"])
+        if queue.finish(token, job, record, run_dir, args.retries):
+            verdict = record.get("error", "done")
+        else:
+            counts["lost"] += 1
+            verdict = "lease lost, result dropped"
+        shutil.rmtree(claim_dir, ignore_errors=True)
+        with lock:
+            del held[token]
+        print(f"[{owner}] {job['path']}{' (stolen)' if stolen else ''}: {verdict}", flush=True)
+
+    heartbeat = threading.Thread(target=keep_alive, daemon=True)
+    heartbeat.start()
+    running = set()
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as executor:
+        while True:
+            while len(running) < args.jobs:
+                with lock:
+                    free = mem_cap - sum(m for _, m in held.values()) if held else float("inf")
+                token = f"{owner}.{counts['run']}"
+                claimed = queue.claim(token, args.node, free)
+                if claimed is None:
+                    break
+                job, stolen = claimed
+                with lock:
+                    held[token] = (job["name"], job["predicted"][1])
+                counts["run"] += 1
+                counts["stolen"] += stolen
+                running.add(executor.submit(execute, job, token, stolen))
+            if not running and queue.drained():
+                break
+            done, running = concurrent.futures.wait(
+                running, timeout=args.poll, return_when=concurrent.futures.FIRST_COMPLETED
+            )
+            for future in done:
+                future.result()
+    stop.set()
+    shutil.rmtree(work_dir, ignore_errors=True)
+    print(
+        f"[{owner}] queue drained: {counts['run']} jobs run ({counts['stolen']} stolen), "
+        f"{counts['lost']} leases lost, {counts['requeued']} expired claims requeued"
+    )
+    return 0
+
+
+def status(args):
+    queue = WorkQueue(args.queue)
+    now = time.time()
+    pending = {q: len(queue.jobs("pending", q)) for q in queue.queues()}
+    print(f"pending: {sum(pending.values())} " + " ".join(f"{q}={n}" for q, n in pending.items()))
+    for entry in queue.jobs("claimed"):
+        worker, _, name = entry.partition(SEPARATOR)
+        try:
+            age = now - os.path.getmtime(queue.path("claimed", entry))
+        except FileNotFoundError:
+            continue
+        print(f"claimed: {name.split('-', 2)[2][:-5]} by {worker}, heartbeat {age:.0f} s ago")
+    records = []
+    for state in ("done", "failed"):
+        for name in queue.jobs(state):
+            records.append(read_json(queue.path(state, name)))
+    nodes = {}
+    for record in records:
+        ran, stolen = nodes.get(record.get("node", "?"), (0, 0))
+        nodes[record.get("node", "?")] = (ran + 1, stolen + bool(record.get("stolen")))
+    failed = len(queue.jobs("failed"))
+    print(f"done: {len(records) - failed}, failed: {failed}, results in {queue.results()}")
+    for node, (ran, stolen) in sorted(nodes.items()):
+        print(f"    {node}: {ran} jobs ({stolen} stolen)")
+    if args.records:
+        with open(args.records, "w") as f:
+            json.dump({"records": records}, f, indent=1)
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    sub = commands.add_parser("submit", help="queue the jobs of a sweep")
+    sub.add_argument("queue", help="queue directory on the shared filesystem")
+    sub.add_argument("--results", default="sim_results", help="results directory, shared too")
+    sub.add_argument("--seeds", type=parse_range, default=parse_range("100-109"), help="e.g. 1-5")
+    sub.add_argument("--runs", type=int, default=3, help="run numbers per seed")
+    sub.add_argument(
+        "--param", type=parse_param, action="append", default=[], help="KEY=V1,V2; repeatable"
+    )
+    sub.add_argument("--sim-time", default="10s", help="simulated time of every run")
+    sub.add_argument("--nodes", type=lambda t: parse_list(t, str), help="spread over these")
+    sub.add_argument("--history", action="append", default=[], help="records for the cost model")
+
+    sub = commands.add_parser("work", help="run jobs until the queue is drained")
+    sub.add_argument("queue")
+    sub.add_argument("--node", default=socket.gethostname(), help="name of this node")
+    sub.add_argument("--ns3", default="./ns3", help="ns3 driver script (default ./ns3)")
+    sub.add_argument("-j", "--jobs", type=int, default=1, help="runs in parallel")
+    sub.add_argument("--mem-cap-mb", type=float, default=None)
+    sub.add_argument("--lease", type=float, default=120, help="s without heartbeat to requeue")
+    sub.add_argument("--heartbeat", type=float, default=15, help="s between heartbeats")
+    sub.add_argument("--poll", type=float, default=5, help="s between looks at an empty queue")
+    sub.add_argument("--retries", type=int, default=1, help="reruns of a failed job")
+    sub.add_argument("--max-expired", type=int, default=3, help="requeues before failing")
+    sub.add_argument("--timeout", type=float, default=None, help="per-run timeout in s")
+    sub.add_argument("--no-build", action="store_true")
+
+    sub = commands.add_parser("status", help="report progress, collect the records")
+    sub.add_argument("queue")
+    sub.add_argument("--records", help="write the records, as bench_sweep.py does")
+
+    # Unknown options of submit are passed to the scenario, e.g. --channelModel=NYU
+    args, passthrough = parser.parse_known_args()
+    if args.command == "submit":
+        return submit(args, passthrough)
+    if passthrough:
+        parser.error(f"unrecognized arguments: {' '.join(passthrough)}")
+    return work(args) if args.command == "work" else status(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
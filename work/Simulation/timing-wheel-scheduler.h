@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef TIMING_WHEEL_SCHEDULER_H
+#define TIMING_WHEEL_SCHEDULER_H
+
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/nstime.h"
+#include "ns3/scheduler.h"
+#include "ns3/type-id.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Event scheduler made of a timing wheel of symbol-wide buckets, backed by a heap for
+ *        the events beyond the wheel.
+ *
+ * NR events cluster on the OFDM symbol and slot boundaries, a few hundred microseconds ahead
+ * of the current time: the next symbol, slot, HARQ feedback, CSI report. The wheel holds the
+ * events of the next "WheelSize" buckets of "Granularity" each (1024 symbols, about 37 ms at
+ * numerology 1, by default), in the bucket of their time; inserting one is a push_back.
+ * Events further ahead (application timers, the end of the simulation) go to an overflow heap
+ * and move into the wheel once it turns close enough to them.
+ *
+ * A bucket is sorted only when the simulator reaches it; events inserted into the bucket being
+ * drained usually come last (same time, larger uid) and are appended. Events leave in the
+ * exact (time, uid) order of the other schedulers, so runs are bit-identical to them.
+ *
+ * Select it like any scheduler, before the first event is scheduled:
+ * @code
+ * Config::SetDefault("ns3::TimingWheelScheduler::Granularity", TimeValue(NanoSeconds(35714)));
+ * Simulator::SetScheduler(ObjectFactory("ns3::TimingWheelScheduler"));
+ * @endcode
+ * or with --SchedulerType=ns3::TimingWheelScheduler in programs that do not set their own.
+ */
+class TimingWheelScheduler : public Scheduler
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::TimingWheelScheduler")
+                .SetParent<Scheduler>()
+                .SetGroupName("Core")
+                .AddConstructor<TimingWheelScheduler>()
+                .AddAttribute("Granularity",
+                              "Time span of a bucket, best set to the OFDM symbol duration.",
+                              TimeValue(NanoSeconds(35714)),
+                              MakeTimeAccessor(&TimingWheelScheduler::m_granularity),
+                              MakeTimeChecker(NanoSeconds(1)))
+                .AddAttribute("WheelSize",
+                              "Buckets of the wheel, a power of two; later events wait in the "
+                              "overflow heap.",
+                              UintegerValue(1024),
+                              MakeUintegerAccessor(&TimingWheelScheduler::m_numBuckets),
+                              MakeUintegerChecker<uint32_t>(1));
+        return tid;
+    }
+
+    void Insert(const Event& ev) override
+    {
+        uint64_t bucket = ev.key.m_ts / m_width;
+        if (bucket >= m_base + m_numBuckets)
+        {
+            m_overflow.push_back(ev);
+            std::push_heap(m_overflow.begin(), m_overflow.end(), Later);
+            return;
+        }
+        InsertIntoWheel(ev, bucket);
+    }
+
+    bool IsEmpty() const override
+    {
+        return m_wheelEvents == 0 && m_overflow.empty();
+    }
+
+    Event PeekNext() const override
+    {
+        if (m_wheelEvents == 0)
+        {
+            return m_overflow.front();
+        }
+        Bucket& bucket = NextBucket();
+        return bucket.events[bucket.head];
+    }
+
+    Event RemoveNext() override
+    {
+        Event ev;
+        if (m_wheelEvents > 0)
+        {
+            Bucket& bucket = NextBucket();
+            ev = bucket.events[bucket.head++];
+            m_wheelEvents--;
+            m_base = m_next;
+            if (bucket.head == bucket.events.size())
+            {
+                bucket.Clear();
+                m_nextValid = false;
+            }
+        }
+        else
+        {
+            std::pop_heap(m_overflow.begin(), m_overflow.end(), Later);
+            ev = m_overflow.back();
+            m_overflow.pop_back();
+            m_base = ev.key.m_ts / m_width;
+        }
+        // The wheel turned: the overflow events now within its span move into it
+        while (!m_overflow.empty() &&
+               m_overflow.front().key.m_ts / m_width < m_base + m_numBuckets)
+        {
+            std::pop_heap(m_overflow.begin(), m_overflow.end(), Later);
+            InsertIntoWheel(m_overflow.back(), m_overflow.back().key.m_ts / m_width);
+            m_overflow.pop_back();
+        }
+        return ev;
+    }
+
+    void Remove(const Event& ev) override
+    {
+        uint64_t index = ev.key.m_ts / m_width;
+        if (index >= m_base + m_numBuckets)
+        {
+            auto it = std::find_if(m_overflow.begin(), m_overflow.end(), [&ev](const Event& e) {
+                return e.key.m_uid == ev.key.m_uid;
+            });
+            NS_ASSERT_MSG(it != m_overflow.end(), "Event " << ev.key.m_uid << " not scheduled");
+            *it = m_overflow.back();
+            m_overflow.pop_back();
+            std::make_heap(m_overflow.begin(), m_overflow.end(), Later);
+            return;
+        }
+        Bucket& bucket = m_buckets[index & m_mask];
+        auto it = std::find_if(bucket.events.begin() + bucket.head,
+                               bucket.events.end(),
+                               [&ev](const Event& e) { return e.key.m_uid == ev.key.m_uid; });
+        NS_ASSERT_MSG(it != bucket.events.end(), "Event " << ev.key.m_uid << " not scheduled");
+        bucket.events.erase(it);
+        m_wheelEvents--;
+        if (bucket.head == bucket.events.size())
+        {
+            bucket.Clear();
+            if (m_nextValid && m_next == index)
+            {
+                m_nextValid = false;
+            }
+        }
+    }
+
+  protected:
+    void NotifyConstructionCompleted() override
+    {
+        NS_ABORT_MSG_IF(m_numBuckets & (m_numBuckets - 1),
+                        "The WheelSize of TimingWheelScheduler must be a power of two");
+        m_width = m_granularity.GetTimeStep();
+        m_mask = m_numBuckets - 1;
+        m_buckets.resize(m_numBuckets);
+        Scheduler::NotifyConstructionCompleted();
+    }
+
+  private:
+    /// Events of one bucket, sorted from head on once the simulator reaches the bucket
+    struct Bucket
+    {
+        std::vector<Event> events; //!< Events, the first head ones already removed
+        std::size_t head{0};       //!< First event not removed yet
+        bool sorted{true};         //!< Whether events[head..] is in (time, uid) order
+
+        /// Empty the bucket, keeping its capacity for the next turn of the wheel
+        void Clear()
+        {
+            events.clear();
+            head = 0;
+            sorted = true;
+        }
+    };
+
+    /**
+     * @param a an event
+     * @param b another event
+     * @return whether a leaves before b
+     */
+    static bool Earlier(const Event& a, const Event& b)
+    {
+        return a.key < b.key;
+    }
+
+    /**
+     * @brief Heap order of the overflow events, earliest on top.
+     * @param a an event
+     * @param b another event
+     * @return whether a leaves after b
+     */
+    static bool Later(const Event& a, const Event& b)
+    {
+        return b.key < a.key;
+    }
+
+    /**
+     * @brief Add an event to its bucket, within the span of the wheel.
+     * @param ev the event
+     * @param index absolute bucket of the event (its time over the granularity)
+     */
+    void InsertIntoWheel(const Event& ev, uint64_t index)
+    {
+        Bucket& bucket = m_buckets[index & m_mask];
+        if (!bucket.sorted || bucket.head == bucket.events.size() ||
+            !(ev.key < bucket.events.back().key))
+        {
+            bucket.events.push_back(ev);
+        }
+        else if (bucket.head > 0)
+        {
+            // Bucket being drained: keep its order
+            auto it = std::upper_bound(bucket.events.begin() + bucket.head,
+                                       bucket.events.end(),
+                                       ev,
+                                       Earlier);
+            bucket.events.insert(it, ev);
+        }
+        else
+        {
+            bucket.events.push_back(ev);
+            bucket.sorted = false;
+        }
+        m_wheelEvents++;
+        if (m_nextValid && index < m_next)
+        {
+            m_next = index;
+        }
+    }
+
+    /**
+     * @return the earliest non-empty bucket, sorted; the wheel must hold an event
+     */
+    Bucket& NextBucket() const
+    {
+        if (!m_nextValid)
+        {
+            m_next = m_base;
+            while (m_buckets[m_next & m_mask].head == m_buckets[m_next & m_mask].events.size())
+            {
+                m_next++;
+            }
+            m_nextValid = true;
+        }
+        Bucket& bucket = m_buckets[m_next & m_mask];
+        if (!bucket.sorted)
+        {
+            std::sort(bucket.events.begin() + bucket.head,
+                      bucket.events.end(),
+                      Earlier);
+            bucket.sorted = true;
+        }
+        return bucket;
+    }
+
+    Time m_granularity{NanoSeconds(35714)}; //!< Time span of a bucket
+    uint32_t m_numBuckets{1024};            //!< Buckets of the wheel
+    uint64_t m_width{1};                    //!< Time steps per bucket
+    uint64_t m_mask{0};                     //!< Bucket index mask
+    uint64_t m_base{0};                     //!< Absolute bucket of the last removed event
+    uint64_t m_wheelEvents{0};              //!< Events in the wheel
+
+    mutable std::vector<Bucket> m_buckets; //!< Wheel, sorted lazily (also by PeekNext())
+    mutable uint64_t m_next{0};            //!< Absolute bucket of the next event
+    mutable bool m_nextValid{false};       //!< Whether m_next is up to date
+    std::vector<Event> m_overflow;         //!< Events beyond the wheel, a heap by Later()
+};
+
+NS_OBJECT_ENSURE_REGISTERED(TimingWheelScheduler);
+
+} // namespace ns3
+
+#endif // TIMING_WHEEL_SCHEDULER_H
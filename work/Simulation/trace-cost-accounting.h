@@ -0,0 +1,497 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef TRACE_COST_ACCOUNTING_H
+#define TRACE_COST_ACCOUNTING_H
+
+/**
+ * @file
+ * Cost of the NR trace files, per trace family.
+ *
+ * The sinks are the static callbacks of NrPhyRxTrace and NrMacRxTrace, so the files are the
+ * same as with the NrHelper::Enable*Traces() calls. Every call is timed, and the time spent in
+ * write(2) and writev(2) meanwhile is charged as I/O; the rest of the call is formatting.
+ *
+ * To see the system calls of the C++ streams, this header replaces write() and writev() of
+ * the program, like alloc-tracker.h replaces operator new: it must be included by exactly one
+ * translation unit, the one holding main(). Outside the trace sinks the replacements only
+ * forward to the system call.
+ */
+
+#include "run-fingerprint.h"
+#include "run-record.h"
+
+#include "ns3/config.h"
+#include "ns3/nr-mac-rx-trace.h"
+#include "ns3/nr-phy-rx-trace.h"
+#include "ns3/object.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#if defined(__linux__) && defined(__GLIBC__)
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace ns3
+{
+
+/**
+ * @brief System calls that wrote output while a trace sink was running.
+ */
+struct TraceIoCost
+{
+    uint64_t writes{0}; //!< write(2)/writev(2) calls
+    uint64_t bytes{0};  //!< Bytes written
+    uint64_t ns{0};     //!< Wall time in those calls
+};
+
+/// I/O cost of the trace sink running on this thread, nullptr outside the sinks
+inline thread_local TraceIoCost* g_traceIoCost = nullptr;
+
+/**
+ * @brief Cost of one trace family.
+ */
+struct TraceFamilyCost
+{
+    const char* name{""}; //!< Family name, as in the NrHelper method enabling it
+    uint64_t records{0};  //!< Sink calls, one line each
+    uint64_t sinkNs{0};   //!< Wall time in the sinks
+    TraceIoCost io{};     //!< Output system calls made by the sinks
+
+    /**
+     * @return the time spent formatting, i.e. in the sinks but not in I/O, in ns
+     */
+    uint64_t FormatNs() const
+    {
+        return sinkNs > io.ns ? sinkNs - io.ns : 0;
+    }
+};
+
+/**
+ * @brief Connects the four NR trace families of the scenario through timed sinks.
+ *
+ * Replaces NrHelper::EnableDlDataPhyTraces(), EnableDlMacSchedTraces(),
+ * EnableGnbMacCtrlMsgsTraces() and EnablePathlossTraces(). The files are the same; the cost
+ * of each family is reported with Print() and ToRecord(). Bytes are counted when the streams
+ * flush, so the tail a stream flushes when it is closed at exit is not included.
+ */
+class TraceCostAccounting
+{
+  public:
+    /// Trace families
+    enum Family
+    {
+        DL_DATA_PHY = 0,
+        DL_MAC_SCHED,
+        GNB_MAC_CTRL_MSGS,
+        PATHLOSS,
+        NUM_FAMILIES
+    };
+
+    TraceCostAccounting()
+        : m_phyStats(CreateObject<NrPhyRxTrace>()),
+          m_macStats(CreateObject<NrMacRxTrace>())
+    {
+    }
+
+    /**
+     * @brief Write the DL data SINR of every UE (DlDataSinr.txt).
+     */
+    void EnableDlDataPhyTraces()
+    {
+        Config::Connect("/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/NrUePhy/DlDataSinr",
+                        MakeBoundCallback(&TraceCostAccounting::DlDataSinr, this));
+    }
+
+    /**
+     * @brief Write the DL scheduling decisions of every gNB (NrDlMacStats.txt).
+     */
+    void EnableDlMacSchedTraces()
+    {
+        Config::Connect("/NodeList/*/DeviceList/*/BandwidthPartMap/*/NrGnbMac/DlScheduling",
+                        MakeBoundCallback(&TraceCostAccounting::DlMacSched, this));
+    }
+
+    /**
+     * @brief Write the control messages received and sent by every gNB MAC
+     *        (RxedGnbMacCtrlMsgsTrace.txt, TxedGnbMacCtrlMsgsTrace.txt).
+     */
+    void EnableGnbMacCtrlMsgsTraces()
+    {
+        Config::Connect(
+            "/NodeList/*/DeviceList/*/BandwidthPartMap/*/NrGnbMac/GnbMacRxedCtrlMsgsTrace",
+            MakeBoundCallback(&TraceCostAccounting::RxedGnbMacCtrlMsgs, this));
+        Config::Connect(
+            "/NodeList/*/DeviceList/*/BandwidthPartMap/*/NrGnbMac/GnbMacTxedCtrlMsgsTrace",
+            MakeBoundCallback(&TraceCostAccounting::TxedGnbMacCtrlMsgs, this));
+    }
+
+    /**
+     * @brief Write the pathloss of every transmission (DlPathlossTrace.txt, UlPathlossTrace.txt).
+     */
+    void EnablePathlossTraces()
+    {
+        Config::Connect("/ChannelList/*/$ns3::SpectrumChannel/PathLoss",
+                        MakeBoundCallback(&TraceCostAccounting::Pathloss, this));
+    }
+
+    /**
+     * @brief Hand one record to the DlDataSinr sink, as the UE PHY trace source does.
+     * @param cellId cell of the UE
+     * @param rnti the UE
+     * @param avgSinr average SINR of the transport block, linear
+     * @param bwpId bandwidth part
+     */
+    void RecordDlDataSinr(uint16_t cellId, uint16_t rnti, double avgSinr, uint16_t bwpId)
+    {
+        DlDataSinr(this, "", cellId, rnti, avgSinr, bwpId);
+    }
+
+    /**
+     * @brief Add the fields of every trace record to a fingerprint.
+     * @param fingerprint the fingerprint, which must outlive the sinks; nullptr to stop
+     */
+    void SetFingerprint(RunFingerprint* fingerprint)
+    {
+        m_fingerprint = fingerprint;
+    }
+
+    /**
+     * @brief Drop the records from now on (or again write them), e.g. to shed load in realtime.
+     * @param muted whether the sinks return right away
+     */
+    void SetMuted(bool muted)
+    {
+        m_muted = muted;
+    }
+
+    /**
+     * @param family a trace family
+     * @return its cost so far
+     */
+    const TraceFamilyCost& GetCost(Family family) const
+    {
+        return m_costs[family];
+    }
+
+    /**
+     * @brief Print one line per trace family and the total.
+     */
+    void Print() const
+    {
+        TraceFamilyCost total{"total"};
+        printf("Trace cost:\n");
+        for (const auto& cost : m_costs)
+        {
+            PrintLine(cost);
+            total.records += cost.records;
+            total.sinkNs += cost.sinkNs;
+            total.io.writes += cost.io.writes;
+            total.io.bytes += cost.io.bytes;
+            total.io.ns += cost.io.ns;
+        }
+        PrintLine(total);
+    }
+
+    /**
+     * @return the cost of every family, as a record for the benchmark JSON
+     */
+    RunRecord ToRecord() const
+    {
+        RunRecord record;
+        for (const auto& cost : m_costs)
+        {
+            RunRecord family;
+            family.Set("records", cost.records);
+            family.Set("bytes", cost.io.bytes);
+            family.Set("writes", cost.io.writes);
+            family.Set("sinkMs", cost.sinkNs / 1e6);
+            family.Set("formatMs", cost.FormatNs() / 1e6);
+            family.Set("ioMs", cost.io.ns / 1e6);
+            record.Set(cost.name, family);
+        }
+        return record;
+    }
+
+    /**
+     * @return the wall time spent in all the trace sinks, in ms
+     */
+    double GetTotalSinkMs() const
+    {
+        uint64_t ns = 0;
+        for (const auto& cost : m_costs)
+        {
+            ns += cost.sinkNs;
+        }
+        return ns / 1e6;
+    }
+
+  private:
+    /**
+     * @brief Charge the cost of a sink call to a family.
+     */
+    class Scope
+    {
+      public:
+        /**
+         * @brief Start timing a sink call.
+         * @param cost the family of the sink
+         */
+        explicit Scope(TraceFamilyCost& cost)
+            : m_cost(cost),
+              m_start(std::chrono::steady_clock::now())
+        {
+            m_cost.records++;
+            g_traceIoCost = &m_cost.io;
+        }
+
+        ~Scope()
+        {
+            g_traceIoCost = nullptr;
+            auto elapsed = std::chrono::steady_clock::now() - m_start;
+            m_cost.sinkNs += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        }
+
+      private:
+        TraceFamilyCost& m_cost;                       //!< Family being charged
+        std::chrono::steady_clock::time_point m_start; //!< Start of the call
+    };
+
+    /**
+     * @brief Print the cost of a family.
+     * @param cost the family
+     */
+    static void PrintLine(const TraceFamilyCost& cost)
+    {
+        printf("  %-22s %10lu records %9.2f MB %9lu writes %9.1f ms format %9.1f ms I/O "
+               "%7.2f us/record\n",
+               cost.name,
+               static_cast<unsigned long>(cost.records),
+               cost.io.bytes / 1e6,
+               static_cast<unsigned long>(cost.io.writes),
+               cost.FormatNs() / 1e6,
+               cost.io.ns / 1e6,
+               cost.records > 0 ? cost.sinkNs / 1e3 / cost.records : 0.0);
+    }
+
+    /**
+     * @brief Add a control message record to the fingerprint, if any.
+     * @param direction 0 for received, 1 for sent
+     * @param sfn frame, subframe and slot
+     * @param nodeId gNB node
+     * @param rnti UE
+     * @param bwpId bandwidth part
+     * @param msg the message
+     */
+    void AddCtrlMsg(uint8_t direction,
+                    const SfnSf& sfn,
+                    uint16_t nodeId,
+                    uint16_t rnti,
+                    uint8_t bwpId,
+                    const Ptr<const NrControlMessage>& msg)
+    {
+        if (RunFingerprint* fp = m_fingerprint)
+        {
+            fp->Add(direction);
+            fp->Add(sfn.GetEncoding());
+            fp->Add(nodeId);
+            fp->Add(rnti);
+            fp->Add(bwpId);
+            fp->Add(msg->GetMessageType());
+        }
+    }
+
+    /**
+     * @param phy a spectrum PHY
+     * @return the id of its node, or UINT32_MAX if it has none
+     */
+    static uint32_t NodeIdOf(const Ptr<const SpectrumPhy>& phy)
+    {
+        Ptr<NetDevice> device = phy ? phy->GetDevice() : nullptr;
+        return device && device->GetNode() ? device->GetNode()->GetId() : UINT32_MAX;
+    }
+
+    /// Timed DlDataSinr sink
+    static void DlDataSinr(TraceCostAccounting* self,
+                           std::string path,
+                           uint16_t cellId,
+                           uint16_t rnti,
+                           double avgSinr,
+                           uint16_t bwpId)
+    {
+        if (self->m_muted)
+        {
+            return;
+        }
+        if (RunFingerprint* fp = self->m_fingerprint)
+        {
+            fp->Add(Simulator::Now().GetTimeStep());
+            fp->Add(cellId);
+            fp->Add(rnti);
+            fp->Add(avgSinr);
+            fp->Add(bwpId);
+        }
+        Scope scope(self->m_costs[DL_DATA_PHY]);
+        NrPhyRxTrace::DlDataSinrCallback(self->m_phyStats, path, cellId, rnti, avgSinr, bwpId);
+    }
+
+    /// Timed DlScheduling sink
+    static void DlMacSched(TraceCostAccounting* self,
+                           std::string path,
+                           NrSchedulingCallbackInfo traceInfo)
+    {
+        if (self->m_muted)
+        {
+            return;
+        }
+        if (RunFingerprint* fp = self->m_fingerprint)
+        {
+            fp->Add(Simulator::Now().GetTimeStep());
+            fp->Add(traceInfo.m_frameNum);
+            fp->Add(traceInfo.m_subframeNum);
+            fp->Add(traceInfo.m_slotNum);
+            fp->Add(traceInfo.m_symStart);
+            fp->Add(traceInfo.m_numSym);
+            fp->Add(traceInfo.m_rnti);
+            fp->Add(traceInfo.m_bwpId);
+            fp->Add(traceInfo.m_harqId);
+            fp->Add(traceInfo.m_ndi);
+            fp->Add(traceInfo.m_rv);
+            fp->Add(traceInfo.m_mcs);
+            fp->Add(traceInfo.m_tbSize);
+        }
+        Scope scope(self->m_costs[DL_MAC_SCHED]);
+        NrMacRxTrace::DlMacSchedCallback(self->m_macStats, path, traceInfo);
+    }
+
+    /// Timed GnbMacRxedCtrlMsgsTrace sink
+    static void RxedGnbMacCtrlMsgs(TraceCostAccounting* self,
+                                   std::string path,
+                                   SfnSf sfn,
+                                   uint16_t nodeId,
+                                   uint16_t rnti,
+                                   uint8_t bwpId,
+                                   Ptr<const NrControlMessage> msg)
+    {
+        if (self->m_muted)
+        {
+            return;
+        }
+        self->AddCtrlMsg(0, sfn, nodeId, rnti, bwpId, msg);
+        Scope scope(self->m_costs[GNB_MAC_CTRL_MSGS]);
+        NrMacRxTrace::RxedGnbMacCtrlMsgsCallback(self->m_macStats,
+                                                 path,
+                                                 sfn,
+                                                 nodeId,
+                                                 rnti,
+                                                 bwpId,
+                                                 msg);
+    }
+
+    /// Timed GnbMacTxedCtrlMsgsTrace sink
+    static void TxedGnbMacCtrlMsgs(TraceCostAccounting* self,
+                                   std::string path,
+                                   SfnSf sfn,
+                                   uint16_t nodeId,
+                                   uint16_t rnti,
+                                   uint8_t bwpId,
+                                   Ptr<const NrControlMessage> msg)
+    {
+        if (self->m_muted)
+        {
+            return;
+        }
+        self->AddCtrlMsg(1, sfn, nodeId, rnti, bwpId, msg);
+        Scope scope(self->m_costs[GNB_MAC_CTRL_MSGS]);
+        NrMacRxTrace::TxedGnbMacCtrlMsgsCallback(self->m_macStats,
+                                                 path,
+                                                 sfn,
+                                                 nodeId,
+                                                 rnti,
+                                                 bwpId,
+                                                 msg);
+    }
+
+    /// Timed PathLoss sink
+    static void Pathloss(TraceCostAccounting* self,
+                         std::string path,
+                         Ptr<const SpectrumPhy> txPhy,
+                         Ptr<const SpectrumPhy> rxPhy,
+                         double lossDb)
+    {
+        if (self->m_muted)
+        {
+            return;
+        }
+        if (RunFingerprint* fp = self->m_fingerprint)
+        {
+            fp->Add(Simulator::Now().GetTimeStep());
+            fp->Add(NodeIdOf(txPhy));
+            fp->Add(NodeIdOf(rxPhy));
+            fp->Add(lossDb);
+        }
+        Scope scope(self->m_costs[PATHLOSS]);
+        NrPhyRxTrace::PathlossTraceCallback(self->m_phyStats, path, txPhy, rxPhy, lossDb);
+    }
+
+    Ptr<NrPhyRxTrace> m_phyStats;           //!< PHY trace writer
+    Ptr<NrMacRxTrace> m_macStats;           //!< MAC trace writer
+    RunFingerprint* m_fingerprint{nullptr}; //!< Fingerprint of the records, if any
+    bool m_muted{false};                    //!< Whether the sinks drop the records
+    TraceFamilyCost m_costs[NUM_FAMILIES]{{"DlDataPhyTraces"},
+                                          {"DlMacSchedTraces"},
+                                          {"GnbMacCtrlMsgsTraces"},
+                                          {"PathlossTraces"}}; //!< Cost per family
+};
+
+} // namespace ns3
+
+#if defined(__linux__) && defined(__GLIBC__)
+
+/**
+ * @brief write(2), charging the call to the running trace sink, if any.
+ */
+extern "C" ssize_t
+write(int fd, const void* buf, size_t count) noexcept
+{
+    ns3::TraceIoCost* cost = ns3::g_traceIoCost;
+    if (cost == nullptr)
+    {
+        return syscall(SYS_write, fd, buf, count);
+    }
+    auto start = std::chrono::steady_clock::now();
+    ssize_t written = syscall(SYS_write, fd, buf, count);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    cost->writes++;
+    cost->bytes += written > 0 ? written : 0;
+    cost->ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    return written;
+}
+
+/**
+ * @brief writev(2), charging the call to the running trace sink, if any.
+ */
+extern "C" ssize_t
+writev(int fd, const struct iovec* iov, int iovcnt) noexcept
+{
+    ns3::TraceIoCost* cost = ns3::g_traceIoCost;
+    if (cost == nullptr)
+    {
+        return syscall(SYS_writev, fd, iov, iovcnt);
+    }
+    auto start = std::chrono::steady_clock::now();
+    ssize_t written = syscall(SYS_writev, fd, iov, iovcnt);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    cost->writes++;
+    cost->bytes += written > 0 ? written : 0;
+    cost->ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    return written;
+}
+
+#endif
+
+#endif // TRACE_COST_ACCOUNTING_H
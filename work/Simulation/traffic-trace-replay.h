@@ -0,0 +1,333 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef TRAFFIC_TRACE_REPLAY_H
+#define TRAFFIC_TRACE_REPLAY_H
+
+#include "radio-traffic-injector.h"
+
+#include "ns3/abort.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/// One byte arrival of a traffic trace
+struct TrafficTraceRecord
+{
+    uint64_t timeNs; //!< Arrival time, in ns on the clock of the capture
+    uint32_t rnti;   //!< RNTI of the UE in the capture
+    uint32_t bytes;  //!< Bytes arriving
+};
+
+/// Records of one RNTI in a traffic trace
+struct TrafficTraceRange
+{
+    uint64_t first; //!< Index of its first record
+    uint64_t end;   //!< Index past its last record
+};
+
+/**
+ * @brief Read-only memory mapping of a binary traffic trace.
+ *
+ * The file, written by effnet_to_replay.py, is little-endian:
+ *
+ *     char     magic[8]      "NRREPLAY"
+ *     uint32   version       2
+ *     uint32   numRntis
+ *     uint64   numRecords
+ *     { uint32 rnti; uint32 reserved; uint64 firstRecord; uint64 numRecords; } [numRntis]
+ *     { uint64 timeNs; uint32 rnti; uint32 bytes; } [numRecords]
+ *
+ * The records of an RNTI are contiguous, by increasing time, at the position the table of the
+ * header gives. They are never copied: every reader streams the records of its RNTI from the
+ * mapping and hands the pages it has consumed back to the kernel, so captures much larger
+ * than memory replay with a resident set of a few pages per reader, whatever the RNTIs of
+ * the other readers.
+ */
+class MappedTrafficTrace : public SimpleRefCount<MappedTrafficTrace>
+{
+  public:
+    /**
+     * @brief Map a trace file; aborts if it cannot be opened or is not a trace.
+     * @param path trace file
+     */
+    explicit MappedTrafficTrace(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        NS_ABORT_MSG_IF(fd < 0, "Cannot open traffic trace " << path);
+        struct stat st{};
+        fstat(fd, &st);
+        m_size = static_cast<std::size_t>(st.st_size);
+        NS_ABORT_MSG_IF(m_size < HEADER_SIZE, "Traffic trace " << path << " is truncated");
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        NS_ABORT_MSG_IF(data == MAP_FAILED, "Cannot map traffic trace " << path);
+        m_data = static_cast<const uint8_t*>(data);
+        madvise(data, m_size, MADV_SEQUENTIAL);
+
+        NS_ABORT_MSG_IF(std::memcmp(m_data, MAGIC, sizeof(MAGIC)) != 0 || Read<uint32_t>(8) != 2,
+                        path << " is not a version 2 traffic trace, convert the capture again "
+                                "with effnet_to_replay.py");
+        uint32_t numRntis = Read<uint32_t>(12);
+        m_numRecords = Read<uint64_t>(16);
+        m_recordsOffset = HEADER_SIZE + static_cast<uint64_t>(numRntis) * RNTI_ENTRY_SIZE;
+        NS_ABORT_MSG_IF(m_recordsOffset + m_numRecords * RECORD_SIZE > m_size,
+                        "Traffic trace " << path << " is truncated");
+        m_startNs = UINT64_MAX;
+        for (uint32_t i = 0; i < numRntis; ++i)
+        {
+            uint64_t entry = HEADER_SIZE + i * RNTI_ENTRY_SIZE;
+            uint32_t rnti = Read<uint32_t>(entry);
+            uint64_t first = Read<uint64_t>(entry + 8);
+            uint64_t count = Read<uint64_t>(entry + 16);
+            NS_ABORT_MSG_IF(first > m_numRecords || count > m_numRecords - first,
+                            "Records of RNTI " << rnti << " out of traffic trace " << path);
+            m_rntiIndex.emplace(rnti, i);
+            m_rntis.push_back(rnti);
+            m_ranges.push_back({first, first + count});
+            if (count > 0)
+            {
+                m_startNs = std::min(m_startNs, GetRecord(first).timeNs);
+            }
+        }
+        if (m_startNs == UINT64_MAX)
+        {
+            m_startNs = 0;
+        }
+    }
+
+    ~MappedTrafficTrace()
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+
+    MappedTrafficTrace(const MappedTrafficTrace&) = delete;
+    MappedTrafficTrace& operator=(const MappedTrafficTrace&) = delete;
+
+    /**
+     * @return the number of records
+     */
+    uint64_t GetNumRecords() const
+    {
+        return m_numRecords;
+    }
+
+    /**
+     * @return the RNTIs of the capture, in the order of the header
+     */
+    const std::vector<uint32_t>& GetRntis() const
+    {
+        return m_rntis;
+    }
+
+    /**
+     * @param rnti an RNTI of the capture
+     * @return its position in GetRntis()
+     */
+    uint32_t GetRntiIndex(uint32_t rnti) const
+    {
+        auto it = m_rntiIndex.find(rnti);
+        NS_ABORT_MSG_IF(it == m_rntiIndex.end(), "RNTI " << rnti << " not in the trace header");
+        return it->second;
+    }
+
+    /**
+     * @param rntiIndex position of an RNTI in GetRntis()
+     * @return the records of the RNTI
+     */
+    TrafficTraceRange GetRange(uint32_t rntiIndex) const
+    {
+        return m_ranges.at(rntiIndex);
+    }
+
+    /**
+     * @return the time of the earliest record, the origin of the replay
+     */
+    uint64_t GetStartNs() const
+    {
+        return m_startNs;
+    }
+
+    /**
+     * @param index record index, below GetNumRecords()
+     * @return the record
+     */
+    TrafficTraceRecord GetRecord(uint64_t index) const
+    {
+        uint64_t offset = m_recordsOffset + index * RECORD_SIZE;
+        return {Read<uint64_t>(offset), Read<uint32_t>(offset + 8), Read<uint32_t>(offset + 12)};
+    }
+
+    /**
+     * @brief Hand the pages holding only records of a range back to the kernel.
+     * @param first first record no longer needed by the caller
+     * @param end record past the last one no longer needed
+     */
+    void Release(uint64_t first, uint64_t end) const
+    {
+        static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+        uint64_t begin = (m_recordsOffset + first * RECORD_SIZE + pageSize - 1) / pageSize;
+        uint64_t stop = (m_recordsOffset + end * RECORD_SIZE) / pageSize;
+        if (stop > begin)
+        {
+            // Read-only file mapping: dropped pages are faulted in again from the file if
+            // another reader still needs them
+            madvise(const_cast<uint8_t*>(m_data) + begin * pageSize,
+                    (stop - begin) * pageSize,
+                    MADV_DONTNEED);
+        }
+    }
+
+  private:
+    static constexpr char MAGIC[8] = {'N', 'R', 'R', 'E', 'P', 'L', 'A', 'Y'}; //!< File magic
+    static constexpr std::size_t HEADER_SIZE = 24;     //!< Bytes before the RNTI table
+    static constexpr std::size_t RNTI_ENTRY_SIZE = 24; //!< Bytes per RNTI of the table
+    static constexpr std::size_t RECORD_SIZE = 16;     //!< Bytes per record
+
+    /**
+     * @param offset byte offset in the file
+     * @return the little-endian value at that offset
+     */
+    template <typename T>
+    T Read(uint64_t offset) const
+    {
+        T value;
+        std::memcpy(&value, m_data + offset, sizeof(T));
+        return value;
+    }
+
+    const uint8_t* m_data{nullptr};                     //!< Mapping of the file
+    std::size_t m_size{0};                              //!< File size
+    uint64_t m_numRecords{0};                           //!< Records in the file
+    uint64_t m_recordsOffset{0};                        //!< Offset of the first record
+    uint64_t m_startNs{0};                              //!< Time of the earliest record
+    std::vector<uint32_t> m_rntis;                      //!< RNTIs of the header
+    std::vector<TrafficTraceRange> m_ranges;            //!< Records of every RNTI
+    std::unordered_map<uint32_t, uint32_t> m_rntiIndex; //!< RNTI to header position
+};
+
+/**
+ * @brief Arrivals of one RNTI of a traffic trace, replayed from the start of the source.
+ *
+ * Times are relative to the earliest record of the trace, so the RNTIs keep their relative
+ * timing; every record becomes one packet carrying its bytes as payload. The source reads the
+ * records of its RNTI with a cursor of its own and holds none of them: memory does not grow
+ * with the capture nor with the gaps between the arrivals of the RNTIs. The source is
+ * exhausted after the last record of its RNTI.
+ */
+class TraceReplaySource : public RadioTrafficSource
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::TraceReplaySource")
+                                .SetParent<RadioTrafficSource>()
+                                .SetGroupName("Applications")
+                                .AddConstructor<TraceReplaySource>();
+        return tid;
+    }
+
+    /**
+     * @brief Set the records to replay.
+     * @param trace the mapped trace, possibly shared with the sources of other UEs
+     * @param rntiIndex position of the RNTI in the header of the trace
+     */
+    void SetTrace(Ptr<const MappedTrafficTrace> trace, uint32_t rntiIndex)
+    {
+        m_trace = trace;
+        TrafficTraceRange range = trace->GetRange(rntiIndex);
+        m_cursor = range.first;
+        m_released = range.first;
+        m_end = range.end;
+    }
+
+    Time GetInitialDelay() override
+    {
+        NS_ABORT_MSG_IF(!m_trace, "TraceReplaySource needs a trace");
+        m_hasCurrent = Next();
+        return m_hasCurrent ? NanoSeconds(m_current.timeNs - m_trace->GetStartNs()) : Time(0);
+    }
+
+    Time GetNextInterArrival() override
+    {
+        uint64_t previousNs = m_current.timeNs;
+        m_hasCurrent = Next();
+        NS_ABORT_MSG_IF(m_hasCurrent && m_current.timeNs < previousNs,
+                        "Traffic trace records are not sorted by time at " << m_cursor - 1);
+        return m_hasCurrent ? NanoSeconds(m_current.timeNs - previousNs) : Time(0);
+    }
+
+    uint32_t GetNextPacketSize() override
+    {
+        return std::max<uint32_t>(1, m_current.bytes);
+    }
+
+    bool HasNextPacket() const override
+    {
+        return m_hasCurrent;
+    }
+
+    int64_t AssignStreams(int64_t /* stream */) override
+    {
+        return 0;
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_trace = nullptr;
+        RadioTrafficSource::DoDispose();
+    }
+
+  private:
+    static constexpr uint64_t RELEASE_RECORDS = 1 << 16; //!< Records (1 MiB) between releases
+
+    /**
+     * @brief Read the next record of the RNTI into m_current.
+     * @return false once the RNTI has no more records
+     */
+    bool Next()
+    {
+        if (m_cursor == m_end)
+        {
+            return false;
+        }
+        m_current = m_trace->GetRecord(m_cursor++);
+        if (m_cursor - m_released >= RELEASE_RECORDS)
+        {
+            m_trace->Release(m_released, m_cursor);
+            m_released = m_cursor;
+        }
+        return true;
+    }
+
+    Ptr<const MappedTrafficTrace> m_trace; //!< Mapped trace
+    uint64_t m_cursor{0};                  //!< Next record of the RNTI
+    uint64_t m_end{0};                     //!< Record past the last one of the RNTI
+    uint64_t m_released{0};                //!< Records of the RNTI handed back
+    TrafficTraceRecord m_current{};        //!< Record of the next packet
+    bool m_hasCurrent{false};              //!< Whether m_current is valid
+};
+
+NS_OBJECT_ENSURE_REGISTERED(TraceReplaySource);
+
+} // namespace ns3
+
+#endif // TRAFFIC_TRACE_REPLAY_H